@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _ABSTRACTBUFFEREDFILTERMAFITERATOR_H_
+#define _ABSTRACTBUFFEREDFILTERMAFITERATOR_H_
+
+#include "AbstractMafIterator.h"
+#include "MafBlockBuffer.h"
+
+// From the STL:
+#include <string>
+#include <memory>
+
+namespace bpp
+{
+/**
+ * @brief Partial implementation of filters producing several blocks per input block.
+ *
+ * Output blocks are stored in a buffer until they are requested. Filters which can also output removed regions
+ * store them in a second, trash buffer. Both buffers can be given a memory budget, see setBufferMemoryLimit().
+ */
+class AbstractBufferedFilterMafIterator :
+  public AbstractFilterMafIterator
+{
+protected:
+  MafBlockBuffer blockBuffer_;
+  MafBlockBuffer trashBuffer_;
+
+public:
+  AbstractBufferedFilterMafIterator(std::shared_ptr<MafIteratorInterface> iterator) :
+    AbstractFilterMafIterator(iterator),
+    blockBuffer_(),
+    trashBuffer_()
+  {}
+
+public:
+  /**
+   * @brief Set a memory budget for the output and trash buffers.
+   *
+   * Blocks exceeding the budget are temporarily written to disk, see MafBlockBuffer.
+   *
+   * @param maxMemoryUsage Maximum memory, in bytes, used by each buffer.
+   * @param spillDirectory Directory for temporary files (system default if empty).
+   */
+  void setBufferMemoryLimit(size_t maxMemoryUsage, const std::string& spillDirectory = "")
+  {
+    blockBuffer_.setMaxMemoryUsage(maxMemoryUsage, spillDirectory);
+    trashBuffer_.setMaxMemoryUsage(maxMemoryUsage, spillDirectory);
+  }
+};
+} // end of namespace bpp.
+
+#endif // _ABSTRACTBUFFEREDFILTERMAFITERATOR_H_
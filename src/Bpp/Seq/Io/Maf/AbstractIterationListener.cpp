@@ -42,3 +42,166 @@ void CsvStatisticsOutputIterationListener::iterationMoves(const MafBlock& curren
   }
   output_->endLine();
 }
+
+void CsvStatisticsOutputIterationListener::saveState(ostream& out)
+{
+  if (!stream_)
+    throw Exception("CsvStatisticsOutputIterationListener::saveState. Checkpoints require the output to be given as a standard stream.");
+  AbstractMafIterator::saveOutputPosition_(out, stream_.get());
+}
+
+void CsvStatisticsOutputIterationListener::restoreState(istream& in)
+{
+  if (!stream_)
+    throw Exception("CsvStatisticsOutputIterationListener::restoreState. Checkpoints require the output to be given as a standard stream.");
+  AbstractMafIterator::restoreOutputPosition_(in, stream_.get());
+}
+
+void ColumnarStatisticsOutputIterationListener::iterationStarts()
+{
+  createWriter_();
+}
+
+void ColumnarStatisticsOutputIterationListener::createWriter_()
+{
+  vector<string> names = {"Chr", "Start", "Stop"};
+  vector<ColumnarStatisticsFormat::ColumnType> types = {ColumnarStatisticsFormat::STRING, ColumnarStatisticsFormat::INTEGER, ColumnarStatisticsFormat::INTEGER};
+  for (const auto& name : statsIterator_->getResultsColumnNames())
+  {
+    names.push_back(name);
+    types.push_back(ColumnarStatisticsFormat::DOUBLE);
+  }
+  writer_.reset(new ColumnarStatisticsWriter(output_, names, types, rowGroupSize_, encoded_));
+}
+
+void ColumnarStatisticsOutputIterationListener::iterationMoves(const MafBlock& currentBlock)
+{
+  if (currentBlock.hasSequenceForSpecies(refSpecies_))
+  {
+    const auto& refSeq = currentBlock.sequenceForSpecies(refSpecies_);
+    if (refSeq.hasCoordinates())
+    {
+      writer_->setString(0, refSeq.getChromosome());
+      writer_->setInteger(1, static_cast<int64_t>(refSeq.start()));
+      writer_->setInteger(2, static_cast<int64_t>(refSeq.stop()));
+    }
+  }
+  auto& values = statsIterator_->getResults();
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    if (!values[i])
+      continue;
+    if (auto x = dynamic_cast<const BppDouble*>(values[i]))
+      writer_->setDouble(i + 3, x->getValue());
+    else if (auto n = dynamic_cast<const BppInteger*>(values[i]))
+      writer_->setDouble(i + 3, static_cast<double>(n->getValue()));
+    else if (auto u = dynamic_cast<const BppUnsignedInteger*>(values[i]))
+      writer_->setDouble(i + 3, static_cast<double>(u->getValue()));
+  }
+  writer_->endRow();
+}
+
+void ColumnarStatisticsOutputIterationListener::iterationStops()
+{
+  if (writer_)
+    writer_->close();
+  writer_.reset();
+}
+
+void ColumnarStatisticsOutputIterationListener::saveState(ostream& out)
+{
+  if (!writer_)
+    throw Exception("ColumnarStatisticsOutputIterationListener::saveState. Iterations have not started.");
+  writer_->saveState(out);
+}
+
+void ColumnarStatisticsOutputIterationListener::restoreState(istream& in)
+{
+  createWriter_();
+  writer_->restoreState(in);
+}
+
+void StatisticsAccumulationIterationListener::checkResultCache_() const
+{
+  if (!statsIterator_->getResultCache())
+    return;
+  for (const auto& stat : statsIterator_->getStatistics())
+  {
+    if (dynamic_cast<MafStatisticsAccumulatorInterface*>(stat.get()))
+      throw Exception("StatisticsAccumulationIterationListener. Statistic " + stat->getShortName() + " cannot be accumulated over results read from the result cache. Disable the cache to compute genome-wide statistics.");
+  }
+}
+
+void StatisticsAccumulationIterationListener::iterationStarts()
+{
+  checkResultCache_();
+  for (const auto& stat : statsIterator_->getStatistics())
+  {
+    auto accumulator = dynamic_cast<MafStatisticsAccumulatorInterface*>(stat.get());
+    if (accumulator)
+      accumulator->resetAccumulator();
+  }
+}
+
+void StatisticsAccumulationIterationListener::iterationMoves(const MafBlock& currentBlock)
+{
+  for (const auto& stat : statsIterator_->getStatistics())
+  {
+    auto accumulator = dynamic_cast<MafStatisticsAccumulatorInterface*>(stat.get());
+    if (accumulator)
+      accumulator->accumulate();
+  }
+}
+
+void StatisticsAccumulationIterationListener::saveState(ostream& out)
+{
+  for (const auto& stat : statsIterator_->getStatistics())
+  {
+    auto accumulator = dynamic_cast<MafStatisticsAccumulatorInterface*>(stat.get());
+    if (accumulator)
+      accumulator->saveAccumulator(out);
+  }
+}
+
+void StatisticsAccumulationIterationListener::restoreState(istream& in)
+{
+  checkResultCache_();
+  for (const auto& stat : statsIterator_->getStatistics())
+  {
+    auto accumulator = dynamic_cast<MafStatisticsAccumulatorInterface*>(stat.get());
+    if (accumulator)
+      accumulator->restoreAccumulator(in);
+  }
+}
+
+void StatisticsAccumulationIterationListener::iterationStops()
+{
+  vector<string> header;
+  vector<string> values;
+  for (const auto& stat : statsIterator_->getStatistics())
+  {
+    auto accumulator = dynamic_cast<MafStatisticsAccumulatorInterface*>(stat.get());
+    if (!accumulator)
+      continue;
+    accumulator->finalize();
+    const MafStatisticsResult& result = accumulator->getAccumulatedResult();
+    vector<string> tags = stat->getSupportedTags();
+    for (const auto& tag : tags)
+    {
+      header.push_back(tags.size() > 1 ? stat->getShortName() + "." + tag : stat->getShortName());
+      values.push_back(result.hasValue(tag) ? result.getValue(tag).toString() : "NA");
+    }
+  }
+  if (!output_)
+    return;
+  for (size_t i = 0; i < header.size(); ++i)
+  {
+    *output_ << (i > 0 ? sep_ : "") << header[i];
+  }
+  output_->endLine();
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    *output_ << (i > 0 ? sep_ : "") << values[i];
+  }
+  output_->endLine();
+}
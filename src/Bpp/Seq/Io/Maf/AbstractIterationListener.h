@@ -7,6 +7,10 @@
 
 #include "MafIterator.h"
 #include "SequenceStatisticsMafIterator.h"
+#include "ColumnarStatisticsFile.h"
+
+// From bpp-core:
+#include <Bpp/Io/OutputStream.h>
 
 namespace bpp
 {
@@ -40,12 +44,16 @@ public:
 /**
  * @brief Iteration listener that works with a SequenceStatisticsMafIterator,
  * enabling output of results in a file in CSV format
+ *
+ * Checkpoints are only supported when the output is given as a standard stream,
+ * which is then repositioned upon restoration (see AbstractMafIterator::saveOutputPosition_).
  */
 class CsvStatisticsOutputIterationListener :
   public AbstractStatisticsOutputIterationListener
 {
 private:
   std::shared_ptr<OutputStream> output_;
+  std::shared_ptr<std::ostream> stream_;
   std::string sep_;
   std::string refSpecies_;
 
@@ -55,15 +63,23 @@ public:
       const std::string& refSpecies,
       std::shared_ptr<OutputStream> output,
       const std::string& sep = "\t") :
-    AbstractStatisticsOutputIterationListener(iterator), output_(output), sep_(sep), refSpecies_(refSpecies) {}
+    AbstractStatisticsOutputIterationListener(iterator), output_(output), stream_(), sep_(sep), refSpecies_(refSpecies) {}
+
+  CsvStatisticsOutputIterationListener(
+      std::shared_ptr<SequenceStatisticsMafIterator> iterator,
+      const std::string& refSpecies,
+      std::shared_ptr<std::ostream> output,
+      const std::string& sep = "\t") :
+    AbstractStatisticsOutputIterationListener(iterator), output_(std::make_shared<StlOutputStreamWrapper>(output.get())), stream_(output), sep_(sep), refSpecies_(refSpecies) {}
 
   CsvStatisticsOutputIterationListener(const CsvStatisticsOutputIterationListener& listener) :
-    AbstractStatisticsOutputIterationListener(listener), output_(listener.output_), sep_(listener.sep_), refSpecies_(listener.refSpecies_) {}
+    AbstractStatisticsOutputIterationListener(listener), output_(listener.output_), stream_(listener.stream_), sep_(listener.sep_), refSpecies_(listener.refSpecies_) {}
 
   CsvStatisticsOutputIterationListener& operator=(const CsvStatisticsOutputIterationListener& listener)
   {
     AbstractStatisticsOutputIterationListener::operator=(listener);
     output_ = listener.output_;
+    stream_ = listener.stream_;
     sep_ = listener.sep_;
     refSpecies_ = listener.refSpecies_;
     return *this;
@@ -75,6 +91,146 @@ public:
   virtual void iterationStarts();
   virtual void iterationMoves(const MafBlock& currentBlock);
   virtual void iterationStops() {}
+  virtual void saveState(std::ostream& out);
+  virtual void restoreState(std::istream& in);
+};
+
+/**
+ * @brief Iteration listener that works with a SequenceStatisticsMafIterator,
+ * enabling output of results in a binary columnar format.
+ *
+ * The columns are the same as with CsvStatisticsOutputIterationListener: the chromosome (string), start and stop
+ * (integers) of the reference sequence, then one column per statistic value, stored as double precision numbers.
+ * Values are not formatted, and the file can be read back one row group at a time with ColumnarStatisticsReader,
+ * see ColumnarStatisticsFormat for a description of the layout.
+ * When a checkpoint is saved, buffered rows are written as a row group (see ColumnarStatisticsWriter::saveState()).
+ */
+class ColumnarStatisticsOutputIterationListener :
+  public AbstractStatisticsOutputIterationListener
+{
+private:
+  std::shared_ptr<std::ostream> output_;
+  std::string refSpecies_;
+  size_t rowGroupSize_;
+  bool encoded_;
+  std::unique_ptr<ColumnarStatisticsWriter> writer_;
+
+public:
+  /**
+   * @param iterator The statistics iterator to listen to.
+   * @param refSpecies The species giving the coordinates of each block.
+   * @param output The binary stream where to write the results.
+   * @param rowGroupSize The number of blocks in each row group.
+   * @param encoded Tell if columns should be encoded, see ColumnarStatisticsFormat.
+   */
+  ColumnarStatisticsOutputIterationListener(
+      std::shared_ptr<SequenceStatisticsMafIterator> iterator,
+      const std::string& refSpecies,
+      std::shared_ptr<std::ostream> output,
+      size_t rowGroupSize = 65536,
+      bool encoded = true) :
+    AbstractStatisticsOutputIterationListener(iterator),
+    output_(output),
+    refSpecies_(refSpecies),
+    rowGroupSize_(rowGroupSize),
+    encoded_(encoded),
+    writer_()
+  {}
+
+  ColumnarStatisticsOutputIterationListener(const ColumnarStatisticsOutputIterationListener& listener) :
+    AbstractStatisticsOutputIterationListener(listener),
+    output_(listener.output_),
+    refSpecies_(listener.refSpecies_),
+    rowGroupSize_(listener.rowGroupSize_),
+    encoded_(listener.encoded_),
+    writer_()
+  {}
+
+  ColumnarStatisticsOutputIterationListener& operator=(const ColumnarStatisticsOutputIterationListener& listener)
+  {
+    AbstractStatisticsOutputIterationListener::operator=(listener);
+    output_       = listener.output_;
+    refSpecies_   = listener.refSpecies_;
+    rowGroupSize_ = listener.rowGroupSize_;
+    encoded_      = listener.encoded_;
+    writer_.reset();
+    return *this;
+  }
+
+  virtual ~ColumnarStatisticsOutputIterationListener() {}
+
+public:
+  virtual void iterationStarts();
+  virtual void iterationMoves(const MafBlock& currentBlock);
+  virtual void iterationStops();
+  virtual void saveState(std::ostream& out);
+  virtual void restoreState(std::istream& in);
+
+private:
+  void createWriter_();
+};
+/**
+ * @brief Iteration listener that accumulates genome-wide statistics over all blocks of a SequenceStatisticsMafIterator.
+ *
+ * Only statistics implementing MafStatisticsAccumulatorInterface are considered. Their totals are reset when iterations start,
+ * updated after each block, and finalized when iterations stop. Genome-wide results are then available from each statistic
+ * (see MafStatisticsAccumulatorInterface::getAccumulatedResult()), and are optionally written to a stream,
+ * as a header line followed by a line of values.
+ *
+ * As cached results cannot be accumulated, the statistics iterator should not use a result cache
+ * (see SequenceStatisticsMafIterator::setResultCache()), which is checked when iterations start.
+ *
+ * Totals are part of checkpoints (see MafStatisticsAccumulatorInterface::saveAccumulator()), so that accumulation can be resumed.
+ *
+ * When a pipeline is run on several shards, each shard accumulates its own statistics. Totals can then be combined with
+ * MafStatisticsAccumulatorInterface::merge() and finalized again, without going through per-block results.
+ */
+class StatisticsAccumulationIterationListener :
+  public AbstractStatisticsOutputIterationListener
+{
+private:
+  std::shared_ptr<OutputStream> output_;
+  std::string sep_;
+
+public:
+  /**
+   * @param iterator The statistics iterator to listen to.
+   * @param output The stream where genome-wide results are written (none if null).
+   * @param sep The column separator.
+   */
+  StatisticsAccumulationIterationListener(
+      std::shared_ptr<SequenceStatisticsMafIterator> iterator,
+      std::shared_ptr<OutputStream> output = nullptr,
+      const std::string& sep = "\t") :
+    AbstractStatisticsOutputIterationListener(iterator), output_(output), sep_(sep) {}
+
+  StatisticsAccumulationIterationListener(const StatisticsAccumulationIterationListener& listener) :
+    AbstractStatisticsOutputIterationListener(listener), output_(listener.output_), sep_(listener.sep_) {}
+
+  StatisticsAccumulationIterationListener& operator=(const StatisticsAccumulationIterationListener& listener)
+  {
+    AbstractStatisticsOutputIterationListener::operator=(listener);
+    output_ = listener.output_;
+    sep_ = listener.sep_;
+    return *this;
+  }
+
+  virtual ~StatisticsAccumulationIterationListener() {}
+
+public:
+  virtual void iterationStarts();
+  virtual void iterationMoves(const MafBlock& currentBlock);
+  virtual void iterationStops();
+  virtual void saveState(std::ostream& out);
+  virtual void restoreState(std::istream& in);
+
+private:
+  /**
+   * @brief Check, before any block is processed, that accumulated statistics are not read from the result cache.
+   *
+   * @throw Exception If a result cache is used together with accumulated statistics.
+   */
+  void checkResultCache_() const;
 };
 } // end of namespace bpp.
 
@@ -3,12 +3,14 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "AbstractMafIterator.h"
+#include "MafBlockSerializer.h"
 
 using namespace bpp;
 
 // From the STL:
 #include <string>
 #include <numeric>
+#include <typeinfo>
 
 using namespace std;
 
@@ -35,3 +37,57 @@ void AbstractMafIterator::fireIterationStopSignal_()
     it->iterationStops();
   }
 }
+
+void AbstractMafIterator::saveCheckpoint(ostream& out)
+{
+  // Each iterator is tagged with its type, in order to detect mismatching pipelines upon restoration:
+  MafBlockSerializer::writeString(out, typeid(*this).name());
+  saveState_(out);
+  // Listeners are saved in the order in which they were added:
+  MafBlockSerializer::writeSize(out, iterationListeners_.size());
+  for (auto& it : iterationListeners_)
+  {
+    it->saveState(out);
+  }
+  if (!out)
+    throw IOException("AbstractMafIterator::saveCheckpoint. Error while writing checkpoint.");
+}
+
+void AbstractMafIterator::restoreCheckpoint(istream& in)
+{
+  string type = MafBlockSerializer::readString(in);
+  if (type != typeid(*this).name())
+    throw Exception("AbstractMafIterator::restoreCheckpoint. Checkpoint does not match the pipeline: found " + type + " instead of " + typeid(*this).name() + ".");
+  restoreState_(in);
+  size_t nbListeners = MafBlockSerializer::readSize(in);
+  if (nbListeners != iterationListeners_.size())
+    throw Exception("AbstractMafIterator::restoreCheckpoint. Checkpoint does not match the pipeline: found " + TextTools::toString(nbListeners) + " iteration listener(s) instead of " + TextTools::toString(iterationListeners_.size()) + ".");
+  for (auto& it : iterationListeners_)
+  {
+    it->restoreState(in);
+  }
+  started_ = true;
+}
+
+void AbstractMafIterator::saveOutputPosition_(ostream& out, ostream* output)
+{
+  // Positions are shifted by one, zero meaning that no position is available:
+  streamoff pos = -1;
+  if (output)
+  {
+    output->flush();
+    pos = output->tellp();
+  }
+  MafBlockSerializer::writeSize(out, pos < 0 ? 0 : static_cast<size_t>(pos) + 1);
+}
+
+void AbstractMafIterator::restoreOutputPosition_(istream& in, ostream* output)
+{
+  size_t pos = MafBlockSerializer::readSize(in);
+  if (output && pos > 0)
+  {
+    output->seekp(static_cast<streamoff>(pos - 1));
+    if (!*output)
+      throw IOException("AbstractMafIterator::restoreOutputPosition_. Output stream could not be repositioned.");
+  }
+}
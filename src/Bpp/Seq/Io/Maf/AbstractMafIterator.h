@@ -27,12 +27,14 @@ protected:
   std::vector<std::unique_ptr<IterationListenerInterface>> iterationListeners_;
   bool started_;
   bool verbose_;
+  std::shared_ptr<MafProgressMonitor> progress_;
 
 public:
   AbstractMafIterator() :
     iterationListeners_(),
     started_(false),
-    verbose_(true)
+    verbose_(true),
+    progress_()
   {}
 
   virtual ~AbstractMafIterator() {}
@@ -41,7 +43,8 @@ protected:
   AbstractMafIterator(const AbstractMafIterator& it) :
     iterationListeners_(),
     started_(false),
-    verbose_(it.verbose_)
+    verbose_(it.verbose_),
+    progress_(it.progress_)
   {}
 
   AbstractMafIterator& operator=(const AbstractMafIterator& it)
@@ -49,6 +52,7 @@ protected:
     iterationListeners_.clear();
     started_ = false;
     verbose_ = it.verbose_;
+    progress_ = it.progress_;
     return *this;
   }
 
@@ -76,11 +80,36 @@ public:
   bool isVerbose() const { return verbose_; }
   void setVerbose(bool yn) { verbose_ = yn; }
 
+  void saveCheckpoint(std::ostream& out);
+  void restoreCheckpoint(std::istream& in);
+
+  void setProgressMonitor(std::shared_ptr<MafProgressMonitor> monitor) { progress_ = monitor; }
+
+  /**
+   * @brief Store the current position of an output stream in a checkpoint.
+   *
+   * Upon restoration the output stream is repositioned at the same place, so that its content is
+   * regenerated from the checkpoint. This requires the output file to be opened for update
+   * (std::ios::in | std::ios::out) rather than truncated. Streams that cannot be positioned are only flushed.
+   * A null output stream is accepted and ignored. These functions are also used by iteration listeners.
+   */
+  static void saveOutputPosition_(std::ostream& out, std::ostream* output);
+  static void restoreOutputPosition_(std::istream& in, std::ostream* output);
+
 protected:
   virtual std::unique_ptr<MafBlock> analyseCurrentBlock_() = 0;
   virtual void fireIterationStartSignal_();
   virtual void fireIterationMoveSignal_(const MafBlock& currentBlock);
   virtual void fireIterationStopSignal_();
+
+  /**
+   * @brief Save and restore the state specific to this iterator.
+   *
+   * The default implementation does nothing, stateful iterators have to override both functions.
+   * See MafBlockSerializer for functions to write and read basic data.
+   */
+  virtual void saveState_(std::ostream& out) {}
+  virtual void restoreState_(std::istream& in) {}
 };
 
 
@@ -118,6 +147,24 @@ private:
 
 public:
   void setLogStream(std::shared_ptr<OutputStream> logstream) { logstream_ = logstream; }
+
+  void saveCheckpoint(std::ostream& out)
+  {
+    iterator_->saveCheckpoint(out);
+    AbstractMafIterator::saveCheckpoint(out);
+  }
+
+  void restoreCheckpoint(std::istream& in)
+  {
+    iterator_->restoreCheckpoint(in);
+    AbstractMafIterator::restoreCheckpoint(in);
+  }
+
+  void setProgressMonitor(std::shared_ptr<MafProgressMonitor> monitor)
+  {
+    iterator_->setProgressMonitor(monitor);
+    AbstractMafIterator::setProgressMonitor(monitor);
+  }
 };
 
 
@@ -141,6 +188,32 @@ private:
     return *this;
   }
 
+public:
+  // The state is the one of the filter, which is saved only if it is also a regular iterator.
+  void saveCheckpoint(std::ostream& out)
+  {
+    auto it = std::dynamic_pointer_cast<MafIteratorInterface>(iterator_);
+    if (it)
+      it->saveCheckpoint(out);
+    AbstractMafIterator::saveCheckpoint(out);
+  }
+
+  void restoreCheckpoint(std::istream& in)
+  {
+    auto it = std::dynamic_pointer_cast<MafIteratorInterface>(iterator_);
+    if (it)
+      it->restoreCheckpoint(in);
+    AbstractMafIterator::restoreCheckpoint(in);
+  }
+
+  void setProgressMonitor(std::shared_ptr<MafProgressMonitor> monitor)
+  {
+    auto it = std::dynamic_pointer_cast<MafIteratorInterface>(iterator_);
+    if (it)
+      it->setProgressMonitor(monitor);
+    AbstractMafIterator::setProgressMonitor(monitor);
+  }
+
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_()
   {
@@ -182,6 +255,25 @@ private:
     return *this;
   }
 
+public:
+  void saveCheckpoint(std::ostream& out)
+  {
+    AbstractFilterMafIterator::saveCheckpoint(out);
+    secondaryIterator_->saveCheckpoint(out);
+  }
+
+  void restoreCheckpoint(std::istream& in)
+  {
+    AbstractFilterMafIterator::restoreCheckpoint(in);
+    secondaryIterator_->restoreCheckpoint(in);
+  }
+
+  void setProgressMonitor(std::shared_ptr<MafProgressMonitor> monitor)
+  {
+    AbstractFilterMafIterator::setProgressMonitor(monitor);
+    secondaryIterator_->setProgressMonitor(monitor);
+  }
+
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_()
   {
@@ -0,0 +1,196 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "AbstractWindowFilterMafIterator.h"
+
+using namespace bpp;
+
+// From the STL:
+#include <string>
+#include <numeric>
+
+using namespace std;
+
+unique_ptr<MafBlock> AbstractWindowFilterMafIterator::analyseCurrentBlock_()
+{
+  while (blockBuffer_.size() == 0)
+  {
+    // There is no more block in the buffer, we need to parse more:
+    auto block = iterator_->nextBlock();
+    if (!block)
+      return nullptr; // No more block.
+
+    if (!computeColumnScores_(*block, columnScores_))
+    {
+      blockBuffer_.push_back(std::move(block));
+      continue;
+    }
+    size_t nc = static_cast<size_t>(block->getNumberOfSites());
+    if (nc < windowSize_)
+      throw Exception("AbstractWindowFilterMafIterator::analyseCurrentBlock_. Block is smaller than window size: " + TextTools::toString(nc));
+    for (const auto& scores : columnScores_)
+    {
+      if (scores.size() != nc)
+        throw Exception("AbstractWindowFilterMafIterator::analyseCurrentBlock_. Column scores do not match the size of the block.");
+    }
+
+    vector<size_t> pos;
+    if (verbose_)
+    {
+      ApplicationTools::message->endLine();
+      ApplicationTools::displayTask(taskName_, true);
+    }
+    computeRegions_(nc, pos);
+    if (verbose_)
+      ApplicationTools::displayTaskDone();
+
+    splitBlock_(std::move(block), pos);
+  }
+
+  auto block = std::move(blockBuffer_.front());
+  blockBuffer_.pop_front();
+  return block;
+}
+
+void AbstractWindowFilterMafIterator::computeRegions_(size_t nc, vector<size_t>& pos)
+{
+  size_t nbScores = columnScores_.size();
+  vector<double> sums(nbScores, 0.);
+  auto sumWindow = [&](size_t end)
+  {
+    for (size_t s = 0; s < nbScores; ++s)
+    {
+      auto first = columnScores_[s].begin() + static_cast<ptrdiff_t>(end - windowSize_);
+      sums[s] = accumulate(first, first + static_cast<ptrdiff_t>(windowSize_), 0.);
+    }
+  };
+  auto evaluateWindow = [&](size_t end)
+  {
+    size_t begin = end - windowSize_;
+    if (!isWindowRemoved_(sums, begin, end))
+      return;
+    if (pos.size() > 0 && begin <= pos.back())
+      pos.back() = end; // Windows are overlapping and we extend previous region
+    else // This is a new region
+    {
+      pos.push_back(begin);
+      pos.push_back(end);
+    }
+  };
+
+  // Init window:
+  size_t i = windowSize_;
+  sumWindow(i);
+  // Slide window:
+  while (i + step_ < nc)
+  {
+    if (progress_)
+      progress_->addSites(step_);
+    evaluateWindow(i);
+    // Move forward:
+    for (size_t k = 0; k < step_; ++k)
+    {
+      for (size_t s = 0; s < nbScores; ++s)
+      {
+        sums[s] += columnScores_[s][i] - columnScores_[s][i - windowSize_];
+      }
+      ++i;
+      // Sum again once in a while, so that rounding errors do not accumulate:
+      if (i % windowSize_ == 0)
+        sumWindow(i);
+    }
+  }
+  // Evaluate last window:
+  evaluateWindow(i);
+}
+
+void AbstractWindowFilterMafIterator::splitBlock_(unique_ptr<MafBlock> block, const vector<size_t>& pos)
+{
+  size_t nc = static_cast<size_t>(block->getNumberOfSites());
+  if (pos.size() == 0)
+  {
+    if (logstream_)
+    {
+      (*logstream_ << logPrefix_ << ": block " << block->getDescription() << " is clean and kept as is.").endLine();
+    }
+    blockBuffer_.push_back(std::move(block));
+    return;
+  }
+  if (pos.size() == 2 && pos.front() == 0 && pos.back() == nc)
+  {
+    // Everything is removed:
+    if (logstream_)
+    {
+      (*logstream_ << logPrefix_ << ": block " << block->getDescription() << " was entirely removed. Tried to get the next one.").endLine();
+    }
+    return;
+  }
+
+  if (annotateOnly_)
+  {
+    if (logstream_)
+    {
+      (*logstream_ << logPrefix_ << ": masking " << (pos.size() / 2) << " region(s) in block " << block->getDescription() << ".").endLine();
+    }
+    MafColumnMask::excludeRegions(*block, pos);
+    blockBuffer_.push_back(std::move(block));
+    return;
+  }
+
+  if (logstream_)
+  {
+    (*logstream_ << logPrefix_ << ": block " << block->getDescription() << " with size " << nc << " will be split into " << (pos.size() / 2 + 1) << " blocks.").endLine();
+  }
+  if (verbose_)
+  {
+    ApplicationTools::message->endLine();
+    ApplicationTools::displayTask("Splitting block", true);
+  }
+  size_t previous = 0; // End of the previous removed region.
+  for (size_t i = 0; i < pos.size(); i += 2)
+  {
+    if (verbose_)
+      ApplicationTools::displayGauge(i, pos.size() - 2, '=');
+    if (logstream_)
+    {
+      (*logstream_ << logPrefix_ << ": removing region (" << pos[i] << ", " << pos[i + 1] << ") from block " << block->getDescription() << ".").endLine();
+    }
+    if (pos[i] > previous)
+      blockBuffer_.push_back(extractRegion(*block, previous, pos[i]));
+    if (keepTrashedBlocks_)
+      trashBuffer_.push_back(extractRegion(*block, pos[i], pos[i + 1]));
+    previous = pos[i + 1];
+  }
+  // Add last block:
+  if (previous < nc)
+    blockBuffer_.push_back(extractRegion(*block, previous, nc));
+  if (verbose_)
+    ApplicationTools::displayTaskDone();
+}
+
+unique_ptr<MafBlock> AbstractWindowFilterMafIterator::extractRegion(const MafBlock& block, size_t begin, size_t end)
+{
+  auto newBlock = make_unique<MafBlock>();
+  newBlock->setScore(block.getScore());
+  newBlock->setPass(block.getPass());
+  for (size_t j = 0; j < block.getNumberOfSequences(); ++j)
+  {
+    auto subseq = block.sequence(j).subSequence(begin, end - begin);
+    newBlock->addSequence(subseq);
+  }
+  MafColumnMask::setSubMask(*newBlock, block, begin, end);
+  return newBlock;
+}
+
+void AbstractWindowFilterMafIterator::saveState_(ostream& out)
+{
+  blockBuffer_.save(out);
+  trashBuffer_.save(out);
+}
+
+void AbstractWindowFilterMafIterator::restoreState_(istream& in)
+{
+  blockBuffer_.restore(in);
+  trashBuffer_.restore(in);
+}
@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _ABSTRACTWINDOWFILTERMAFITERATOR_H_
+#define _ABSTRACTWINDOWFILTERMAFITERATOR_H_
+
+#include "AbstractBufferedFilterMafIterator.h"
+#include "MafColumnMask.h"
+
+// From the STL:
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bpp
+{
+/**
+ * @brief Partial implementation of filters removing regions of blocks using a sliding window.
+ *
+ * For each block, derived classes compute one or several per-column scores (for instance the number of gaps
+ * or the entropy of each column), and decide whether a window should be removed given the sum of these scores.
+ * Window sums are updated incrementally as the window slides, so that each step only costs the number of columns
+ * entering and leaving the window.
+ *
+ * Removed windows that overlap or touch each other are merged into regions, which are then used to split the block.
+ * Kept regions are sent to the output, and removed regions to the trash if requested.
+ * In "annotate only" mode, blocks are not split: removed regions are recorded in a MafColumnMask property
+ * of the block, which is sent as a whole to the output, and nothing is sent to the trash.
+ */
+class AbstractWindowFilterMafIterator :
+  public AbstractBufferedFilterMafIterator,
+  public virtual MafTrashIteratorInterface
+{
+protected:
+  unsigned int windowSize_;
+  unsigned int step_;
+  bool keepTrashedBlocks_;
+  bool annotateOnly_;
+
+private:
+  std::string logPrefix_;
+  std::string taskName_;
+  std::vector<std::vector<double>> columnScores_;
+
+public:
+  /**
+   * @param iterator Input iterator.
+   * @param windowSize Size of the sliding window (nt).
+   * @param step Step by which windows are moved (nt).
+   * @param keepTrashedBlocks Removed regions are kept as separate blocks.
+   * @param logPrefix Prefix of log messages, for instance "MASK CLEANER".
+   * @param taskName Description of the sliding window step, displayed in verbose mode.
+   */
+  AbstractWindowFilterMafIterator(
+      std::shared_ptr<MafIteratorInterface> iterator,
+      unsigned int windowSize,
+      unsigned int step,
+      bool keepTrashedBlocks,
+      const std::string& logPrefix,
+      const std::string& taskName) :
+    AbstractBufferedFilterMafIterator(iterator),
+    windowSize_(windowSize),
+    step_(step),
+    keepTrashedBlocks_(keepTrashedBlocks),
+    annotateOnly_(false),
+    logPrefix_(logPrefix),
+    taskName_(taskName),
+    columnScores_()
+  {
+    if (windowSize == 0)
+      throw Exception("AbstractWindowFilterMafIterator. Window size should be at least 1.");
+    if (step == 0)
+      throw Exception("AbstractWindowFilterMafIterator. Step should be at least 1.");
+  }
+
+public:
+  /**
+   * @brief Mask removed regions instead of splitting blocks.
+   *
+   * @param yn If true, removed regions are recorded in the MafColumnMask property of each block, see MafColumnMask.
+   */
+  void setAnnotateOnly(bool yn) { annotateOnly_ = yn; }
+
+  bool isAnnotateOnly() const { return annotateOnly_; }
+
+  std::unique_ptr<MafBlock> nextRemovedBlock()
+  {
+    if (trashBuffer_.size() == 0) return nullptr;
+    auto block = std::move(trashBuffer_.front());
+    trashBuffer_.pop_front();
+    return block;
+  }
+
+  /**
+   * @return A new block containing the columns [begin, end[ of a block, with the same score and pass.
+   * The column mask of the block, if any, is restricted to the region.
+   * @param block The source block.
+   * @param begin The first column of the region.
+   * @param end The position after the last column of the region.
+   */
+  static std::unique_ptr<MafBlock> extractRegion(const MafBlock& block, size_t begin, size_t end);
+
+protected:
+  /**
+   * @brief Compute per-column scores for a block.
+   *
+   * @param block The block to analyse.
+   * @param scores [out] One vector of scores per criterion, each with one value per column of the block.
+   * Vectors are reused from one block to the other, and should be resized as needed.
+   * @return False if the block should be kept as is, without being filtered.
+   */
+  virtual bool computeColumnScores_(const MafBlock& block, std::vector<std::vector<double>>& scores) = 0;
+
+  /**
+   * @brief Tell if a window should be removed.
+   *
+   * @param sums The sum of each score over the window.
+   * @param begin The first column of the window.
+   * @param end The position after the last column of the window.
+   */
+  virtual bool isWindowRemoved_(const std::vector<double>& sums, size_t begin, size_t end) const = 0;
+
+  /**
+   * @brief Compute the regions to remove, as a list of consecutive [begin, end[ pairs.
+   *
+   * @param nc The number of columns in the block.
+   * @param pos [out] The bounds of the regions.
+   */
+  void computeRegions_(size_t nc, std::vector<size_t>& pos);
+
+  /**
+   * @brief Split a block according to the regions to remove, and send the resulting blocks to the output and trash buffers.
+   *
+   * In annotate only mode, the regions are added to the column mask of the block instead.
+   */
+  void splitBlock_(std::unique_ptr<MafBlock> block, const std::vector<size_t>& pos);
+
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
+
+private:
+  std::unique_ptr<MafBlock> analyseCurrentBlock_();
+};
+} // end of namespace bpp.
+
+#endif // _ABSTRACTWINDOWFILTERMAFITERATOR_H_
@@ -5,12 +5,13 @@
 #ifndef _ALIGNMENTFILTERMAFITERATOR_H_
 #define _ALIGNMENTFILTERMAFITERATOR_H_
 
-#include "AbstractMafIterator.h"
+#include "AbstractWindowFilterMafIterator.h"
+#include "MafBitPlane.h"
 
 // From the STL:
 #include <iostream>
 #include <string>
-#include <deque>
+#include <vector>
 
 namespace bpp
 {
@@ -26,20 +27,15 @@ namespace bpp
  * In case a sequence from the list is missing, it can be either ignored or counted as a full sequence of gaps.
  */
 class AlignmentFilterMafIterator :
-  public AbstractFilterMafIterator,
-  public virtual MafTrashIteratorInterface
+  public AbstractWindowFilterMafIterator
 {
 private:
   std::vector<std::string> species_;
-  unsigned int windowSize_;
-  unsigned int step_;
   unsigned int maxGap_;
   double maxPropGap_;
   double maxEnt_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
-  std::deque<std::unique_ptr<MafBlock>> trashBuffer_;
-  std::deque<std::vector<int>> window_;
-  bool keepTrashedBlocks_;
+  // Number of sequences considered in the current block:
+  size_t nbRows_;
   bool missingAsGap_;
   bool relative_;
 
@@ -66,17 +62,12 @@ public:
       double maxEnt,
       bool keepTrashedBlocks,
       bool missingAsGap) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "ALN CLEANER", "Sliding window for alignment filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
     maxGap_(maxGap),
     maxPropGap_(),
     maxEnt_(maxEnt),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks),
+    nbRows_(0),
     missingAsGap_(missingAsGap),
     relative_(false)
   {}
@@ -103,32 +94,23 @@ public:
       double maxEnt,
       bool keepTrashedBlocks,
       bool missingAsGap) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "ALN CLEANER", "Sliding window for alignment filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
     maxGap_(),
     maxPropGap_(maxPropGap),
     maxEnt_(maxEnt),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks),
+    nbRows_(0),
     missingAsGap_(missingAsGap),
     relative_(true)
   {}
 
-public:
-  std::unique_ptr<MafBlock> nextRemovedBlock()
-  {
-    if (trashBuffer_.size() == 0) return 0;
-    auto block = std::move(trashBuffer_.front());
-    trashBuffer_.pop_front();
-    return block;
-  }
+protected:
+  /**
+   * @brief Compute the number of gaps (first score) and the entropy (second score) of each column.
+   */
+  bool computeColumnScores_(const MafBlock& block, std::vector<std::vector<double>>& scores);
 
-private:
-  std::unique_ptr<MafBlock> analyseCurrentBlock_();
+  bool isWindowRemoved_(const std::vector<double>& sums, size_t begin, size_t end) const;
 };
 
 /**
@@ -140,20 +122,16 @@ private:
  * In case a sequence from the list is missing, it can be either ignored or counted as a full sequence of gaps.
  */
 class AlignmentFilter2MafIterator :
-  public AbstractFilterMafIterator,
-  public virtual MafTrashIteratorInterface
+  public AbstractWindowFilterMafIterator
 {
 private:
   std::vector<std::string> species_;
-  unsigned int windowSize_;
-  unsigned int step_;
   unsigned int maxGap_;
   double maxPropGap_;
   unsigned int maxPos_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
-  std::deque<std::unique_ptr<MafBlock>> trashBuffer_;
-  std::deque<std::vector<bool>> window_;
-  bool keepTrashedBlocks_;
+  // Columns with too many gaps, and changes of gap patterns, in the current block:
+  std::vector<unsigned char> columnGapped_;
+  MafBitPlane changes_;
   bool missingAsGap_;
   bool relative_;
 
@@ -180,17 +158,13 @@ public:
       unsigned int maxPos,
       bool keepTrashedBlocks,
       bool missingAsGap) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "ALN CLEANER", "Sliding window for alignment filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
     maxGap_(maxGap),
     maxPropGap_(),
     maxPos_(maxPos),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks),
+    columnGapped_(),
+    changes_(),
     missingAsGap_(missingAsGap),
     relative_(false)
   {}
@@ -217,32 +191,26 @@ public:
       unsigned int maxPos,
       bool keepTrashedBlocks,
       bool missingAsGap) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "ALN CLEANER", "Sliding window for alignment filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
     maxGap_(),
     maxPropGap_(maxPropGap),
     maxPos_(maxPos),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks),
+    columnGapped_(),
+    changes_(),
     missingAsGap_(missingAsGap),
     relative_(true)
   {}
 
-public:
-  std::unique_ptr<MafBlock> nextRemovedBlock()
-  {
-    if (trashBuffer_.size() == 0) return 0;
-    auto block = std::move(trashBuffer_.front());
-    trashBuffer_.pop_front();
-    return block;
-  }
+protected:
+  /**
+   * @brief Flag columns with too many gaps, and record changes of gap patterns.
+   *
+   * No score is returned, as gap events are not additive: windows are evaluated from the flags directly.
+   */
+  bool computeColumnScores_(const MafBlock& block, std::vector<std::vector<double>>& scores);
 
-private:
-  std::unique_ptr<MafBlock> analyseCurrentBlock_();
+  bool isWindowRemoved_(const std::vector<double>& sums, size_t begin, size_t end) const;
 };
 } // end of namespace bpp.
 
@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "BlockMergerMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 using namespace bpp;
 
@@ -79,6 +81,8 @@ std::unique_ptr<MafBlock> BlockMergerMafIterator::analyseCurrentBlock_()
     double s2 = incomingBlock_->getScore();
     double n2 = static_cast<double>(incomingBlock_->getNumberOfSites());
     mergedBlock->setScore((s1 * n1 + s2 * n2) / (n1 + n2));
+    // Excluded columns are kept excluded in the merged block:
+    auto mergedMask = MafColumnMask::concatenate(*currentBlock_, globalSpace, *incomingBlock_);
 
     // Now fill the new block:
     for (size_t i = 0; i < allSp.size(); ++i)
@@ -156,9 +160,38 @@ std::unique_ptr<MafBlock> BlockMergerMafIterator::analyseCurrentBlock_()
       }
       mergedBlock->addSequence(seq);
     }
+    if (mergedMask)
+      mergedBlock->setProperty(MafColumnMask::PROPERTY, std::move(mergedMask));
     currentBlock_ = std::move(mergedBlock);
     // We check if we can also merge the next block:
     incomingBlock_ = iterator_->nextBlock();
   }
   return std::move(currentBlock_);
 }
+
+void BlockMergerMafIterator::saveState_(ostream& out)
+{
+  MafBlockSerializer::writeSize(out, incomingBlock_ ? 1 : 0);
+  if (incomingBlock_)
+    MafBlockSerializer::write(out, *incomingBlock_);
+  MafBlockSerializer::writeSize(out, chimericChromosomeCounts_.size());
+  for (const auto& it : chimericChromosomeCounts_)
+  {
+    MafBlockSerializer::writeString(out, it.first);
+    MafBlockSerializer::writeSize(out, it.second);
+  }
+}
+
+void BlockMergerMafIterator::restoreState_(istream& in)
+{
+  incomingBlock_.reset();
+  if (MafBlockSerializer::readSize(in) == 1)
+    incomingBlock_ = MafBlockSerializer::read(in);
+  chimericChromosomeCounts_.clear();
+  size_t n = MafBlockSerializer::readSize(in);
+  for (size_t i = 0; i < n; ++i)
+  {
+    string chr = MafBlockSerializer::readString(in);
+    chimericChromosomeCounts_[chr] = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+  }
+}
@@ -0,0 +1,564 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "ColumnarStatisticsFile.h"
+#include "MafBlockSerializer.h"
+
+// From bpp-core:
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <cstring>
+
+using namespace std;
+
+const string ColumnarStatisticsFormat::MAGIC = string("BPPCOL1\0", 8);
+
+void ColumnarStatisticsFormat::writeUInt(string& out, uint64_t x, size_t nbBytes)
+{
+  for (size_t k = 0; k < nbBytes; ++k)
+  {
+    out.push_back(static_cast<char>((x >> (8 * k)) & 0xff));
+  }
+}
+
+uint64_t ColumnarStatisticsFormat::readUInt(const string& in, size_t& pos, size_t nbBytes)
+{
+  if (pos + nbBytes > in.size())
+    throw IOException("ColumnarStatisticsFormat::readUInt. Unexpected end of data.");
+  uint64_t x = 0;
+  for (size_t k = 0; k < nbBytes; ++k)
+  {
+    x |= static_cast<uint64_t>(static_cast<unsigned char>(in[pos++])) << (8 * k);
+  }
+  return x;
+}
+
+void ColumnarStatisticsFormat::writeVarUInt(string& out, uint64_t x)
+{
+  // 7 bits per byte, the highest bit telling if more bytes follow:
+  while (x >= 0x80)
+  {
+    out.push_back(static_cast<char>((x & 0x7f) | 0x80));
+    x >>= 7;
+  }
+  out.push_back(static_cast<char>(x));
+}
+
+uint64_t ColumnarStatisticsFormat::readVarUInt(const string& in, size_t& pos)
+{
+  uint64_t x = 0;
+  for (unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    if (pos >= in.size())
+      throw IOException("ColumnarStatisticsFormat::readVarUInt. Unexpected end of data.");
+    unsigned char byte = static_cast<unsigned char>(in[pos++]);
+    x |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return x;
+  }
+  throw IOException("ColumnarStatisticsFormat::readVarUInt. Invalid variable length integer.");
+}
+
+string ColumnarStatisticsFormat::readBytes(istream& in, size_t nbBytes)
+{
+  string bytes(nbBytes, '\0');
+  in.read(&bytes[0], static_cast<streamsize>(nbBytes));
+  if (static_cast<size_t>(in.gcount()) != nbBytes)
+    throw IOException("ColumnarStatisticsFormat::readBytes. Unexpected end of stream.");
+  return bytes;
+}
+
+/******************************************************************************/
+
+ColumnarStatisticsWriter::ColumnarStatisticsWriter(
+    shared_ptr<ostream> output,
+    const vector<string>& names,
+    const vector<ColumnarStatisticsFormat::ColumnType>& types,
+    size_t rowGroupSize,
+    bool encoded) :
+  output_(output),
+  columns_(names.size()),
+  rowGroupSize_(rowGroupSize),
+  nbRows_(0),
+  offset_(0),
+  groupOffsets_(),
+  groupSizes_(),
+  headerWritten_(false),
+  closed_(false)
+{
+  if (!output)
+    throw Exception("ColumnarStatisticsWriter (constructor). No output stream.");
+  if (names.size() != types.size())
+    throw Exception("ColumnarStatisticsWriter (constructor). The number of column types does not match the number of columns.");
+  if (rowGroupSize == 0)
+    throw Exception("ColumnarStatisticsWriter (constructor). Row group size should be at least 1.");
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    Column_& column = columns_[i];
+    column.name = names[i];
+    column.type = types[i];
+    column.encoded = encoded && types[i] != ColumnarStatisticsFormat::STRING;
+    // One slot for the current row:
+    column.available.assign(1, false);
+    column.integers.assign(1, 0);
+    column.doubles.assign(1, 0.);
+    column.indices.assign(1, 0);
+  }
+}
+
+ColumnarStatisticsWriter::~ColumnarStatisticsWriter()
+{
+  try
+  {
+    close();
+  }
+  catch (...)
+  {
+    // Errors cannot be reported from a destructor, call close() explicitly to catch them.
+  }
+}
+
+void ColumnarStatisticsWriter::setEncoding(size_t column, bool yn)
+{
+  if (headerWritten_)
+    throw Exception("ColumnarStatisticsWriter::setEncoding. Encodings cannot be changed once rows have been written.");
+  if (column >= columns_.size())
+    throw IndexOutOfBoundsException("ColumnarStatisticsWriter::setEncoding.", column, 0, columns_.size() - 1);
+  columns_[column].encoded = yn && columns_[column].type != ColumnarStatisticsFormat::STRING;
+}
+
+ColumnarStatisticsWriter::Column_& ColumnarStatisticsWriter::getColumn_(size_t column, ColumnarStatisticsFormat::ColumnType type)
+{
+  if (column >= columns_.size())
+    throw IndexOutOfBoundsException("ColumnarStatisticsWriter::getColumn_.", column, 0, columns_.size() - 1);
+  if (columns_[column].type != type)
+    throw Exception("ColumnarStatisticsWriter. Value type does not match the type of column " + columns_[column].name + ".");
+  return columns_[column];
+}
+
+void ColumnarStatisticsWriter::setString(size_t column, const string& value)
+{
+  Column_& c = getColumn_(column, ColumnarStatisticsFormat::STRING);
+  auto it = c.dictionary.emplace(value, static_cast<uint32_t>(c.dictionary.size())).first;
+  c.indices[nbRows_] = it->second;
+  c.available[nbRows_] = true;
+}
+
+void ColumnarStatisticsWriter::setInteger(size_t column, int64_t value)
+{
+  Column_& c = getColumn_(column, ColumnarStatisticsFormat::INTEGER);
+  c.integers[nbRows_] = value;
+  c.available[nbRows_] = true;
+}
+
+void ColumnarStatisticsWriter::setDouble(size_t column, double value)
+{
+  Column_& c = getColumn_(column, ColumnarStatisticsFormat::DOUBLE);
+  c.doubles[nbRows_] = value;
+  c.available[nbRows_] = true;
+}
+
+void ColumnarStatisticsWriter::endRow()
+{
+  if (closed_)
+    throw Exception("ColumnarStatisticsWriter::endRow. Writer is closed.");
+  nbRows_++;
+  for (auto& column : columns_)
+  {
+    column.available.push_back(false);
+    column.integers.push_back(0);
+    column.doubles.push_back(0.);
+    column.indices.push_back(0);
+  }
+  if (nbRows_ == rowGroupSize_)
+    writeRowGroup_();
+}
+
+void ColumnarStatisticsWriter::close()
+{
+  if (closed_)
+    return;
+  closed_ = true;
+  writeRowGroup_();
+  if (!headerWritten_)
+    writeHeader_();
+  uint64_t footerOffset = offset_;
+  string footer;
+  ColumnarStatisticsFormat::writeUInt(footer, groupOffsets_.size(), 8);
+  for (size_t g = 0; g < groupOffsets_.size(); ++g)
+  {
+    ColumnarStatisticsFormat::writeUInt(footer, groupOffsets_[g], 8);
+    ColumnarStatisticsFormat::writeUInt(footer, groupSizes_[g], 8);
+  }
+  ColumnarStatisticsFormat::writeUInt(footer, footerOffset, 8);
+  footer += ColumnarStatisticsFormat::MAGIC;
+  write_(footer);
+  output_->flush();
+}
+
+void ColumnarStatisticsWriter::saveState(ostream& out)
+{
+  if (closed_)
+    throw Exception("ColumnarStatisticsWriter::saveState. Writer is closed.");
+  writeRowGroup_();
+  if (!headerWritten_)
+    writeHeader_();
+  output_->flush();
+  streamoff pos = output_->tellp();
+  if (pos < 0)
+    throw IOException("ColumnarStatisticsWriter::saveState. Output stream does not support positioning, checkpoints are not available.");
+  MafBlockSerializer::writeSize(out, static_cast<size_t>(pos));
+  MafBlockSerializer::writeSize(out, static_cast<size_t>(offset_));
+  MafBlockSerializer::writeSize(out, groupOffsets_.size());
+  for (size_t g = 0; g < groupOffsets_.size(); ++g)
+  {
+    MafBlockSerializer::writeSize(out, static_cast<size_t>(groupOffsets_[g]));
+    MafBlockSerializer::writeSize(out, static_cast<size_t>(groupSizes_[g]));
+  }
+}
+
+void ColumnarStatisticsWriter::restoreState(istream& in)
+{
+  streamoff pos = static_cast<streamoff>(MafBlockSerializer::readSize(in));
+  offset_ = MafBlockSerializer::readSize(in);
+  size_t nbGroups = MafBlockSerializer::readSize(in);
+  groupOffsets_.resize(nbGroups);
+  groupSizes_.resize(nbGroups);
+  for (size_t g = 0; g < nbGroups; ++g)
+  {
+    groupOffsets_[g] = MafBlockSerializer::readSize(in);
+    groupSizes_[g] = MafBlockSerializer::readSize(in);
+  }
+  // The header was written before the checkpoint:
+  headerWritten_ = true;
+  closed_ = false;
+  output_->seekp(pos);
+  if (!*output_)
+    throw IOException("ColumnarStatisticsWriter::restoreState. Output stream could not be repositioned.");
+}
+
+void ColumnarStatisticsWriter::writeHeader_()
+{
+  string header = ColumnarStatisticsFormat::MAGIC;
+  ColumnarStatisticsFormat::writeUInt(header, columns_.size(), 4);
+  for (const auto& column : columns_)
+  {
+    header.push_back(static_cast<char>(column.type));
+    header.push_back(column.encoded ? 1 : 0);
+    ColumnarStatisticsFormat::writeUInt(header, column.name.size(), 4);
+    header += column.name;
+  }
+  write_(header);
+  headerWritten_ = true;
+}
+
+void ColumnarStatisticsWriter::writeRowGroup_()
+{
+  if (nbRows_ == 0)
+    return;
+  if (!headerWritten_)
+    writeHeader_();
+  groupOffsets_.push_back(offset_);
+  groupSizes_.push_back(nbRows_);
+  string group;
+  ColumnarStatisticsFormat::writeUInt(group, nbRows_, 8);
+  string chunk;
+  for (auto& column : columns_)
+  {
+    chunk.clear();
+    encodeColumn_(column, chunk);
+    ColumnarStatisticsFormat::writeUInt(group, chunk.size(), 8);
+    group += chunk;
+    // Reset the column, keeping one slot for the current row:
+    column.available.assign(1, false);
+    column.integers.assign(1, 0);
+    column.doubles.assign(1, 0.);
+    column.indices.assign(1, 0);
+    column.dictionary.clear();
+  }
+  write_(group);
+  nbRows_ = 0;
+}
+
+void ColumnarStatisticsWriter::encodeColumn_(const Column_& column, string& chunk) const
+{
+  // Validity bitmap:
+  for (size_t i = 0; i < nbRows_; i += 8)
+  {
+    unsigned char byte = 0;
+    for (size_t k = 0; k < 8 && i + k < nbRows_; ++k)
+    {
+      if (column.available[i + k])
+        byte = static_cast<unsigned char>(byte | (1 << k));
+    }
+    chunk.push_back(static_cast<char>(byte));
+  }
+
+  switch (column.type)
+  {
+  case ColumnarStatisticsFormat::INTEGER:
+    {
+      uint64_t previous = 0;
+      for (size_t i = 0; i < nbRows_; ++i)
+      {
+        uint64_t x = static_cast<uint64_t>(column.integers[i]);
+        if (column.encoded)
+        {
+          // Zigzag encoding, so that small negative differences are small numbers:
+          uint64_t diff = x - previous;
+          ColumnarStatisticsFormat::writeVarUInt(chunk, (diff << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(diff) >> 63));
+          previous = x;
+        }
+        else
+        {
+          ColumnarStatisticsFormat::writeUInt(chunk, x, 8);
+        }
+      }
+      break;
+    }
+
+  case ColumnarStatisticsFormat::DOUBLE:
+    {
+      uint64_t previous = 0;
+      for (size_t i = 0; i < nbRows_; ++i)
+      {
+        uint64_t bits;
+        memcpy(&bits, &column.doubles[i], sizeof(bits));
+        if (column.encoded)
+        {
+          uint64_t x = bits ^ previous;
+          unsigned int lead = 0;
+          unsigned int trail = 0;
+          if (x == 0)
+          {
+            lead = 8;
+          }
+          else
+          {
+            while (((x >> (8 * (7 - lead))) & 0xff) == 0)
+              lead++;
+            while (((x >> (8 * trail)) & 0xff) == 0)
+              trail++;
+          }
+          chunk.push_back(static_cast<char>((lead << 4) | trail));
+          ColumnarStatisticsFormat::writeUInt(chunk, x >> (8 * trail), 8 - lead - trail);
+          previous = bits;
+        }
+        else
+        {
+          ColumnarStatisticsFormat::writeUInt(chunk, bits, 8);
+        }
+      }
+      break;
+    }
+
+  case ColumnarStatisticsFormat::STRING:
+    {
+      vector<const string*> entries(column.dictionary.size());
+      for (const auto& it : column.dictionary)
+      {
+        entries[it.second] = &it.first;
+      }
+      ColumnarStatisticsFormat::writeUInt(chunk, entries.size(), 4);
+      for (const auto* entry : entries)
+      {
+        ColumnarStatisticsFormat::writeUInt(chunk, entry->size(), 4);
+        chunk += *entry;
+      }
+      for (size_t i = 0; i < nbRows_; ++i)
+      {
+        ColumnarStatisticsFormat::writeVarUInt(chunk, column.indices[i]);
+      }
+      break;
+    }
+  }
+}
+
+void ColumnarStatisticsWriter::write_(const string& bytes)
+{
+  output_->write(bytes.data(), static_cast<streamsize>(bytes.size()));
+  if (!*output_)
+    throw IOException("ColumnarStatisticsWriter. Error while writing to output stream.");
+  offset_ += bytes.size();
+}
+
+/******************************************************************************/
+
+ColumnarStatisticsReader::ColumnarStatisticsReader(shared_ptr<istream> input) :
+  input_(input),
+  columns_(),
+  groupOffsets_(),
+  groupSizes_(),
+  nbRows_(0)
+{
+  const size_t magicSize = ColumnarStatisticsFormat::MAGIC.size();
+  size_t pos = 0;
+
+  // Header:
+  input_->seekg(0, ios::beg);
+  if (ColumnarStatisticsFormat::readBytes(*input_, magicSize) != ColumnarStatisticsFormat::MAGIC)
+    throw IOException("ColumnarStatisticsReader (constructor). Stream is not in the columnar statistics format.");
+  string bytes = ColumnarStatisticsFormat::readBytes(*input_, 4);
+  columns_.resize(static_cast<size_t>(ColumnarStatisticsFormat::readUInt(bytes, pos, 4)));
+  for (auto& column : columns_)
+  {
+    bytes = ColumnarStatisticsFormat::readBytes(*input_, 6);
+    pos = 0;
+    char type = bytes[0];
+    if (type != ColumnarStatisticsFormat::STRING && type != ColumnarStatisticsFormat::INTEGER && type != ColumnarStatisticsFormat::DOUBLE)
+      throw IOException("ColumnarStatisticsReader (constructor). Unknown column type: " + TextTools::toString(type) + ".");
+    column.type = static_cast<ColumnarStatisticsFormat::ColumnType>(type);
+    column.encoded = (bytes[1] != 0);
+    pos = 2;
+    size_t length = static_cast<size_t>(ColumnarStatisticsFormat::readUInt(bytes, pos, 4));
+    column.name = ColumnarStatisticsFormat::readBytes(*input_, length);
+  }
+
+  // Footer:
+  input_->seekg(-static_cast<streamoff>(8 + magicSize), ios::end);
+  bytes = ColumnarStatisticsFormat::readBytes(*input_, 8 + magicSize);
+  if (bytes.substr(8) != ColumnarStatisticsFormat::MAGIC)
+    throw IOException("ColumnarStatisticsReader (constructor). Stream is truncated.");
+  pos = 0;
+  uint64_t footerOffset = ColumnarStatisticsFormat::readUInt(bytes, pos, 8);
+  input_->seekg(static_cast<streamoff>(footerOffset), ios::beg);
+  bytes = ColumnarStatisticsFormat::readBytes(*input_, 8);
+  pos = 0;
+  size_t nbGroups = static_cast<size_t>(ColumnarStatisticsFormat::readUInt(bytes, pos, 8));
+  bytes = ColumnarStatisticsFormat::readBytes(*input_, 16 * nbGroups);
+  pos = 0;
+  for (size_t g = 0; g < nbGroups; ++g)
+  {
+    groupOffsets_.push_back(ColumnarStatisticsFormat::readUInt(bytes, pos, 8));
+    groupSizes_.push_back(ColumnarStatisticsFormat::readUInt(bytes, pos, 8));
+  }
+}
+
+size_t ColumnarStatisticsReader::getColumnIndex(const string& name) const
+{
+  for (size_t i = 0; i < columns_.size(); ++i)
+  {
+    if (columns_[i].name == name)
+      return i;
+  }
+  throw Exception("ColumnarStatisticsReader::getColumnIndex. No column with name " + name + ".");
+}
+
+void ColumnarStatisticsReader::readRowGroup(size_t group)
+{
+  if (group >= groupOffsets_.size())
+    throw IndexOutOfBoundsException("ColumnarStatisticsReader::readRowGroup.", group, 0, groupOffsets_.size() - 1);
+  input_->seekg(static_cast<streamoff>(groupOffsets_[group]), ios::beg);
+  size_t pos = 0;
+  string bytes = ColumnarStatisticsFormat::readBytes(*input_, 8);
+  nbRows_ = static_cast<size_t>(ColumnarStatisticsFormat::readUInt(bytes, pos, 8));
+  if (nbRows_ != groupSizes_[group])
+    throw IOException("ColumnarStatisticsReader::readRowGroup. Row group size does not match the footer.");
+  for (auto& column : columns_)
+  {
+    pos = 0;
+    bytes = ColumnarStatisticsFormat::readBytes(*input_, 8);
+    size_t size = static_cast<size_t>(ColumnarStatisticsFormat::readUInt(bytes, pos, 8));
+    decodeColumn_(column, ColumnarStatisticsFormat::readBytes(*input_, size), nbRows_);
+  }
+}
+
+void ColumnarStatisticsReader::decodeColumn_(Column_& column, const string& chunk, size_t nbRows) const
+{
+  size_t pos = 0;
+  if ((nbRows + 7) / 8 > chunk.size())
+    throw IOException("ColumnarStatisticsReader::decodeColumn_. Unexpected end of data.");
+  column.available.resize(nbRows);
+  for (size_t i = 0; i < nbRows; ++i)
+  {
+    column.available[i] = (static_cast<unsigned char>(chunk[i >> 3]) >> (i & 7)) & 1;
+  }
+  pos = (nbRows + 7) / 8;
+  column.integers.clear();
+  column.doubles.clear();
+  column.indices.clear();
+  column.dictionary.clear();
+
+  switch (column.type)
+  {
+  case ColumnarStatisticsFormat::INTEGER:
+    {
+      column.integers.resize(nbRows);
+      uint64_t previous = 0;
+      for (size_t i = 0; i < nbRows; ++i)
+      {
+        uint64_t x;
+        if (column.encoded)
+        {
+          uint64_t z = ColumnarStatisticsFormat::readVarUInt(chunk, pos);
+          x = previous + ((z >> 1) ^ (~(z & 1) + 1));
+          previous = x;
+        }
+        else
+        {
+          x = ColumnarStatisticsFormat::readUInt(chunk, pos, 8);
+        }
+        column.integers[i] = static_cast<int64_t>(x);
+      }
+      break;
+    }
+
+  case ColumnarStatisticsFormat::DOUBLE:
+    {
+      column.doubles.resize(nbRows);
+      uint64_t previous = 0;
+      for (size_t i = 0; i < nbRows; ++i)
+      {
+        uint64_t bits;
+        if (column.encoded)
+        {
+          if (pos >= chunk.size())
+            throw IOException("ColumnarStatisticsReader::decodeColumn_. Unexpected end of data.");
+          unsigned int control = static_cast<unsigned char>(chunk[pos++]);
+          unsigned int lead = control >> 4;
+          unsigned int trail = control & 0x0f;
+          if (lead + trail > 8)
+            throw IOException("ColumnarStatisticsReader::decodeColumn_. Invalid control byte.");
+          uint64_t x = ColumnarStatisticsFormat::readUInt(chunk, pos, 8 - lead - trail);
+          bits = (trail < 8 ? x << (8 * trail) : 0) ^ previous;
+          previous = bits;
+        }
+        else
+        {
+          bits = ColumnarStatisticsFormat::readUInt(chunk, pos, 8);
+        }
+        memcpy(&column.doubles[i], &bits, sizeof(bits));
+      }
+      break;
+    }
+
+  case ColumnarStatisticsFormat::STRING:
+    {
+      size_t nbEntries = static_cast<size_t>(ColumnarStatisticsFormat::readUInt(chunk, pos, 4));
+      for (size_t k = 0; k < nbEntries; ++k)
+      {
+        size_t length = static_cast<size_t>(ColumnarStatisticsFormat::readUInt(chunk, pos, 4));
+        if (pos + length > chunk.size())
+          throw IOException("ColumnarStatisticsReader::decodeColumn_. Unexpected end of data.");
+        column.dictionary.push_back(chunk.substr(pos, length));
+        pos += length;
+      }
+      // Missing values point to the first entry, which has to exist:
+      if (column.dictionary.empty())
+        column.dictionary.push_back("");
+      column.indices.resize(nbRows);
+      for (size_t i = 0; i < nbRows; ++i)
+      {
+        uint64_t index = ColumnarStatisticsFormat::readVarUInt(chunk, pos);
+        if (index >= column.dictionary.size())
+          throw IOException("ColumnarStatisticsReader::decodeColumn_. Invalid dictionary index.");
+        column.indices[i] = static_cast<uint32_t>(index);
+      }
+      break;
+    }
+  }
+}
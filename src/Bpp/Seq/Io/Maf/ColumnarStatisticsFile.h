@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _COLUMNARSTATISTICSFILE_H_
+#define _COLUMNARSTATISTICSFILE_H_
+
+// From bpp-core:
+#include <Bpp/Exceptions.h>
+
+// From the STL:
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace bpp
+{
+/**
+ * @brief Column types and layout of the columnar statistics format.
+ *
+ * A file contains a table with typed columns, stored by groups of rows, and is self-describing.
+ * All numbers are written in little-endian order:
+ * - a header, with the magic string "BPPCOL1" followed by a null character, the number of columns (4 bytes),
+ *   and for each column its type (1 byte), its encoding (1 byte) and its name (length on 4 bytes, then characters);
+ * - row groups, each starting with the number of rows (8 bytes), followed by one chunk per column.
+ *   A chunk starts with its size in bytes (8 bytes), then a validity bitmap (one bit per row, 1 if the value is available),
+ *   then the values, in which missing values are stored as zeros;
+ * - a footer, with the number of row groups (8 bytes), the offset and number of rows of each group (8 bytes each),
+ *   then the offset of the footer (8 bytes) and the magic string again.
+ *
+ * Values are stored as follows:
+ * - INTEGER columns: 64 bits signed integers, or, if encoded, variable length zigzag-encoded differences between consecutive values;
+ * - DOUBLE columns: 64 bits IEEE numbers, or, if encoded, the bitwise 'xor' with the previous value, stored without its leading and
+ *   trailing zero bytes, after a control byte giving their numbers (this is efficient for slowly varying values and integer values);
+ * - STRING columns: a dictionary of the distinct values of the group (number of entries on 4 bytes, then each string), followed
+ *   by the variable length index of each value in the dictionary. Encoding has no effect on string columns.
+ */
+class ColumnarStatisticsFormat
+{
+public:
+  enum ColumnType
+  {
+    STRING = 's',
+    INTEGER = 'i',
+    DOUBLE = 'd'
+  };
+
+  static const std::string MAGIC;
+
+  /**
+   * @name Low-level functions, writing to and reading from byte buffers.
+   *
+   * @{
+   */
+  static void writeUInt(std::string& out, uint64_t x, size_t nbBytes);
+  static uint64_t readUInt(const std::string& in, size_t& pos, size_t nbBytes);
+  static void writeVarUInt(std::string& out, uint64_t x);
+  static uint64_t readVarUInt(const std::string& in, size_t& pos);
+  /** @} */
+
+  /**
+   * @brief Read a number of bytes from a stream.
+   *
+   * @throw IOException If the stream is truncated.
+   */
+  static std::string readBytes(std::istream& in, size_t nbBytes);
+};
+
+/**
+ * @brief Writer for the columnar statistics format, see ColumnarStatisticsFormat.
+ *
+ * Values of the current row are set column by column, and rows are buffered until a row group is full.
+ * Values which are not set before endRow() is called are missing.
+ * The footer is written by close(), which is also called by the destructor.
+ */
+class ColumnarStatisticsWriter
+{
+private:
+  struct Column_
+  {
+    std::string name;
+    ColumnarStatisticsFormat::ColumnType type;
+    bool encoded;
+    std::vector<bool> available;
+    std::vector<int64_t> integers;
+    std::vector<double> doubles;
+    std::vector<uint32_t> indices;
+    std::map<std::string, uint32_t> dictionary;
+  };
+
+  std::shared_ptr<std::ostream> output_;
+  std::vector<Column_> columns_;
+  size_t rowGroupSize_;
+  size_t nbRows_;
+  uint64_t offset_;
+  std::vector<uint64_t> groupOffsets_;
+  std::vector<uint64_t> groupSizes_;
+  bool headerWritten_;
+  bool closed_;
+
+public:
+  /**
+   * @param output The binary stream where to write the table.
+   * @param names The names of the columns.
+   * @param types The types of the columns.
+   * @param rowGroupSize The number of rows in each row group.
+   * @param encoded Tell if numeric columns should be encoded by default, see setEncoding().
+   */
+  ColumnarStatisticsWriter(
+      std::shared_ptr<std::ostream> output,
+      const std::vector<std::string>& names,
+      const std::vector<ColumnarStatisticsFormat::ColumnType>& types,
+      size_t rowGroupSize = 65536,
+      bool encoded = true);
+
+  virtual ~ColumnarStatisticsWriter();
+
+private:
+  ColumnarStatisticsWriter(const ColumnarStatisticsWriter& writer);
+  ColumnarStatisticsWriter& operator=(const ColumnarStatisticsWriter& writer);
+
+public:
+  /**
+   * @brief Set the encoding of a column. This must be done before the first row is written.
+   */
+  void setEncoding(size_t column, bool yn);
+
+  void setString(size_t column, const std::string& value);
+  void setInteger(size_t column, int64_t value);
+  void setDouble(size_t column, double value);
+
+  /**
+   * @brief Validate the current row, and start a new one.
+   */
+  void endRow();
+
+  /**
+   * @brief Write the last row group and the footer.
+   */
+  void close();
+
+  /**
+   * @brief Save and restore the state of the writer, for checkpoints (see MafIteratorInterface::saveCheckpoint).
+   *
+   * Buffered rows are first written as a row group, which may be smaller than the others,
+   * so that the state reduces to the position in the output and the list of row groups.
+   * Upon restoration, the output stream is repositioned, and has to be opened for update.
+   * The writer has to be created with the same columns as the one which saved the state.
+   *
+   * @throw IOException If the output stream cannot be positioned.
+   */
+  void saveState(std::ostream& out);
+  void restoreState(std::istream& in);
+
+private:
+  Column_& getColumn_(size_t column, ColumnarStatisticsFormat::ColumnType type);
+  void writeHeader_();
+  void writeRowGroup_();
+  void encodeColumn_(const Column_& column, std::string& chunk) const;
+  void write_(const std::string& bytes);
+};
+
+/**
+ * @brief Reader for the columnar statistics format, see ColumnarStatisticsFormat.
+ *
+ * Row groups are read one at a time, in any order, and their values are then available column by column.
+ * The input stream has to be seekable.
+ */
+class ColumnarStatisticsReader
+{
+private:
+  struct Column_
+  {
+    std::string name;
+    ColumnarStatisticsFormat::ColumnType type;
+    bool encoded;
+    std::vector<bool> available;
+    std::vector<int64_t> integers;
+    std::vector<double> doubles;
+    std::vector<uint32_t> indices;
+    std::vector<std::string> dictionary;
+  };
+
+  std::shared_ptr<std::istream> input_;
+  std::vector<Column_> columns_;
+  std::vector<uint64_t> groupOffsets_;
+  std::vector<uint64_t> groupSizes_;
+  size_t nbRows_;
+
+public:
+  /**
+   * @param input The binary stream to read.
+   * @throw IOException If the stream is not in the columnar statistics format.
+   */
+  ColumnarStatisticsReader(std::shared_ptr<std::istream> input);
+
+  virtual ~ColumnarStatisticsReader() {}
+
+private:
+  ColumnarStatisticsReader(const ColumnarStatisticsReader& reader);
+  ColumnarStatisticsReader& operator=(const ColumnarStatisticsReader& reader);
+
+public:
+  size_t getNumberOfColumns() const { return columns_.size(); }
+  const std::string& getColumnName(size_t column) const { return columns_[column].name; }
+  ColumnarStatisticsFormat::ColumnType getColumnType(size_t column) const { return columns_[column].type; }
+
+  /**
+   * @return The index of a column.
+   * @throw Exception If there is no column with this name.
+   */
+  size_t getColumnIndex(const std::string& name) const;
+
+  size_t getNumberOfRowGroups() const { return groupOffsets_.size(); }
+  size_t getNumberOfRows(size_t group) const { return static_cast<size_t>(groupSizes_[group]); }
+
+  /**
+   * @brief Load a row group. Values of the group are then available until the next call.
+   */
+  void readRowGroup(size_t group);
+
+  /**
+   * @return The number of rows in the loaded row group.
+   */
+  size_t getNumberOfRows() const { return nbRows_; }
+
+  bool isAvailable(size_t column, size_t row) const { return columns_[column].available[row]; }
+
+  /**
+   * @return All values of a numeric column in the loaded row group, missing values being zero.
+   */
+  const std::vector<int64_t>& getIntegers(size_t column) const { return columns_[column].integers; }
+  const std::vector<double>& getDoubles(size_t column) const { return columns_[column].doubles; }
+
+  const std::string& getString(size_t column, size_t row) const
+  {
+    const Column_& c = columns_[column];
+    return c.dictionary[c.indices[row]];
+  }
+
+private:
+  void decodeColumn_(Column_& column, const std::string& chunk, size_t nbRows) const;
+};
+} // end of namespace bpp.
+
+#endif // _COLUMNARSTATISTICSFILE_H_
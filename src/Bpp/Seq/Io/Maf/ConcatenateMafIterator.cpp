@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "ConcatenateMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 using namespace bpp;
 
@@ -59,6 +61,8 @@ unique_ptr<MafBlock> ConcatenateMafIterator::analyseCurrentBlock_()
     double s2 = incomingBlock_->getScore();
     double n2 = static_cast<double>(incomingBlock_->getNumberOfSites());
     mergedBlock->setScore((s1 * n1 + s2 * n2) / (n1 + n2));
+    // Excluded columns are kept excluded in the merged block:
+    auto mergedMask = MafColumnMask::concatenate(*currentBlock_, 0, *incomingBlock_);
 
     // Now fill the new block:
     for (size_t i = 0; i < allSp.size(); ++i)
@@ -115,9 +119,25 @@ unique_ptr<MafBlock> ConcatenateMafIterator::analyseCurrentBlock_()
       }
       mergedBlock->addSequence(seq);
     }
+    if (mergedMask)
+      mergedBlock->setProperty(MafColumnMask::PROPERTY, std::move(mergedMask));
     currentBlock_ = std::move(mergedBlock);
     // We check if we can also merge the next block:
     incomingBlock_ = iterator_->nextBlock();
   }
   return std::move(currentBlock_);
 }
+
+void ConcatenateMafIterator::saveState_(ostream& out)
+{
+  MafBlockSerializer::writeSize(out, incomingBlock_ ? 1 : 0);
+  if (incomingBlock_)
+    MafBlockSerializer::write(out, *incomingBlock_);
+}
+
+void ConcatenateMafIterator::restoreState_(istream& in)
+{
+  incomingBlock_.reset();
+  if (MafBlockSerializer::readSize(in) == 1)
+    incomingBlock_ = MafBlockSerializer::read(in);
+}
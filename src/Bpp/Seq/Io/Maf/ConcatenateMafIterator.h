@@ -61,6 +61,10 @@ private:
 
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
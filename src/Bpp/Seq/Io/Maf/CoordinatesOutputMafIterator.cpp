@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "CoordinatesOutputMafIterator.h"
+#include "MafBlockSerializer.h"
 
 using namespace bpp;
 using namespace std;
@@ -50,3 +51,13 @@ std::unique_ptr<MafBlock> CoordinatesOutputMafIterator::analyseCurrentBlock_()
   }
   return std::move(currentBlock_);
 }
+
+void CoordinatesOutputMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+}
+
+void CoordinatesOutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+}
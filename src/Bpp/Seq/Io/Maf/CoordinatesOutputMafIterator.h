@@ -70,6 +70,10 @@ private:
 private:
   void writeHeader_(std::ostream& out) const;
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "DuplicateFilterMafIterator.h"
+#include "MafBlockSerializer.h"
 
 using namespace bpp;
 
@@ -63,3 +64,51 @@ unique_ptr<MafBlock> DuplicateFilterMafIterator::analyseCurrentBlock_()
 
   return std::move(currentBlock_);
 }
+
+void DuplicateFilterMafIterator::saveState_(ostream& out)
+{
+  // Coordinates are flattened as (chr, strand, start, stop, occurrence) records:
+  size_t n = 0;
+  for (const auto& itChr : blocks_)
+  {
+    for (const auto& itStrand : itChr.second)
+    {
+      for (const auto& itStart : itStrand.second)
+      {
+        n += itStart.second.size();
+      }
+    }
+  }
+  MafBlockSerializer::writeSize(out, n);
+  for (const auto& itChr : blocks_)
+  {
+    for (const auto& itStrand : itChr.second)
+    {
+      for (const auto& itStart : itStrand.second)
+      {
+        for (const auto& itStop : itStart.second)
+        {
+          MafBlockSerializer::writeString(out, itChr.first);
+          out.put(itStrand.first);
+          MafBlockSerializer::writeSize(out, itStart.first);
+          MafBlockSerializer::writeSize(out, itStop.first);
+          MafBlockSerializer::writeSize(out, itStop.second);
+        }
+      }
+    }
+  }
+}
+
+void DuplicateFilterMafIterator::restoreState_(istream& in)
+{
+  blocks_.clear();
+  size_t n = MafBlockSerializer::readSize(in);
+  for (size_t i = 0; i < n; ++i)
+  {
+    string chr = MafBlockSerializer::readString(in);
+    char strand = static_cast<char>(in.get());
+    size_t start = MafBlockSerializer::readSize(in);
+    size_t stop = MafBlockSerializer::readSize(in);
+    blocks_[chr][strand][start][stop] = MafBlockSerializer::readSize(in);
+  }
+}
@@ -9,239 +9,87 @@ using namespace bpp;
 // From the STL:
 #include <string>
 #include <numeric>
+#include <array>
+#include <cmath>
 
 using namespace std;
 
-unique_ptr<MafBlock> EntropyFilterMafIterator::analyseCurrentBlock_()
+bool EntropyFilterMafIterator::computeColumnScores_(const MafBlock& block, vector<vector<double>>& scores)
 {
-  if (blockBuffer_.size() == 0)
+  size_t nc = static_cast<size_t>(block.getNumberOfSites());
+  vector<const vector<int>*> aln;
+  size_t nbMissing = 0;
+  if (missingAsGap_ && !ignoreGaps_)
   {
-    // Else there is no more block in the buffer, we need to parse more:
-    do
+    for (const auto& sp : species_)
     {
-      auto block = iterator_->nextBlock();
-      if (!block)
-        return 0; // No more block.
-
-      // Parse block.
-      int gap = AlphabetTools::DNA_ALPHABET->getGapCharacterCode();
-      // unused for now
-      // int unk = AlphabetTools::DNA_ALPHABET.getUnknownCharacterCode();
-      size_t nr;
-      size_t nc = static_cast<size_t>(block->getNumberOfSites());
-      if (nc < windowSize_)
-        throw Exception("EntropyFilterMafIterator::analyseCurrentBlock_. Block is smaller than window size: " + TextTools::toString(nc));
-
-      vector< vector<int>> aln;
-      if (missingAsGap_ && !ignoreGaps_)
-      {
-        nr = species_.size();
-        aln.resize(nr);
-        for (size_t i = 0; i < nr; ++i)
-        {
-          if (block->hasSequenceForSpecies(species_[i]))
-            aln[i] = block->sequenceForSpecies(species_[i]).getContent();
-          else
-          {
-            aln[i].resize(nc);
-            fill(aln[i].begin(), aln[i].end(), gap);
-          }
-        }
-      }
+      if (block.hasSequenceForSpecies(sp))
+        aln.push_back(&block.sequenceForSpecies(sp).getContent());
       else
-      {
-        vector<string> speciesSet = VectorTools::vectorIntersection(species_, block->getSpeciesList());
-        nr = speciesSet.size();
-        aln.resize(nr);
-        for (size_t i = 0; i < nr; ++i)
-        {
-          aln[i] = block->sequenceForSpecies(species_[i]).getContent();
-        }
-      }
-      // First we create a mask:
-      vector<size_t> pos;
-      // Reset window:
-      window_.clear();
-      // Init window:
-      size_t i;
-      for (i = 0; i < windowSize_; ++i)
-      {
-        vector<int> col;
-        for (size_t j = 0; j < nr; ++j)
-        {
-          int x = aln[j][i];
-          if (x != gap || !ignoreGaps_)
-            col.push_back(x);
-        }
-        double entropy = VectorTools::shannonDiscrete<int, double>(col) / log(5.);
-        window_.push_back(entropy > maxEnt_ ? 1 : 0);
-      }
-      // Slide window:
-      if (verbose_)
-      {
-        ApplicationTools::message->endLine();
-        ApplicationTools::displayTask("Sliding window for entropy filter", true);
-      }
-      while (i + step_ < nc)
-      {
-        if (verbose_)
-          ApplicationTools::displayGauge(i - windowSize_, nc - windowSize_ - 1, '>');
-        // Evaluate current window:
-        unsigned int count = std::accumulate(window_.begin(), window_.end(), 0u);
-        if (count > maxPos_)
-        {
-          if (pos.size() == 0)
-          {
-            pos.push_back(i - windowSize_);
-            pos.push_back(i);
-          }
-          else
-          {
-            if (i - windowSize_ < pos[pos.size() - 1])
-            {
-              pos[pos.size() - 1] = i; // Windows are overlapping and we extend previous region
-            }
-            else // This is a new region
-            {
-              pos.push_back(i - windowSize_);
-              pos.push_back(i);
-            }
-          }
-        }
-
-        // Move forward:
-        for (size_t k = 0; k < step_; ++k)
-        {
-          vector<int> col;
-          for (size_t j = 0; j < nr; ++j)
-          {
-            int x = aln[j][i];
-            if (x != gap || !ignoreGaps_)
-              col.push_back(x);
-          }
-          double entropy = VectorTools::shannonDiscrete<int, double>(col) / log(5.);
-          window_.push_back(entropy > maxEnt_ ? 1 : 0);
-          window_.pop_front();
-          ++i;
-        }
-      }
+        nbMissing++;
+    }
+  }
+  else
+  {
+    vector<string> speciesSet = VectorTools::vectorIntersection(species_, block.getSpeciesList());
+    for (const auto& sp : speciesSet)
+    {
+      aln.push_back(&block.sequenceForSpecies(sp).getContent());
+    }
+  }
 
-      // Evaluate last window:
-      unsigned int count = std::accumulate(window_.begin(), window_.end(), 0u);
-      if (count > maxPos_)
+  // Symbols are stored as one byte, with the gap at index 0 and states shifted by one:
+  int gap = AlphabetTools::DNA_ALPHABET->getGapCharacterCode();
+  size_t nr = aln.size();
+  columns_.resize(nc * nr);
+  // Transpose by tiles of columns, so that both reads and writes stay in cache:
+  const size_t tile = 256;
+  for (size_t i0 = 0; i0 < nc; i0 += tile)
+  {
+    size_t i1 = min(nc, i0 + tile);
+    for (size_t j = 0; j < nr; ++j)
+    {
+      const int* seq = aln[j]->data();
+      for (size_t i = i0; i < i1; ++i)
       {
-        if (pos.size() == 0)
-        {
-          pos.push_back(i - windowSize_);
-          pos.push_back(i);
-        }
-        else
-        {
-          if (i - windowSize_ <= pos[pos.size() - 1])
-          {
-            pos[pos.size() - 1] = i; // Windows are overlapping and we extend previous region
-          }
-          else // This is a new region
-          {
-            pos.push_back(i - windowSize_);
-            pos.push_back(i);
-          }
-        }
+        unsigned int x = static_cast<unsigned int>(seq[i] - gap);
+        if (x >= NB_SYMBOLS)
+          throw Exception("EntropyFilterMafIterator::computeColumnScores_. Unsupported character state: " + TextTools::toString(seq[i]) + ".");
+        columns_[i * nr + j] = static_cast<unsigned char>(x);
       }
-      if (verbose_)
-        ApplicationTools::displayTaskDone();
+    }
+  }
 
-      // Now we remove regions with two many gaps, using a sliding window:
-      if (pos.size() == 0)
-      {
-        blockBuffer_.push_back(std::move(block));
-        if (logstream_)
-        {
-          (*logstream_ << "ENTROPY CLEANER: block " << block->getDescription() << " is clean and kept as is.").endLine();
-        }
-      }
-      else if (pos.size() == 2 && pos.front() == 0 && pos.back() == block->getNumberOfSites())
-      {
-        // Everything is removed:
-        if (logstream_)
-        {
-          (*logstream_ << "ENTROPY CLEANER: block " << block->getDescription() << " was entirely removed. Tried to get the next one.").endLine();
-        }
-      }
-      else
-      {
-        if (logstream_)
-        {
-          (*logstream_ << "ALN CLEANER: block " << block->getDescription() << " with size " << block->getNumberOfSites() << " will be split into " << (pos.size() / 2 + 1) << " blocks.").endLine();
-        }
-        if (verbose_)
-        {
-          ApplicationTools::message->endLine();
-          ApplicationTools::displayTask("Splitting block", true);
-        }
-        for (i = 0; i < pos.size(); i += 2)
-        {
-          if (verbose_)
-            ApplicationTools::displayGauge(i, pos.size() - 2, '=');
-          if (logstream_)
-          {
-            (*logstream_ << "ENTROPY CLEANER: removing region (" << pos[i] << ", " << pos[i + 1] << ") from block " << block->getDescription() << ".").endLine();
-          }
-          if (pos[i] > 0)
-          {
-            auto newBlock = make_unique<MafBlock>();
-            newBlock->setScore(block->getScore());
-            newBlock->setPass(block->getPass());
-            for (size_t j = 0; j < block->getNumberOfSequences(); ++j)
-            {
-              unique_ptr<MafSequence> subseq;
-              if (i == 0)
-              {
-                subseq = block->sequence(j).subSequence(0, pos[i]);
-              }
-              else
-              {
-                subseq = block->sequence(j).subSequence(pos[i - 1], pos[i] - pos[i - 1]);
-              }
-              newBlock->addSequence(subseq);
-            }
-            blockBuffer_.push_back(std::move(newBlock));
-          }
+  // Entropy is computed as (n.log(n) - sum_k c_k.log(c_k)) / (n.log(5)), using a table of c.log(c):
+  size_t nmax = nr + nbMissing;
+  vector<double> xlogx(nmax + 1, 0.);
+  for (size_t k = 2; k <= nmax; ++k)
+  {
+    xlogx[k] = static_cast<double>(k) * log(static_cast<double>(k));
+  }
+  double norm = log(5.);
 
-          if (keepTrashedBlocks_)
-          {
-            auto outBlock = make_unique<MafBlock>();
-            outBlock->setScore(block->getScore());
-            outBlock->setPass(block->getPass());
-            for (size_t j = 0; j < block->getNumberOfSequences(); ++j)
-            {
-              auto outseq = block->sequence(j).subSequence(pos[i], pos[i + 1] - pos[i]);
-              outBlock->addSequence(outseq);
-            }
-            trashBuffer_.push_back(std::move(outBlock));
-          }
-        }
-        // Add last block:
-        if (pos[pos.size() - 1] < block->getNumberOfSites())
-        {
-          auto newBlock = make_unique<MafBlock>();
-          newBlock->setScore(block->getScore());
-          newBlock->setPass(block->getPass());
-          for (size_t j = 0; j < block->getNumberOfSequences(); ++j)
-          {
-            auto subseq = block->sequence(j).subSequence(pos[pos.size() - 1], block->getNumberOfSites() - pos[pos.size() - 1]);
-            newBlock->addSequence(subseq);
-          }
-          blockBuffer_.push_back(std::move(newBlock));
-        }
-        if (verbose_)
-          ApplicationTools::displayTaskDone();
-      }
+  scores.resize(1);
+  scores[0].resize(nc);
+  array<unsigned int, NB_SYMBOLS> counts;
+  for (size_t i = 0; i < nc; ++i)
+  {
+    counts.fill(0);
+    const unsigned char* col = columns_.data() + i * nr;
+    for (size_t j = 0; j < nr; ++j)
+    {
+      counts[col[j]]++;
+    }
+    counts[0] = ignoreGaps_ ? 0 : counts[0] + static_cast<unsigned int>(nbMissing);
+    unsigned int n = 0;
+    double s = 0.;
+    for (size_t k = 0; k < NB_SYMBOLS; ++k)
+    {
+      n += counts[k];
+      s += xlogx[counts[k]];
     }
-    while (blockBuffer_.size() == 0);
+    double entropy = n > 0 ? (xlogx[n] - s) / (static_cast<double>(n) * norm) : 0.;
+    scores[0][i] = entropy > maxEnt_ ? 1. : 0.;
   }
-
-  auto block = std::move(blockBuffer_.front());
-  blockBuffer_.pop_front();
-  return block;
+  return true;
 }
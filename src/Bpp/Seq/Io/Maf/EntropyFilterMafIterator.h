@@ -5,12 +5,12 @@
 #ifndef _ENTROPYFILTERMAFITERATOR_H_
 #define _ENTROPYFILTERMAFITERATOR_H_
 
-#include "AbstractMafIterator.h"
+#include "AbstractWindowFilterMafIterator.h"
 
 // From the STL:
 #include <iostream>
 #include <string>
-#include <deque>
+#include <vector>
 
 namespace bpp
 {
@@ -22,19 +22,14 @@ namespace bpp
  * In case a sequence from the list is missing, it can be either ignored or counted as a full sequence of gaps.
  */
 class EntropyFilterMafIterator :
-  public AbstractFilterMafIterator,
-  public virtual MafTrashIteratorInterface
+  public AbstractWindowFilterMafIterator
 {
 private:
   std::vector<std::string> species_;
-  unsigned int windowSize_;
-  unsigned int step_;
   double maxEnt_;
   unsigned int maxPos_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
-  std::deque<std::unique_ptr<MafBlock>> trashBuffer_;
-  std::deque<unsigned int> window_;
-  bool keepTrashedBlocks_;
+  // Site-major matrix of symbol indices, reused between blocks:
+  std::vector<unsigned char> columns_;
   bool missingAsGap_;
   bool ignoreGaps_;
 
@@ -49,31 +44,31 @@ public:
       bool keepTrashedBlocks,
       bool missingAsGap,
       bool ignoreGaps) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "ENTROPY CLEANER", "Sliding window for entropy filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
     maxEnt_(maxEnt),
     maxPos_(maxPos),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks),
+    columns_(),
     missingAsGap_(missingAsGap),
     ignoreGaps_(ignoreGaps)
   {}
 
 public:
-  std::unique_ptr<MafBlock> nextRemovedBlock()
+  /**
+   * @brief Number of distinct symbols handled by the entropy kernel: gap, the four nucleotides and the generic characters.
+   */
+  static constexpr size_t NB_SYMBOLS = 16;
+
+protected:
+  /**
+   * @brief Flag each column with an entropy above the threshold.
+   */
+  bool computeColumnScores_(const MafBlock& block, std::vector<std::vector<double>>& scores);
+
+  bool isWindowRemoved_(const std::vector<double>& sums, size_t begin, size_t end) const
   {
-    if (trashBuffer_.size() == 0) return 0;
-    auto block = std::move(trashBuffer_.front());
-    trashBuffer_.pop_front();
-    return block;
+    return sums[0] > maxPos_;
   }
-
-private:
-  std::unique_ptr<MafBlock> analyseCurrentBlock_();
 };
 } // end of namespace bpp.
 
@@ -3,10 +3,12 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "EstSfsOutputMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+#include "MafColumnCounts.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
-#include <Bpp/Seq/SiteTools.h>
 #include <Bpp/Seq/SequenceWalker.h>
 
 using namespace bpp;
@@ -19,66 +21,54 @@ using namespace std;
 
 void EstSfsOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block) const
 {
-  auto ingroupContainer = block.getAlignment(ingroup_);
-  auto outgroup1Container = block.getAlignment(outgroup1_);
-  auto outgroup2Container = block.getAlignment(outgroup2_);
-  auto outgroup3Container = block.getAlignment(outgroup3_);
+  // Sequences are read in place, without copying them to alignment containers:
+  vector< vector<const MafSequence*> > groups;
+  groups.push_back(block.getSequencesForSpecies(ingroup_));
+  groups.push_back(block.getSequencesForSpecies(outgroup1_));
+  // Second and third outgroups are optional:
+  if (outgroup2_.size() > 0)
+    groups.push_back(block.getSequencesForSpecies(outgroup2_));
+  if (outgroup3_.size() > 0)
+    groups.push_back(block.getSequencesForSpecies(outgroup3_));
 
-  for (size_t i = 0; i < ingroupContainer->getNumberOfSites(); ++i)
+  // No site is output if the block has no sequence for the ingroup:
+  size_t nbSites = groups[0].empty() ? 0 : static_cast<size_t>(block.getNumberOfSites());
+  // Columns excluded by a cleaning filter in annotate-only mode are skipped:
+  const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
+  MafNucleotideCounts counts;
+  for (size_t i = 0; i < nbSites; ++i)
   {
-    if (SymbolListTools::isComplete(ingroupContainer->site(i)))
+    if (mask && mask->isExcluded(i))
+      continue;
+    for (size_t g = 0; g < groups.size(); ++g)
     {
-      map<int, size_t> counts;
-      SiteTools::getCounts(ingroupContainer->site(i), counts);
-      // Alphabet states are in alaphabetical order
-      out << counts[0] << "," << counts[1] << "," << counts[2] << "," << counts[3];
-    }
-    else
-    {
-      out << "0,0,0,0";
-    }
-
-    if (SymbolListTools::isComplete(outgroup1Container->site(i)))
-    {
-      map<int, size_t> counts;
-      SiteTools::getCounts(outgroup1Container->site(i), counts);
-      out << " " << counts[0] << "," << counts[1] << "," << counts[2] << "," << counts[3];
-    }
-    else
-    {
-      out << " 0,0,0,0";
-    }
-
-    if (outgroup2_.size() > 0)
-    {
-      // Second outgroup is present
-      if (SymbolListTools::isComplete(outgroup2Container->site(i)))
+      counts.clear();
+      for (const MafSequence* seq : groups[g])
       {
-        map<int, size_t> counts;
-        SiteTools::getCounts(outgroup2Container->site(i), counts);
-        out << " " << counts[0] << "," << counts[1] << "," << counts[2] << "," << counts[3];
+        counts.add(&seq->getContent()[i], 1);
       }
-      else
+      if (g > 0)
+        out << " ";
+      if (counts.isComplete())
       {
-        out << " 0,0,0,0";
-      }
-    }
-
-    if (outgroup3_.size() > 0)
-    {
-      // Third outgroup is present
-      if (SymbolListTools::isComplete(outgroup3Container->site(i)))
-      {
-        map<int, size_t> counts;
-        SiteTools::getCounts(outgroup3Container->site(i), counts);
-        out << " " << counts[0] << "," << counts[1] << "," << counts[2] << "," << counts[3];
+        // Alphabet states are in alphabetical order
+        out << counts.getCount(0) << "," << counts.getCount(1) << "," << counts.getCount(2) << "," << counts.getCount(3);
       }
       else
       {
-        out << " 0,0,0,0";
+        out << "0,0,0,0";
       }
     }
-
     out << endl;
   }
 }
+
+void EstSfsOutputMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+}
+
+void EstSfsOutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+}
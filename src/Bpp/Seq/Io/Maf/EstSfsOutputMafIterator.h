@@ -79,6 +79,10 @@ public:
 
 private:
   void writeBlock_(std::ostream& out, const MafBlock& block) const;
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
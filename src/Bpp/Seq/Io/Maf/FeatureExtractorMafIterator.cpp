@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "FeatureExtractorMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/SequenceWalker.h>
@@ -91,20 +93,28 @@ START:
       newBlock->setPass(block->getPass());
       size_t a = walker.getAlignmentPosition(it->begin() - refSeq.start());
       size_t b = walker.getAlignmentPosition(it->end() - refSeq.start() - 1);
+      bool invert = !ignoreStrand_ &&
+          ((dynamic_cast<const SeqRange*>(it)->isNegativeStrand() && refSeq.getStrand() == '+') ||
+          (!dynamic_cast<const SeqRange*>(it)->isNegativeStrand() && refSeq.getStrand() == '-'));
       for (size_t j = 0; j < block->getNumberOfSequences(); ++j)
       {
         auto subseq = block->sequence(j).subSequence(a, b - a + 1);
-        if (!ignoreStrand_)
+        if (invert)
         {
-          if ((dynamic_cast<const SeqRange*>(it)->isNegativeStrand() && refSeq.getStrand() == '+') ||
-              (!dynamic_cast<const SeqRange*>(it)->isNegativeStrand() && refSeq.getStrand() == '-'))
-          {
-            SequenceTools::invertComplement(*subseq);
-          }
+          SequenceTools::invertComplement(*subseq);
         }
         (*logstream_ << subseq->getName()).endLine();
         newBlock->addSequence(subseq);
       }
+      // Excluded columns follow the extracted region, in reverse order if it was reverse complemented:
+      const MafColumnMask* mask = MafColumnMask::getColumnMask(*block);
+      if (mask)
+      {
+        auto subMask = mask->subMask(a, b + 1);
+        if (invert)
+          subMask->reverse();
+        newBlock->setProperty(MafColumnMask::PROPERTY, std::move(subMask));
+      }
       blockBuffer_.push_back(std::move(newBlock));
     }
 
@@ -116,3 +126,13 @@ START:
   blockBuffer_.pop_front();
   return nxtBlock;
 }
+
+void FeatureExtractorMafIterator::saveState_(ostream& out)
+{
+  blockBuffer_.save(out);
+}
+
+void FeatureExtractorMafIterator::restoreState_(istream& in)
+{
+  blockBuffer_.restore(in);
+}
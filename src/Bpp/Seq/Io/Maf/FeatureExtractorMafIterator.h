@@ -5,7 +5,7 @@
 #ifndef _FEATUREEXTRACTORMAFITERATOR_H_
 #define _FEATUREEXTRACTORMAFITERATOR_H_
 
-#include "AbstractMafIterator.h"
+#include "AbstractBufferedFilterMafIterator.h"
 
 // From the STL:
 #include <iostream>
@@ -23,13 +23,12 @@ namespace bpp
  * in duplication of original data.
  */
 class FeatureExtractorMafIterator :
-  public AbstractFilterMafIterator
+  public AbstractBufferedFilterMafIterator
 {
 private:
   std::string refSpecies_;
   bool completeOnly_;
   bool ignoreStrand_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
   std::map<std::string, RangeSet<size_t>> ranges_;
 
 public:
@@ -48,11 +47,10 @@ public:
       const SequenceFeatureSet& features,
       bool complete = false,
       bool ignoreStrand = false) :
-    AbstractFilterMafIterator(iterator),
+    AbstractBufferedFilterMafIterator(iterator),
     refSpecies_(refSpecies),
     completeOnly_(complete),
     ignoreStrand_(ignoreStrand),
-    blockBuffer_(),
     ranges_()
   {
     // Build ranges:
@@ -65,6 +63,10 @@ public:
 
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "FeatureFilterMafIterator.h"
+#include "MafBlockSerializer.h"
 
 using namespace bpp;
 
@@ -86,10 +87,9 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
         ApplicationTools::message->endLine();
         ApplicationTools::displayTask("Removing features", true);
       }
-      for (size_t alnPos = 0; alnPos < refSeq.size() && refBounds.size() > 0; ++alnPos)
+      size_t alnPos = 0;
+      for ( ; alnPos < refSeq.size() && refBounds.size() > 0; ++alnPos)
       {
-        if (verbose_)
-          ApplicationTools::displayGauge(static_cast<size_t>(refPos + 1), refBounds.back() + 1, '>');
         if (refSeq[alnPos] != gap)
         {
           refPos++;
@@ -101,6 +101,8 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
           }
         }
       }
+      if (progress_)
+        progress_->addSites(alnPos);
       if (verbose_)
         ApplicationTools::displayTaskDone();
 
@@ -126,6 +128,15 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
           (*logstream_ << "FEATURE FILTER: block " << block->getDescription() << " was entirely removed. Tried to get the next one.").endLine();
         }
       }
+      else if (annotateOnly_)
+      {
+        if (logstream_)
+        {
+          (*logstream_ << "FEATURE FILTER: masking " << (pos.size() / 2) << " region(s) in block " << block->getDescription() << ".").endLine();
+        }
+        MafColumnMask::excludeRegions(*block, pos);
+        blockBuffer_.push_back(std::move(block));
+      }
       else
       {
         if (logstream_)
@@ -162,6 +173,7 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
               }
               newBlock->addSequence(subseq);
             }
+            MafColumnMask::setSubMask(*newBlock, *block, i == 0 ? 0 : pos[i - 1], pos[i]);
             if (newBlock->getNumberOfSites() > 0)
               blockBuffer_.push_back(std::move(newBlock));
           }
@@ -176,6 +188,7 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
               auto outseq = block->sequence(j).subSequence(pos[i], pos[i + 1] - pos[i]);
               outBlock->addSequence(outseq);
             }
+            MafColumnMask::setSubMask(*outBlock, *block, pos[i], pos[i + 1]);
             trashBuffer_.push_back(std::move(outBlock));
           }
         }
@@ -190,6 +203,7 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
             auto subseq = block->sequence(j).subSequence(pos[pos.size() - 1], block->getNumberOfSites() - pos[pos.size() - 1]);
             newBlock->addSequence(subseq);
           }
+          MafColumnMask::setSubMask(*newBlock, *block, pos.back(), block->getNumberOfSites());
           blockBuffer_.push_back(std::move(newBlock));
         }
         if (verbose_)
@@ -203,3 +217,15 @@ unique_ptr<MafBlock> FeatureFilterMafIterator::analyseCurrentBlock_()
   blockBuffer_.pop_front();
   return nxtBlock;
 }
+
+void FeatureFilterMafIterator::saveState_(ostream& out)
+{
+  blockBuffer_.save(out);
+  trashBuffer_.save(out);
+}
+
+void FeatureFilterMafIterator::restoreState_(istream& in)
+{
+  blockBuffer_.restore(in);
+  trashBuffer_.restore(in);
+}
@@ -5,7 +5,8 @@
 #ifndef _FEATUREFILTERMAFITERATOR_H_
 #define _FEATUREFILTERMAFITERATOR_H_
 
-#include "AbstractMafIterator.h"
+#include "AbstractBufferedFilterMafIterator.h"
+#include "MafColumnMask.h"
 
 // From the STL:
 #include <iostream>
@@ -19,16 +20,17 @@ namespace bpp
  * @brief Remove from alignment all positions that fall within any feature from a list given as a SequenceFeatureSet object.
  *
  * Removed regions are outputted as a trash iterator.
+ * In "annotate only" mode, blocks are not split: removed regions are recorded in a MafColumnMask property
+ * of the block, and nothing is sent to the trash.
  */
 class FeatureFilterMafIterator :
-  public AbstractFilterMafIterator,
+  public AbstractBufferedFilterMafIterator,
   public MafTrashIteratorInterface
 {
 private:
   std::string refSpecies_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
-  std::deque<std::unique_ptr<MafBlock>> trashBuffer_;
   bool keepTrashedBlocks_;
+  bool annotateOnly_;
   std::map<std::string, MultiRange<size_t>> ranges_;
 
 public:
@@ -37,11 +39,10 @@ public:
       const std::string& refSpecies,
       const SequenceFeatureSet& features,
       bool keepTrashedBlocks) :
-    AbstractFilterMafIterator(iterator),
+    AbstractBufferedFilterMafIterator(iterator),
     refSpecies_(refSpecies),
-    blockBuffer_(),
-    trashBuffer_(),
     keepTrashedBlocks_(keepTrashedBlocks),
+    annotateOnly_(false),
     ranges_()
   {
     // Build ranges:
@@ -55,6 +56,15 @@ public:
   }
 
 public:
+  /**
+   * @brief Mask features instead of splitting blocks.
+   *
+   * @param yn If true, removed regions are recorded in the MafColumnMask property of each block, see MafColumnMask.
+   */
+  void setAnnotateOnly(bool yn) { annotateOnly_ = yn; }
+
+  bool isAnnotateOnly() const { return annotateOnly_; }
+
   std::unique_ptr<MafBlock> nextRemovedBlock()
   {
     if (trashBuffer_.size() == 0) return nullptr;
@@ -65,6 +75,10 @@ public:
 
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "FullGapFilterMafIterator.h"
+#include "MafColumnMask.h"
 
 // From bpp-seq
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
@@ -72,7 +73,7 @@ unique_ptr<MafBlock> FullGapFilterMafIterator::analyseCurrentBlock_()
   {
     if (verbose_)
       ApplicationTools::displayGauge(start.size() - i, start.size() - 1, '=');
-    block->deleteSites(start[i - 1], count[i - 1]);
+    MafColumnMask::deleteSites(*block, start[i - 1], count[i - 1]);
     totalRemoved += count[i - 1];
   }
   if (verbose_)
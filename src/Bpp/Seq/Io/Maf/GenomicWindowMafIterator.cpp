@@ -0,0 +1,266 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "GenomicWindowMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+
+using namespace bpp;
+
+// From the STL:
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+unique_ptr<MafBlock> GenomicWindowMafIterator::analyseCurrentBlock_()
+{
+  // Add columns to the current window, until it is complete:
+  bool complete = false;
+  bool endOfChromosome = false;
+  while (!complete && !endOfChromosome)
+  {
+    if (!block_ || blockPos_ == block_->getNumberOfSites())
+    {
+      block_ = nextReferenceBlock_();
+      blockPos_ = 0;
+      if (!block_)
+      {
+        endOfChromosome = true;
+        break;
+      }
+    }
+    if (blockPos_ == 0)
+    {
+      const MafSequence& refSeq = block_->sequenceForSpecies(refSpecies_);
+      if (refSeq.getChromosome() != chromosome_)
+      {
+        if (!refPositions_.empty())
+        {
+          // Output the remaining windows of the previous chromosome first:
+          endOfChromosome = true;
+          break;
+        }
+        chromosome_ = refSeq.getChromosome();
+        refSrcSize_ = refSeq.getSrcSize();
+        windowStart_ = 0;
+        columns_.clear();
+        names_.clear();
+        if (logstream_)
+        {
+          (*logstream_ << "GENOMIC WINDOWS: starting chromosome " << chromosome_ << ".").endLine();
+        }
+      }
+      else if (refSeq.start() < refPos_)
+      {
+        throw Exception("GenomicWindowMafIterator::analyseCurrentBlock_. Blocks are not sorted according to the reference sequence: " + refSeq.getDescription() + ".");
+      }
+      refPos_ = refSeq.start();
+    }
+    complete = addColumns_();
+  }
+
+  if (refPositions_.empty())
+    return nullptr; // No more block.
+
+  auto window = buildWindow_();
+  if (logstream_)
+  {
+    (*logstream_ << "GENOMIC WINDOWS: window " << chromosome_ << ":" << windowStart_ << "-" << (windowStart_ + windowSize_) << " built with " << window->getNumberOfSites() << " columns.").endLine();
+  }
+  slide_(windowStart_ + windowStep_);
+  return window;
+}
+
+unique_ptr<MafBlock> GenomicWindowMafIterator::nextReferenceBlock_()
+{
+  auto block = iterator_->nextBlock();
+  while (block && !block->hasSequenceForSpecies(refSpecies_))
+  {
+    if (logstream_)
+    {
+      (*logstream_ << "GENOMIC WINDOWS: block " << block->getDescription() << " does not contain the reference species and was discarded.").endLine();
+    }
+    block = iterator_->nextBlock();
+  }
+  if (block && block->sequenceForSpecies(refSpecies_).getStrand() == '-')
+    throw Exception("GenomicWindowMafIterator::nextReferenceBlock_. Reference sequence should be on the positive strand: " + block->sequenceForSpecies(refSpecies_).getDescription() + ".");
+  return block;
+}
+
+bool GenomicWindowMafIterator::addColumns_()
+{
+  const MafSequence& refSeq = block_->sequenceForSpecies(refSpecies_);
+  int gap = refSeq.getAlphabet()->getGapCharacterCode();
+
+  // New species are completed with gaps on the left:
+  for (size_t j = 0; j < block_->getNumberOfSequences(); ++j)
+  {
+    const MafSequence& seq = block_->sequence(j);
+    if (columns_.find(seq.getSpecies()) == columns_.end())
+    {
+      columns_[seq.getSpecies()] = deque<int>(refPositions_.size(), gap);
+      names_[seq.getSpecies()] = seq.getName();
+    }
+  }
+  // Species missing in the block are completed with gaps:
+  vector<pair<deque<int>*, const vector<int>*>> rows;
+  for (auto& it : columns_)
+  {
+    const vector<int>* content = block_->hasSequenceForSpecies(it.first) ? &block_->sequenceForSpecies(it.first).getContent() : nullptr;
+    rows.push_back(make_pair(&it.second, content));
+  }
+
+  const MafColumnMask* mask = MafColumnMask::getColumnMask(*block_);
+  const vector<int>& ref = refSeq.getContent();
+  size_t nc = ref.size();
+  size_t firstPos = blockPos_;
+  bool complete = false;
+  for ( ; blockPos_ < nc; ++blockPos_)
+  {
+    if (refPos_ >= windowStart_ + windowSize_)
+    {
+      if (!refPositions_.empty())
+      {
+        complete = true;
+        break;
+      }
+      // Nothing to output before this position, we move to the first window containing it:
+      windowStart_ = refPos_ >= windowSize_ ? ((refPos_ - windowSize_) / windowStep_ + 1) * windowStep_ : 0;
+    }
+    if (refPos_ >= windowStart_)
+    {
+      // Otherwise, the column is between two windows and is ignored.
+      refPositions_.push_back(refPos_);
+      excludedColumns_.push_back(mask && mask->isExcluded(blockPos_));
+      for (auto& row : rows)
+      {
+        row.first->push_back(row.second ? (*row.second)[blockPos_] : gap);
+      }
+    }
+    if (ref[blockPos_] != gap)
+      refPos_++;
+  }
+  if (progress_)
+    progress_->addSites(blockPos_ - firstPos);
+  return complete;
+}
+
+unique_ptr<MafBlock> GenomicWindowMafIterator::buildWindow_()
+{
+  int gap = AlphabetTools::DNA_ALPHABET->getGapCharacterCode();
+  auto window = make_unique<MafBlock>();
+  // The reference sequence comes first:
+  auto refSeq = make_unique<MafSequence>(names_[refSpecies_], string(), refPositions_.front(), '+', refSrcSize_);
+  const deque<int>& refRow = columns_[refSpecies_];
+  refSeq->setContent(vector<int>(refRow.begin(), refRow.end()));
+  window->addSequence(refSeq);
+  for (auto it = columns_.begin(); it != columns_.end(); )
+  {
+    const deque<int>& row = it->second;
+    if (it->first == refSpecies_)
+    {
+      ++it;
+      continue;
+    }
+    if (all_of(row.begin(), row.end(), [gap](int x) { return x == gap; }))
+    {
+      // This species is absent from the window:
+      names_.erase(it->first);
+      it = columns_.erase(it);
+      continue;
+    }
+    auto seq = make_unique<MafSequence>(names_[it->first], string());
+    seq->setContent(vector<int>(row.begin(), row.end()));
+    window->addSequence(seq);
+    ++it;
+  }
+  if (find(excludedColumns_.begin(), excludedColumns_.end(), true) != excludedColumns_.end())
+  {
+    auto mask = make_unique<MafColumnMask>(excludedColumns_.size());
+    for (size_t i = 0; i < excludedColumns_.size(); ++i)
+    {
+      if (excludedColumns_[i])
+        mask->exclude(i, i + 1);
+    }
+    window->setProperty(MafColumnMask::PROPERTY, std::move(mask));
+  }
+  return window;
+}
+
+void GenomicWindowMafIterator::slide_(size_t newStart)
+{
+  windowStart_ = newStart;
+  while (!refPositions_.empty() && refPositions_.front() < windowStart_)
+  {
+    refPositions_.pop_front();
+    excludedColumns_.pop_front();
+    for (auto& it : columns_)
+    {
+      it.second.pop_front();
+    }
+  }
+}
+
+void GenomicWindowMafIterator::saveState_(ostream& out)
+{
+  MafBlockSerializer::writeSize(out, block_ ? 1 : 0);
+  if (block_)
+  {
+    MafBlockSerializer::write(out, *block_);
+    MafBlockSerializer::writeSize(out, blockPos_);
+  }
+  MafBlockSerializer::writeString(out, chromosome_);
+  MafBlockSerializer::writeSize(out, refSrcSize_);
+  MafBlockSerializer::writeSize(out, refPos_);
+  MafBlockSerializer::writeSize(out, windowStart_);
+  MafBlockSerializer::writeSize(out, refPositions_.size());
+  for (size_t pos : refPositions_)
+  {
+    MafBlockSerializer::writeSize(out, pos);
+  }
+  // The buffered columns are stored as a block:
+  if (!refPositions_.empty())
+    MafBlockSerializer::write(out, *buildWindow_());
+}
+
+void GenomicWindowMafIterator::restoreState_(istream& in)
+{
+  block_.reset();
+  blockPos_ = 0;
+  if (MafBlockSerializer::readSize(in) == 1)
+  {
+    block_ = MafBlockSerializer::read(in);
+    blockPos_ = MafBlockSerializer::readSize(in);
+  }
+  chromosome_ = MafBlockSerializer::readString(in);
+  refSrcSize_ = MafBlockSerializer::readSize(in);
+  refPos_ = MafBlockSerializer::readSize(in);
+  windowStart_ = MafBlockSerializer::readSize(in);
+  refPositions_.resize(MafBlockSerializer::readSize(in));
+  for (auto& pos : refPositions_)
+  {
+    pos = MafBlockSerializer::readSize(in);
+  }
+  excludedColumns_.assign(refPositions_.size(), false);
+  columns_.clear();
+  names_.clear();
+  if (!refPositions_.empty())
+  {
+    auto buffer = MafBlockSerializer::read(in);
+    // The buffered columns were stored together with their column mask:
+    const MafColumnMask* mask = MafColumnMask::getColumnMask(*buffer);
+    for (size_t i = 0; mask && i < excludedColumns_.size(); ++i)
+    {
+      excludedColumns_[i] = mask->isExcluded(i);
+    }
+    for (size_t j = 0; j < buffer->getNumberOfSequences(); ++j)
+    {
+      const MafSequence& seq = buffer->sequence(j);
+      columns_[seq.getSpecies()] = deque<int>(seq.getContent().begin(), seq.getContent().end());
+      names_[seq.getSpecies()] = seq.getName();
+    }
+  }
+}
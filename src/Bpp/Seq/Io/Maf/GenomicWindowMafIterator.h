@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _GENOMICWINDOWMAFITERATOR_H_
+#define _GENOMICWINDOWMAFITERATOR_H_
+
+#include "AbstractMafIterator.h"
+
+// From the STL:
+#include <iostream>
+#include <string>
+#include <deque>
+#include <map>
+#include <memory>
+
+namespace bpp
+{
+/**
+ * @brief Build windows of fixed size in reference genome coordinates, spanning consecutive blocks.
+ *
+ * Windows start every windowStep positions of the reference chromosome, and contain all alignment columns
+ * falling within windowSize positions. Columns where the reference sequence has a gap belong to the same window
+ * as the next reference position. Windows do not span chromosomes, and windows without any column are not output.
+ *
+ * Columns are added to a buffer as blocks are read, and removed as soon as the window moves past them,
+ * so that memory is bounded by the window size, not the size of blocks or chromosomes.
+ * Species missing in a block are completed with gaps, and species with only gaps in a window are not output.
+ * Only the reference sequence keeps its coordinates, the other sequences possibly coming from different blocks.
+ * Columns excluded by the column mask of a block (see MafColumnMask) remain excluded in the windows.
+ *
+ * Input blocks must be sorted according to the reference sequence, which should be on the positive strand.
+ * Blocks without the reference species are discarded.
+ */
+class GenomicWindowMafIterator :
+  public AbstractFilterMafIterator
+{
+private:
+  std::string refSpecies_;
+  size_t windowSize_;
+  size_t windowStep_;
+  std::unique_ptr<MafBlock> block_;
+  size_t blockPos_;
+  std::string chromosome_;
+  size_t refSrcSize_;
+  size_t refPos_;
+  size_t windowStart_;
+  std::deque<size_t> refPositions_;
+  std::deque<bool> excludedColumns_;
+  std::map<std::string, std::deque<int>> columns_;
+  std::map<std::string, std::string> names_;
+
+public:
+  /**
+   * @param iterator The input iterator.
+   * @param refSpecies The species used as a reference for coordinates.
+   * @param windowSize The size of windows, in positions of the reference sequence.
+   * @param windowStep The distance between the start of two consecutive windows, in positions of the reference sequence.
+   */
+  GenomicWindowMafIterator(
+      std::shared_ptr<MafIteratorInterface> iterator,
+      const std::string& refSpecies,
+      size_t windowSize,
+      size_t windowStep) :
+    AbstractFilterMafIterator(iterator),
+    refSpecies_(refSpecies),
+    windowSize_(windowSize),
+    windowStep_(windowStep),
+    block_(),
+    blockPos_(0),
+    chromosome_(),
+    refSrcSize_(0),
+    refPos_(0),
+    windowStart_(0),
+    refPositions_(),
+    excludedColumns_(),
+    columns_(),
+    names_()
+  {
+    if (windowSize == 0)
+      throw Exception("GenomicWindowMafIterator: window size should be at least 1.");
+    if (windowStep == 0)
+      throw Exception("GenomicWindowMafIterator: window step should be at least 1.");
+  }
+
+private:
+  std::unique_ptr<MafBlock> analyseCurrentBlock_();
+
+  /**
+   * @return The next block containing the reference species, or nullptr if there is no more block.
+   */
+  std::unique_ptr<MafBlock> nextReferenceBlock_();
+
+  /**
+   * @brief Add columns of the current block to the buffer, until one falls after the end of the current window.
+   *
+   * @return True if the window is complete, false if more blocks are needed.
+   */
+  bool addColumns_();
+
+  /**
+   * @return A new block with the content of the buffer.
+   */
+  std::unique_ptr<MafBlock> buildWindow_();
+
+  /**
+   * @brief Move the window, and remove the columns before its new start.
+   */
+  void slide_(size_t newStart);
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
+};
+} // end of namespace bpp.
+
+#endif // _GENOMICWINDOWMAFITERATOR_H_
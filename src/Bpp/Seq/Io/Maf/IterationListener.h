@@ -7,6 +7,9 @@
 
 #include "MafBlock.h"
 
+// From the STL:
+#include <iostream>
+
 namespace bpp
 {
 /**
@@ -21,6 +24,26 @@ public:
   virtual void iterationStarts() = 0;
   virtual void iterationMoves(const MafBlock& currentBlock) = 0;
   virtual void iterationStops() = 0;
+
+  /**
+   * @brief Save and restore the state of the listener, as part of a checkpoint of the iterator it listens to
+   * (see MafIteratorInterface::saveCheckpoint).
+   *
+   * Upon restoration, listeners are not notified again that iterations start, and have to resume their outputs
+   * where they were when the checkpoint was saved. As this cannot be done in general, the default implementation
+   * refuses checkpoints: listeners supporting them have to override both functions.
+   *
+   * @throw Exception If the listener does not support checkpoints.
+   */
+  virtual void saveState(std::ostream& out)
+  {
+    throw Exception("IterationListenerInterface::saveState. This listener does not support checkpoints.");
+  }
+
+  virtual void restoreState(std::istream& in)
+  {
+    throw Exception("IterationListenerInterface::restoreState. This listener does not support checkpoints.");
+  }
 };
 } // end of namespace bpp.
 
@@ -0,0 +1,303 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "LinkageDisequilibriumMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+#include "MafColumnCounts.h"
+
+// From bpp-seq:
+#include <Bpp/Seq/SequenceWalker.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <string>
+#include <bitset>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+using namespace std;
+
+const size_t LinkageDisequilibriumMafIterator::MIN_SNPS_PER_THREAD = 64;
+
+void LinkageDisequilibriumMafIterator::init_()
+{
+  if (species_.size() < 2)
+    throw Exception("LinkageDisequilibriumMafIterator. At least two species should be selected.");
+  if (binSize_ == 0)
+    throw Exception("LinkageDisequilibriumMafIterator. Bin size should be at least 1.");
+  if (nbThreads_ == 0)
+    nbThreads_ = max(1u, thread::hardware_concurrency());
+  size_t nbBins = maxDistance_ / binSize_ + 1;
+  sumR2_.assign(nbBins, 0.);
+  sumDPrime_.assign(nbBins, 0.);
+  nbPairs_.assign(nbBins, 0);
+  if (outputPairs_)
+    *outputPairs_ << "Chr\tPosition1\tPosition2\tDistance\tr2\tDprime" << endl;
+}
+
+void LinkageDisequilibriumMafIterator::parseBlock_(const MafBlock& block)
+{
+  vector<const vector<int>*> aln;
+  for (auto& species : species_)
+  {
+    if (block.hasSequenceForSpecies(species))
+    {
+      aln.push_back(&block.sequenceForSpecies(species).getContent());
+      // Note: in case of duplicates, this takes the first sequence.
+    }
+    else
+    {
+      // Block with missing species are ignored.
+      return;
+    }
+  }
+  // Get the reference species for coordinates:
+  if (!block.hasSequenceForSpecies(refSpecies_))
+    return;
+  const MafSequence& refSeq = block.sequenceForSpecies(refSpecies_);
+  string chr = refSeq.getChromosome();
+  if (chr != currentChr_)
+  {
+    // SNPs on distinct chromosomes are never compared:
+    currentChr_ = chr;
+    window_.clear();
+  }
+  else if (refSeq.start() < lastPosition_)
+  {
+    throw Exception("LinkageDisequilibriumMafIterator: blocks are not projected according to reference sequence: " + refSeq.getDescription() + "<!>" + TextTools::toString(lastPosition_) + ".");
+  }
+  lastPosition_ = refSeq.stop();
+
+  SequenceWalker walker(refSeq);
+  size_t offset = refSeq.start();
+  int gap = refSeq.getAlphabet()->getGapCharacterCode();
+  size_t n = aln.size();
+  size_t nbWords = (n + 63) / 64;
+  vector<int> column(n);
+  MafNucleotideCounts counts;
+  // Columns excluded by a cleaning filter in annotate-only mode are skipped:
+  const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
+
+  // Now we shall scan all sites for SNPs:
+  newSnps_.clear();
+  for (size_t i = 0; i < block.getNumberOfSites(); ++i)
+  {
+    if (refSeq[i] == gap)
+      continue;
+    if (mask && mask->isExcluded(i))
+      continue;
+    for (size_t j = 0; j < n; ++j)
+    {
+      column[j] = (*aln[j])[i];
+    }
+    counts.count(column.data(), n);
+    // We call SNPs only at position without gap or unresolved characters, and for biallelic sites:
+    if (!counts.isComplete() || counts.getNumberOfAlleles() != 2)
+      continue;
+    int allele = 3;
+    while (counts.getCount(static_cast<size_t>(allele)) == 0)
+    {
+      allele--;
+    }
+    Snp_ snp;
+    snp.position = offset + walker.getSequencePosition(i) + 1;
+    snp.count = counts.getCount(static_cast<size_t>(allele));
+    snp.bits.assign(nbWords, 0);
+    for (size_t j = 0; j < n; ++j)
+    {
+      if (column[j] == allele)
+        snp.bits[j >> 6] |= uint64_t(1) << (j & 63);
+    }
+    newSnps_.push_back(std::move(snp));
+  }
+  if (newSnps_.empty())
+    return;
+
+  computePairs_();
+  addPairs_();
+
+  // Update the window, only keeping SNPs close enough to the last one:
+  for (auto& snp : newSnps_)
+  {
+    window_.push_back(std::move(snp));
+  }
+  newSnps_.clear();
+  size_t last = window_.back().position;
+  while (window_.front().position + maxDistance_ < last)
+  {
+    window_.pop_front();
+  }
+}
+
+void LinkageDisequilibriumMafIterator::computePairs_()
+{
+  // Each new SNP is compared to all previous ones within the maximum distance,
+  // from the window and from the current block. New SNPs are distributed over threads,
+  // additional threads being only started for blocks with enough SNPs.
+  size_t nbOld = window_.size();
+  size_t nbNew = newSnps_.size();
+  size_t n = species_.size();
+  auto getSnp = [&](size_t k) -> const Snp_&
+  {
+    return k < nbOld ? window_[k] : newSnps_[k - nbOld];
+  };
+  pairs_.resize(nbNew);
+  vector<exception_ptr> errors(nbNew);
+  atomic<size_t> nextSnp(0);
+  auto worker = [&]()
+  {
+    for (size_t i = nextSnp++; i < nbNew; i = nextSnp++)
+    {
+      try
+      {
+        vector<Pair_>& pairs = pairs_[i];
+        pairs.clear();
+        const Snp_& snp2 = newSnps_[i];
+        for (size_t k = nbOld + i; k > 0; --k)
+        {
+          const Snp_& snp1 = getSnp(k - 1);
+          if (snp2.position - snp1.position > maxDistance_)
+            break;
+          Pair_ pair;
+          pair.position1 = snp1.position;
+          pair.position2 = snp2.position;
+          computeLinkageDisequilibrium(snp1.bits, snp1.count, snp2.bits, snp2.count, n, pair.r2, pair.dPrime);
+          pairs.push_back(pair);
+        }
+      }
+      catch (...)
+      {
+        errors[i] = current_exception();
+      }
+    }
+  };
+  size_t nbThreads = min(static_cast<size_t>(nbThreads_), nbNew / MIN_SNPS_PER_THREAD);
+  vector<thread> pool;
+  for (size_t t = 1; t < nbThreads; ++t)
+  {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : pool)
+  {
+    t.join();
+  }
+  for (auto& error : errors)
+  {
+    if (error)
+      rethrow_exception(error);
+  }
+}
+
+void LinkageDisequilibriumMafIterator::addPairs_()
+{
+  // Pairs are sorted by second SNP, then by decreasing position of the first SNP:
+  for (size_t i = 0; i < newSnps_.size(); ++i)
+  {
+    for (const auto& pair : pairs_[i])
+    {
+      size_t distance = pair.position2 - pair.position1;
+      if (outputPairs_)
+        *outputPairs_ << currentChr_ << "\t" << pair.position1 << "\t" << pair.position2 << "\t" << distance << "\t" << pair.r2 << "\t" << pair.dPrime << endl;
+      size_t bin = distance / binSize_;
+      sumR2_[bin] += pair.r2;
+      sumDPrime_[bin] += pair.dPrime;
+      nbPairs_[bin]++;
+    }
+  }
+}
+
+void LinkageDisequilibriumMafIterator::computeLinkageDisequilibrium(
+    const vector<uint64_t>& bits1, unsigned int count1,
+    const vector<uint64_t>& bits2, unsigned int count2,
+    size_t n, double& r2, double& dPrime)
+{
+  size_t count12 = 0;
+  for (size_t w = 0; w < bits1.size(); ++w)
+  {
+    count12 += bitset<64>(bits1[w] & bits2[w]).count();
+  }
+  double nd = static_cast<double>(n);
+  double p1 = static_cast<double>(count1) / nd;
+  double p2 = static_cast<double>(count2) / nd;
+  double d = static_cast<double>(count12) / nd - p1 * p2;
+  double denom = p1 * (1. - p1) * p2 * (1. - p2);
+  r2 = denom > 0 ? d * d / denom : numeric_limits<double>::quiet_NaN();
+  double dMax = d < 0 ? min(p1 * p2, (1. - p1) * (1. - p2)) : min(p1 * (1. - p2), (1. - p1) * p2);
+  dPrime = dMax > 0 ? abs(d) / dMax : numeric_limits<double>::quiet_NaN();
+}
+
+double LinkageDisequilibriumMafIterator::getMeanR2(size_t i) const
+{
+  return nbPairs_[i] > 0 ? sumR2_[i] / static_cast<double>(nbPairs_[i]) : numeric_limits<double>::quiet_NaN();
+}
+
+double LinkageDisequilibriumMafIterator::getMeanDPrime(size_t i) const
+{
+  return nbPairs_[i] > 0 ? sumDPrime_[i] / static_cast<double>(nbPairs_[i]) : numeric_limits<double>::quiet_NaN();
+}
+
+void LinkageDisequilibriumMafIterator::writeDecaySummary(ostream& out) const
+{
+  out << "Distance\tNbPairs\tMeanR2\tMeanDprime" << endl;
+  for (size_t i = 0; i < nbPairs_.size(); ++i)
+  {
+    out << i * binSize_ << "\t" << nbPairs_[i] << "\t" << getMeanR2(i) << "\t" << getMeanDPrime(i) << endl;
+  }
+}
+
+void LinkageDisequilibriumMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, outputPairs_.get());
+  MafBlockSerializer::writeString(out, currentChr_);
+  MafBlockSerializer::writeSize(out, lastPosition_);
+  MafBlockSerializer::writeSize(out, decayWritten_ ? 1 : 0);
+  MafBlockSerializer::writeSize(out, window_.size());
+  for (const auto& snp : window_)
+  {
+    MafBlockSerializer::writeSize(out, snp.position);
+    MafBlockSerializer::writeSize(out, snp.count);
+    for (uint64_t word : snp.bits)
+    {
+      MafBlockSerializer::writeSize(out, static_cast<size_t>(word));
+    }
+  }
+  for (size_t i = 0; i < nbPairs_.size(); ++i)
+  {
+    MafBlockSerializer::writeSize(out, nbPairs_[i]);
+    MafBlockSerializer::writeDouble(out, sumR2_[i]);
+    MafBlockSerializer::writeDouble(out, sumDPrime_[i]);
+  }
+}
+
+void LinkageDisequilibriumMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, outputPairs_.get());
+  currentChr_   = MafBlockSerializer::readString(in);
+  lastPosition_ = MafBlockSerializer::readSize(in);
+  decayWritten_ = MafBlockSerializer::readSize(in) != 0;
+  size_t nbWords = (species_.size() + 63) / 64;
+  window_.resize(MafBlockSerializer::readSize(in));
+  for (auto& snp : window_)
+  {
+    snp.position = MafBlockSerializer::readSize(in);
+    snp.count = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+    snp.bits.resize(nbWords);
+    for (auto& word : snp.bits)
+    {
+      word = static_cast<uint64_t>(MafBlockSerializer::readSize(in));
+    }
+  }
+  for (size_t i = 0; i < nbPairs_.size(); ++i)
+  {
+    nbPairs_[i]   = MafBlockSerializer::readSize(in);
+    sumR2_[i]     = MafBlockSerializer::readDouble(in);
+    sumDPrime_[i] = MafBlockSerializer::readDouble(in);
+  }
+}
@@ -0,0 +1,235 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _LINKAGEDISEQUILIBRIUMMAFITERATOR_H_
+#define _LINKAGEDISEQUILIBRIUMMAFITERATOR_H_
+
+#include "AbstractMafIterator.h"
+
+// From the STL:
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+namespace bpp
+{
+/**
+ * @brief This iterator computes linkage disequilibrium (r² and D') between pairs of biallelic SNPs.
+ *
+ * SNPs are called as in PlinkOutputMafIterator: only sites without gap or unresolved character in the selected
+ * species, and with exactly two alleles, are used. Each sequence is considered as a haplotype, and each SNP is
+ * stored as a bit vector with one bit per haplotype, set for the second allele. The number of haplotypes carrying
+ * both second alleles of a pair of SNPs is then obtained by a bitwise 'and' followed by a population count.
+ *
+ * SNPs are positioned on the reference species, and all pairs of SNPs on the same chromosome separated by at most
+ * a given distance are compared. To do so, SNPs from previous blocks are kept in a sliding window, and blocks should
+ * be ordered according to the reference sequence. The pairs involving the SNPs of each block can be computed
+ * by several threads, provided the block contains enough SNPs (see MIN_SNPS_PER_THREAD).
+ *
+ * Results are written per pair of SNPs, and/or summarized as the decay of the mean r² and D' with distance,
+ * using bins of fixed size. The summary is written once, when the end of the input is reached, and is also available
+ * via getMeanR2() and getMeanDPrime().
+ */
+class LinkageDisequilibriumMafIterator :
+  public AbstractFilterMafIterator
+{
+private:
+  struct Snp_
+  {
+    size_t position;
+    unsigned int count; // Number of haplotypes carrying the second allele.
+    std::vector<uint64_t> bits;
+  };
+
+  struct Pair_
+  {
+    size_t position1;
+    size_t position2;
+    double r2;
+    double dPrime;
+  };
+
+  std::shared_ptr<std::ostream> outputPairs_;
+  std::shared_ptr<std::ostream> outputDecay_;
+  std::vector<std::string> species_;
+  std::string refSpecies_;
+  size_t maxDistance_;
+  size_t binSize_;
+  unsigned int nbThreads_;
+  std::string currentChr_;
+  size_t lastPosition_;
+  std::deque<Snp_> window_;
+  std::vector<Snp_> newSnps_;
+  std::vector<std::vector<Pair_>> pairs_;
+  std::vector<double> sumR2_;
+  std::vector<double> sumDPrime_;
+  std::vector<size_t> nbPairs_;
+  bool decayWritten_;
+
+public:
+  /**
+   * @brief Minimum number of new SNPs in a block for each thread used, so that small blocks are analysed
+   * without the cost of starting threads.
+   */
+  static const size_t MIN_SNPS_PER_THREAD;
+
+public:
+  /**
+   * @brief Build a new LinkageDisequilibriumMafIterator object.
+   *
+   * @param iterator The input iterator.
+   * @param outPairs The output stream where to write the LD of each pair of SNPs (can be null).
+   * @param outDecay The output stream where to write the decay summary at the end of the iteration (can be null).
+   * @param species A list of at least two species (haplotypes) to compute SNPs.
+   * Only blocks containing all these species will be used.
+   * In case one species is duplicated in a block, the first sequence will be used.
+   * @param reference The species to use as a reference for coordinates.
+   * It does not have to be one of the selected species on which SNPs are computed.
+   * @param maxDistance The maximum distance between two SNPs to compute LD (bp).
+   * @param binSize The size of distance bins in the decay summary (bp).
+   * @param nbThreads Maximum number of threads to use. If 0, the number of hardware threads is used.
+   */
+  LinkageDisequilibriumMafIterator(
+      std::shared_ptr<MafIteratorInterface> iterator,
+      std::shared_ptr<std::ostream> outPairs,
+      std::shared_ptr<std::ostream> outDecay,
+      const std::vector<std::string>& species,
+      const std::string& reference,
+      size_t maxDistance,
+      size_t binSize,
+      unsigned int nbThreads = 1) :
+    AbstractFilterMafIterator(iterator),
+    outputPairs_(outPairs),
+    outputDecay_(outDecay),
+    species_(species),
+    refSpecies_(reference),
+    maxDistance_(maxDistance),
+    binSize_(binSize),
+    nbThreads_(nbThreads),
+    currentChr_(""),
+    lastPosition_(0),
+    window_(),
+    newSnps_(),
+    pairs_(),
+    sumR2_(),
+    sumDPrime_(),
+    nbPairs_(),
+    decayWritten_(false)
+  {
+    init_();
+  }
+
+private:
+  LinkageDisequilibriumMafIterator(const LinkageDisequilibriumMafIterator& iterator) :
+    AbstractFilterMafIterator(0),
+    outputPairs_(iterator.outputPairs_),
+    outputDecay_(iterator.outputDecay_),
+    species_(iterator.species_),
+    refSpecies_(iterator.refSpecies_),
+    maxDistance_(iterator.maxDistance_),
+    binSize_(iterator.binSize_),
+    nbThreads_(iterator.nbThreads_),
+    currentChr_(iterator.currentChr_),
+    lastPosition_(iterator.lastPosition_),
+    window_(iterator.window_),
+    newSnps_(iterator.newSnps_),
+    pairs_(iterator.pairs_),
+    sumR2_(iterator.sumR2_),
+    sumDPrime_(iterator.sumDPrime_),
+    nbPairs_(iterator.nbPairs_),
+    decayWritten_(iterator.decayWritten_)
+  {}
+
+  LinkageDisequilibriumMafIterator& operator=(const LinkageDisequilibriumMafIterator& iterator)
+  {
+    outputPairs_  = iterator.outputPairs_;
+    outputDecay_  = iterator.outputDecay_;
+    species_      = iterator.species_;
+    refSpecies_   = iterator.refSpecies_;
+    maxDistance_  = iterator.maxDistance_;
+    binSize_      = iterator.binSize_;
+    nbThreads_    = iterator.nbThreads_;
+    currentChr_   = iterator.currentChr_;
+    lastPosition_ = iterator.lastPosition_;
+    window_       = iterator.window_;
+    newSnps_      = iterator.newSnps_;
+    pairs_        = iterator.pairs_;
+    sumR2_        = iterator.sumR2_;
+    sumDPrime_    = iterator.sumDPrime_;
+    nbPairs_      = iterator.nbPairs_;
+    decayWritten_ = iterator.decayWritten_;
+    return *this;
+  }
+
+public:
+  size_t getNumberOfBins() const { return nbPairs_.size(); }
+
+  size_t getBinSize() const { return binSize_; }
+
+  /**
+   * @return The number of pairs of SNPs with distance in [i * binSize, (i + 1) * binSize[.
+   */
+  size_t getNumberOfPairs(size_t i) const { return nbPairs_[i]; }
+
+  /**
+   * @return The mean r² of pairs of SNPs in a distance bin, or NaN if the bin is empty.
+   */
+  double getMeanR2(size_t i) const;
+
+  /**
+   * @return The mean D' of pairs of SNPs in a distance bin, or NaN if the bin is empty.
+   */
+  double getMeanDPrime(size_t i) const;
+
+  /**
+   * @brief Write the decay of LD with distance, one line per distance bin.
+   */
+  void writeDecaySummary(std::ostream& out) const;
+
+  /**
+   * @brief Compute the LD between two biallelic SNPs stored as bit vectors.
+   *
+   * @param bits1 The haplotypes carrying the second allele of the first SNP.
+   * @param count1 The number of bits set in bits1.
+   * @param bits2 The haplotypes carrying the second allele of the second SNP.
+   * @param count2 The number of bits set in bits2.
+   * @param n The number of haplotypes.
+   * @param r2 [out] The squared correlation of alleles.
+   * @param dPrime [out] The absolute value of D, normalized by its maximum given allele frequencies.
+   */
+  static void computeLinkageDisequilibrium(
+      const std::vector<uint64_t>& bits1, unsigned int count1,
+      const std::vector<uint64_t>& bits2, unsigned int count2,
+      size_t n, double& r2, double& dPrime);
+
+private:
+  std::unique_ptr<MafBlock> analyseCurrentBlock_()
+  {
+    currentBlock_ = iterator_->nextBlock();
+    if (currentBlock_)
+    {
+      parseBlock_(*currentBlock_);
+    }
+    else if (outputDecay_ && !decayWritten_)
+    {
+      writeDecaySummary(*outputDecay_);
+      decayWritten_ = true;
+    }
+    return std::move(currentBlock_);
+  }
+
+  void init_();
+  void parseBlock_(const MafBlock& block);
+  void computePairs_();
+  void addPairs_();
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
+};
+} // end of namespace bpp.
+
+#endif // _LINKAGEDISEQUILIBRIUMMAFITERATOR_H_
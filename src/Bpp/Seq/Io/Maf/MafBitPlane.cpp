@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafBitPlane.h"
+
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <bitset>
+#include <algorithm>
+
+using namespace std;
+
+size_t MafBitPlane::count(size_t begin, size_t end) const
+{
+  if (end > size_ || begin > end)
+    throw Exception("MafBitPlane::count. Invalid range [" + TextTools::toString(begin) + ", " + TextTools::toString(end) + "[.");
+  if (begin == end)
+    return 0;
+  size_t first = begin >> 6;
+  size_t last = (end - 1) >> 6;
+  uint64_t firstMask = ~uint64_t(0) << (begin & 63);
+  uint64_t lastMask = ~uint64_t(0) >> (63 - ((end - 1) & 63));
+  if (first == last)
+    return bitset<64>(words_[first] & firstMask & lastMask).count();
+  size_t n = bitset<64>(words_[first] & firstMask).count();
+  for (size_t w = first + 1; w < last; ++w)
+  {
+    n += bitset<64>(words_[w]).count();
+  }
+  n += bitset<64>(words_[last] & lastMask).count();
+  return n;
+}
+
+MafBitPlane MafBitPlane::fromStates(const vector<int>& content, int state1, int state2)
+{
+  MafBitPlane plane(content.size());
+  size_t n = content.size();
+  for (size_t w = 0; w < plane.words_.size(); ++w)
+  {
+    uint64_t word = 0;
+    size_t end = min(n, (w + 1) * 64);
+    for (size_t i = w * 64; i < end; ++i)
+    {
+      word |= static_cast<uint64_t>(content[i] == state1 || content[i] == state2) << (i & 63);
+    }
+    plane.words_[w] = word;
+  }
+  return plane;
+}
+
+MafBitPlane MafBitPlane::fromMask(const vector<bool>& mask)
+{
+  MafBitPlane plane(mask.size());
+  for (size_t i = 0; i < mask.size(); ++i)
+  {
+    if (mask[i])
+      plane.set(i);
+  }
+  return plane;
+}
+
+MafBitPlane MafBitPlane::fromWords(size_t size, const vector<uint64_t>& words)
+{
+  MafBitPlane plane(size);
+  if (words.size() != plane.words_.size())
+    throw Exception("MafBitPlane::fromWords. Number of words does not match the size of the plane.");
+  plane.words_ = words;
+  // Bits beyond the size are not part of the plane:
+  if (size % 64 != 0)
+    plane.words_.back() &= (uint64_t(1) << (size % 64)) - 1;
+  return plane;
+}
+
+size_t MafBitPlane::checkSizes_(const vector<const MafBitPlane*>& planes)
+{
+  size_t n = planes.empty() ? 0 : planes[0]->size();
+  for (auto plane : planes)
+  {
+    if (plane->size() != n)
+      throw Exception("MafBitPlane::checkSizes_. Planes have different sizes: " + TextTools::toString(plane->size()) + " and " + TextTools::toString(n) + ".");
+  }
+  return n;
+}
+
+void MafBitPlane::countColumns(const vector<const MafBitPlane*>& planes, vector<unsigned int>& counts)
+{
+  size_t n = checkSizes_(planes);
+  counts.assign(n, 0);
+  // Each counter is stored as a set of bit slices, slice b holding bit b of the 64 counters of a word:
+  size_t nbSlices = 1;
+  while ((size_t(1) << nbSlices) <= planes.size())
+  {
+    ++nbSlices;
+  }
+  vector<uint64_t> slices(nbSlices);
+  size_t nbWords = (n + 63) / 64;
+  for (size_t w = 0; w < nbWords; ++w)
+  {
+    fill(slices.begin(), slices.end(), 0);
+    uint64_t any = 0;
+    for (auto plane : planes)
+    {
+      // Ripple-carry addition of one bit to all counters at once:
+      uint64_t carry = plane->words_[w];
+      any |= carry;
+      for (size_t b = 0; b < nbSlices && carry; ++b)
+      {
+        uint64_t next = slices[b] & carry;
+        slices[b] ^= carry;
+        carry = next;
+      }
+    }
+    if (!any)
+      continue;
+    size_t end = min(n, (w + 1) * 64);
+    for (size_t i = w * 64; i < end; ++i)
+    {
+      unsigned int c = 0;
+      for (size_t b = 0; b < nbSlices; ++b)
+      {
+        c |= static_cast<unsigned int>((slices[b] >> (i & 63)) & 1) << b;
+      }
+      counts[i] = c;
+    }
+  }
+}
+
+MafBitPlane MafBitPlane::changes(const vector<const MafBitPlane*>& planes)
+{
+  size_t n = checkSizes_(planes);
+  MafBitPlane result(n);
+  for (auto plane : planes)
+  {
+    // Compare each bit with the previous one, carrying the last bit of the previous word:
+    uint64_t previous = 0;
+    for (size_t w = 0; w < result.words_.size(); ++w)
+    {
+      uint64_t word = plane->words_[w];
+      result.words_[w] |= word ^ ((word << 1) | previous);
+      previous = word >> 63;
+    }
+  }
+  if (n > 0)
+  {
+    result.reset(0);
+    // Clear bits beyond the end:
+    if (n & 63)
+      result.words_.back() &= ~uint64_t(0) >> (64 - (n & 63));
+  }
+  return result;
+}
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFBITPLANE_H_
+#define _MAFBITPLANE_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL:
+#include <vector>
+#include <cstdint>
+
+namespace bpp
+{
+/**
+ * @brief A bit-packed binary property of the sites of a sequence.
+ *
+ * One bit is stored per site, 64 sites per word. Bit planes are typically used to represent,
+ * for each species of a block, which positions are gaps, unknown characters or masked.
+ * Static functions then process all species at once, 64 columns at a time.
+ */
+class MafBitPlane
+{
+private:
+  size_t size_;
+  std::vector<uint64_t> words_;
+
+public:
+  MafBitPlane(size_t size = 0) :
+    size_(size),
+    words_((size + 63) / 64, 0)
+  {}
+
+public:
+  size_t size() const { return size_; }
+
+  const std::vector<uint64_t>& getWords() const { return words_; }
+
+  bool test(size_t i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+
+  void set(size_t i) { words_[i >> 6] |= uint64_t(1) << (i & 63); }
+
+  void reset(size_t i) { words_[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+  /**
+   * @return The number of bits set in the range [begin, end[.
+   */
+  size_t count(size_t begin, size_t end) const;
+
+  size_t count() const { return count(0, size_); }
+
+  /**
+   * @return A plane with bits set at positions where the content is equal to one of the two given states.
+   * @param content The sequence content.
+   * @param state1 The first state to look for.
+   * @param state2 The second state to look for (may be equal to state1).
+   */
+  static MafBitPlane fromStates(const std::vector<int>& content, int state1, int state2);
+
+  static MafBitPlane fromMask(const std::vector<bool>& mask);
+
+  /**
+   * @return A plane built from its packed representation, see getWords().
+   * @param size The number of bits in the plane.
+   * @param words The packed bits, 64 per word.
+   * @throw Exception If the number of words does not match the size.
+   */
+  static MafBitPlane fromWords(size_t size, const std::vector<uint64_t>& words);
+
+  /**
+   * @brief Compute, for each column, the number of planes with a bit set.
+   *
+   * Counts are accumulated 64 columns at a time using bit-sliced counters, so that the cost per plane
+   * is logarithmic in the number of planes rather than linear in the number of columns.
+   *
+   * @param planes The planes to consider, all of the same size.
+   * @param counts [out] The counts for each column.
+   * @throw Exception If planes have different sizes.
+   */
+  static void countColumns(const std::vector<const MafBitPlane*>& planes, std::vector<unsigned int>& counts);
+
+  /**
+   * @return A plane with a bit set for each column where at least one of the planes differs from the previous column.
+   * The bit of the first column is never set.
+   * @param planes The planes to consider, all of the same size.
+   * @throw Exception If planes have different sizes.
+   */
+  static MafBitPlane changes(const std::vector<const MafBitPlane*>& planes);
+
+private:
+  static size_t checkSizes_(const std::vector<const MafBitPlane*>& planes);
+};
+} // end of namespace bpp.
+
+#endif // _MAFBITPLANE_H_
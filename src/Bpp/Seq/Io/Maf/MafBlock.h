@@ -182,6 +182,27 @@ public:
     return selection;
   }
 
+  /**
+   * @brief Get read-only access to a selection of the content of the block, without copying it.
+   *
+   * The selected sequences are the same as the ones copied by getAlignment(species), in the same order,
+   * and remain valid as long as the block is not modified.
+   *
+   * @param species The list of species to select.
+   * @return Pointers toward all sequences of the given species.
+   */
+  std::vector<const MafSequence*> getSequencesForSpecies(const std::vector<std::string>& species) const
+  {
+    std::vector<const MafSequence*> selection;
+    for (size_t i = 0; i < getNumberOfSequences(); ++i)
+    {
+      const MafSequence* seq = &sequence(i);
+      if (VectorTools::contains(species, seq->getSpecies()))
+        selection.push_back(seq);
+    }
+    return selection;
+  }
+
   // Return the first sequence with the species name.
   std::unique_ptr<MafSequence> removeSequenceForSpecies(const std::string& species)
   {
@@ -302,6 +323,19 @@ public:
     properties_[property] = std::move(data);
   }
 
+  /**
+   * @return The names of all properties associated to this block.
+   */
+  std::vector<std::string> getPropertyNames() const
+  {
+    std::vector<std::string> names;
+    for (const auto& it : properties_)
+    {
+      names.push_back(it.first);
+    }
+    return names;
+  }
+
 private:
   using TemplateAlignedSequenceContainer::addSequence;
 
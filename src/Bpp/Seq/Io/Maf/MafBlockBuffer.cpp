@@ -0,0 +1,195 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafBlockBuffer.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+
+#include <Bpp/Seq/SequenceWithAnnotationTools.h>
+#include <Bpp/Seq/SequenceWithQuality.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+using namespace std;
+
+MafBlockBuffer::~MafBlockBuffer()
+{
+  if (spillFile_)
+  {
+    spillFile_->close();
+    std::remove(spillFilePath_.c_str());
+  }
+}
+
+void MafBlockBuffer::setMaxMemoryUsage(size_t maxMemoryUsage, const std::string& spillDirectory)
+{
+  if (spillFile_)
+    throw Exception("MafBlockBuffer::setMaxMemoryUsage. Budget can not be changed once blocks have been written to disk.");
+  maxMemoryUsage_ = maxMemoryUsage;
+  spillDirectory_ = spillDirectory;
+}
+
+void MafBlockBuffer::push_back(unique_ptr<MafBlock> block)
+{
+  size_t blockSize = estimateMemoryUsage(*block);
+  // Blocks go to disk as soon as one block has been spilled, so that the order is preserved:
+  if (spilledSizes_.empty() && (blocks_.empty() || memoryUsage_ + blockSize <= maxMemoryUsage_))
+  {
+    blocks_.push_back(std::move(block));
+    blockSizes_.push_back(blockSize);
+    memoryUsage_ += blockSize;
+  }
+  else
+  {
+    spill_(std::move(block), blockSize);
+  }
+}
+
+void MafBlockBuffer::pop_front()
+{
+  if (blocks_.empty())
+    throw Exception("MafBlockBuffer::pop_front. Buffer is empty.");
+  blocks_.pop_front();
+  memoryUsage_ -= blockSizes_.front();
+  blockSizes_.pop_front();
+  reload_();
+}
+
+void MafBlockBuffer::save(ostream& out)
+{
+  MafBlockSerializer::writeSize(out, size());
+  for (const auto& block : blocks_)
+  {
+    MafBlockSerializer::write(out, *block);
+  }
+  // Spilled blocks are read in turn, but left in place:
+  streamoff pos = readPosition_;
+  size_t pinnedIndex = 0;
+  for (size_t i = 0; i < spilledSizes_.size(); ++i)
+  {
+    spillFile_->seekg(pos);
+    if (spillFile_->get() == 1)
+    {
+      auto block = MafBlockSerializer::read(*spillFile_);
+      MafBlockSerializer::write(out, *block);
+    }
+    else
+    {
+      MafBlockSerializer::write(out, *pinnedBlocks_[pinnedIndex++]);
+    }
+    pos = spillFile_->tellg();
+  }
+}
+
+void MafBlockBuffer::restore(istream& in)
+{
+  clear_();
+  size_t n = MafBlockSerializer::readSize(in);
+  for (size_t i = 0; i < n; ++i)
+  {
+    push_back(MafBlockSerializer::read(in));
+  }
+}
+
+size_t MafBlockBuffer::estimateMemoryUsage(const MafBlock& block)
+{
+  size_t nbSites = block.getNumberOfSites();
+  size_t memory = sizeof(MafBlock);
+  for (size_t i = 0; i < block.getNumberOfSequences(); ++i)
+  {
+    const MafSequence& seq = block.sequence(i);
+    memory += sizeof(MafSequence) + seq.getName().size() + nbSites * sizeof(int);
+    if (seq.hasAnnotation(SequenceMask::MASK))
+      memory += nbSites / 8;
+    if (seq.hasAnnotation(SequenceQuality::QUALITY_SCORE))
+      memory += nbSites * sizeof(int);
+  }
+  if (block.hasProperty(MafColumnMask::PROPERTY))
+    memory += sizeof(MafColumnMask) + nbSites / 8;
+  return memory;
+}
+
+void MafBlockBuffer::spill_(unique_ptr<MafBlock> block, size_t blockSize)
+{
+  if (!spillFile_)
+    openSpillFile_();
+  spillFile_->seekp(writePosition_);
+  if (MafBlockSerializer::isSerializable(*block))
+  {
+    spillFile_->put(1);
+    MafBlockSerializer::write(*spillFile_, *block);
+    nbSpilledBlocks_++;
+  }
+  else
+  {
+    // The block stays in memory, we only record its position in the queue:
+    spillFile_->put(0);
+    pinnedBlocks_.push_back(std::move(block));
+  }
+  spillFile_->flush();
+  if (!*spillFile_)
+    throw IOException("MafBlockBuffer::spill_. Error while writing to temporary file " + spillFilePath_ + ".");
+  writePosition_ = spillFile_->tellp();
+  spilledSizes_.push_back(blockSize);
+}
+
+void MafBlockBuffer::reload_()
+{
+  while (!spilledSizes_.empty() && (blocks_.empty() || memoryUsage_ + spilledSizes_.front() <= maxMemoryUsage_))
+  {
+    spillFile_->seekg(readPosition_);
+    unique_ptr<MafBlock> block;
+    if (spillFile_->get() == 1)
+    {
+      block = MafBlockSerializer::read(*spillFile_);
+    }
+    else
+    {
+      block = std::move(pinnedBlocks_.front());
+      pinnedBlocks_.pop_front();
+    }
+    readPosition_ = spillFile_->tellg();
+    size_t blockSize = spilledSizes_.front();
+    spilledSizes_.pop_front();
+    blocks_.push_back(std::move(block));
+    blockSizes_.push_back(blockSize);
+    memoryUsage_ += blockSize;
+  }
+  if (spilledSizes_.empty())
+  {
+    // Nothing left on disk, the file can be overwritten from the start:
+    readPosition_ = 0;
+    writePosition_ = 0;
+  }
+}
+
+void MafBlockBuffer::openSpillFile_()
+{
+  filesystem::path dir = spillDirectory_.empty() ? filesystem::temp_directory_path() : filesystem::path(spillDirectory_);
+  random_device rd;
+  do
+  {
+    spillFilePath_ = (dir / ("bppmaf_buffer_" + TextTools::toString(rd()) + ".tmp")).string();
+  }
+  while (filesystem::exists(spillFilePath_));
+  spillFile_ = make_unique<fstream>(spillFilePath_, ios::in | ios::out | ios::trunc | ios::binary);
+  if (!*spillFile_)
+    throw IOException("MafBlockBuffer::openSpillFile_. Could not create temporary file " + spillFilePath_ + ".");
+}
+
+void MafBlockBuffer::clear_()
+{
+  blocks_.clear();
+  blockSizes_.clear();
+  memoryUsage_ = 0;
+  spilledSizes_.clear();
+  pinnedBlocks_.clear();
+  readPosition_ = 0;
+  writePosition_ = 0;
+}
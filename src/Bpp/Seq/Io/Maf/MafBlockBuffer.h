@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFBLOCKBUFFER_H_
+#define _MAFBLOCKBUFFER_H_
+
+#include "MafBlock.h"
+
+// From the STL:
+#include <string>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <limits>
+
+namespace bpp
+{
+/**
+ * @brief A first-in first-out queue of maf blocks with a memory budget.
+ *
+ * The buffer behaves like a std::deque of blocks restricted to push_back, front and pop_front.
+ * Blocks are kept in memory as long as the estimated memory usage of the buffer stays below the budget.
+ * Further blocks are written to a temporary binary file, and are read back in order as the buffer is emptied.
+ * The first block in the queue is always in memory. Blocks that cannot be serialized (see MafBlockSerializer)
+ * are never spilled, but still keep their rank in the queue.
+ *
+ * By default the budget is unlimited, and the buffer is a plain in-memory queue.
+ * The temporary file is created in the system temporary directory unless another one is specified,
+ * and is removed when the buffer is destroyed.
+ */
+class MafBlockBuffer
+{
+private:
+  std::deque<std::unique_ptr<MafBlock>> blocks_;
+  std::deque<size_t> blockSizes_;
+  size_t memoryUsage_;
+  size_t maxMemoryUsage_;
+  std::string spillDirectory_;
+  std::string spillFilePath_;
+  std::unique_ptr<std::fstream> spillFile_;
+  std::deque<size_t> spilledSizes_;
+  std::deque<std::unique_ptr<MafBlock>> pinnedBlocks_;
+  std::streamoff readPosition_;
+  std::streamoff writePosition_;
+  size_t nbSpilledBlocks_;
+
+public:
+  /**
+   * @param maxMemoryUsage Memory budget, in bytes, for the blocks kept in memory.
+   * @param spillDirectory Directory where to create the temporary file. An empty string means the system temporary directory.
+   */
+  MafBlockBuffer(size_t maxMemoryUsage = std::numeric_limits<size_t>::max(), const std::string& spillDirectory = "") :
+    blocks_(),
+    blockSizes_(),
+    memoryUsage_(0),
+    maxMemoryUsage_(maxMemoryUsage),
+    spillDirectory_(spillDirectory),
+    spillFilePath_(),
+    spillFile_(),
+    spilledSizes_(),
+    pinnedBlocks_(),
+    readPosition_(0),
+    writePosition_(0),
+    nbSpilledBlocks_(0)
+  {}
+
+  MafBlockBuffer(const MafBlockBuffer& buffer) = delete;
+  MafBlockBuffer& operator=(const MafBlockBuffer& buffer) = delete;
+
+  virtual ~MafBlockBuffer();
+
+public:
+  /**
+   * @brief Set the memory budget of the buffer.
+   *
+   * Blocks already in memory are not moved, the new budget applies to the next insertions.
+   *
+   * @param maxMemoryUsage Memory budget, in bytes.
+   * @param spillDirectory Directory where to create the temporary file. An empty string means the system temporary directory.
+   * @throw Exception If blocks have already been written to disk.
+   */
+  void setMaxMemoryUsage(size_t maxMemoryUsage, const std::string& spillDirectory = "");
+
+  size_t getMaxMemoryUsage() const { return maxMemoryUsage_; }
+
+  /**
+   * @return The estimated memory used by the blocks currently in memory.
+   */
+  size_t getMemoryUsage() const { return memoryUsage_; }
+
+  /**
+   * @return The total number of blocks that had to be written to disk since the creation of the buffer.
+   */
+  size_t getNumberOfSpilledBlocks() const { return nbSpilledBlocks_; }
+
+  size_t size() const { return blocks_.size() + spilledSizes_.size(); }
+
+  bool empty() const { return size() == 0; }
+
+  void push_back(std::unique_ptr<MafBlock> block);
+
+  std::unique_ptr<MafBlock>& front()
+  {
+    if (blocks_.empty())
+      throw Exception("MafBlockBuffer::front. Buffer is empty.");
+    return blocks_.front();
+  }
+
+  void pop_front();
+
+  /**
+   * @brief Write all blocks in the buffer to a binary stream, without removing them.
+   *
+   * @param out The output stream.
+   * @throw Exception If one of the blocks cannot be serialized.
+   */
+  void save(std::ostream& out);
+
+  /**
+   * @brief Replace the content of the buffer by blocks previously written with save().
+   *
+   * @param in The input stream.
+   */
+  void restore(std::istream& in);
+
+  /**
+   * @return A rough estimate of the memory occupied by a block, in bytes.
+   * @param block The block to consider.
+   */
+  static size_t estimateMemoryUsage(const MafBlock& block);
+
+private:
+  void spill_(std::unique_ptr<MafBlock> block, size_t blockSize);
+  void reload_();
+  void openSpillFile_();
+  void clear_();
+};
+} // end of namespace bpp.
+
+#endif // _MAFBLOCKBUFFER_H_
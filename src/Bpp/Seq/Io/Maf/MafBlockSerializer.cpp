@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+
+#include <Bpp/Seq/SequenceWithAnnotationTools.h>
+#include <Bpp/Seq/SequenceWithQuality.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <cstdint>
+
+using namespace std;
+
+bool MafBlockSerializer::isSerializable(const MafBlock& block)
+{
+  for (const auto& property : block.getPropertyNames())
+  {
+    if (property != MafColumnMask::PROPERTY)
+      return false;
+  }
+  for (size_t i = 0; i < block.getNumberOfSequences(); ++i)
+  {
+    for (const auto& type : block.sequence(i).getAnnotationTypes())
+    {
+      if (type != SequenceMask::MASK && type != SequenceQuality::QUALITY_SCORE)
+        return false;
+    }
+  }
+  return true;
+}
+
+void MafBlockSerializer::write(ostream& out, const MafBlock& block)
+{
+  if (!isSerializable(block))
+    throw Exception("MafBlockSerializer::write. Block " + block.getDescription() + " carries properties or annotations that cannot be serialized.");
+  writeDouble(out, block.getScore());
+  writeSize(out, block.getPass());
+  writeSize(out, block.getNumberOfSequences());
+  for (size_t i = 0; i < block.getNumberOfSequences(); ++i)
+  {
+    const MafSequence& seq = block.sequence(i);
+    writeString(out, seq.getName());
+    writeString(out, seq.toString());
+    writeSize(out, seq.hasCoordinates() ? 1 : 0);
+    writeSize(out, seq.hasCoordinates() ? seq.start() : 0);
+    out.put(seq.getStrand());
+    writeSize(out, seq.getSrcSize());
+
+    // Mask, packed as 8 positions per byte:
+    if (seq.hasAnnotation(SequenceMask::MASK))
+    {
+      const vector<bool>& mask = dynamic_cast<const SequenceMask&>(seq.annotation(SequenceMask::MASK)).getMask();
+      writeSize(out, mask.size() + 1);
+      for (size_t j = 0; j < mask.size(); j += 8)
+      {
+        unsigned char byte = 0;
+        for (size_t k = 0; k < 8 && j + k < mask.size(); ++k)
+        {
+          if (mask[j + k])
+            byte = static_cast<unsigned char>(byte | (1 << k));
+        }
+        out.put(static_cast<char>(byte));
+      }
+    }
+    else
+    {
+      writeSize(out, 0);
+    }
+
+    // Quality scores:
+    if (seq.hasAnnotation(SequenceQuality::QUALITY_SCORE))
+    {
+      const vector<int>& scores = dynamic_cast<const SequenceQuality&>(seq.annotation(SequenceQuality::QUALITY_SCORE)).getScores();
+      writeSize(out, scores.size() + 1);
+      for (int score : scores)
+      {
+        int32_t x = static_cast<int32_t>(score);
+        out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+      }
+    }
+    else
+    {
+      writeSize(out, 0);
+    }
+  }
+
+  // Column mask, with its size shifted by one as for sequence annotations:
+  const MafColumnMask* columnMask = MafColumnMask::getColumnMask(block);
+  if (columnMask)
+  {
+    writeSize(out, columnMask->getNumberOfColumns() + 1);
+    for (uint64_t word : columnMask->getBitPlane().getWords())
+    {
+      out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+    }
+  }
+  else
+  {
+    writeSize(out, 0);
+  }
+  if (!out)
+    throw IOException("MafBlockSerializer::write. Error while writing block " + block.getDescription() + ".");
+}
+
+unique_ptr<MafBlock> MafBlockSerializer::read(istream& in)
+{
+  auto block = make_unique<MafBlock>();
+  block->setScore(readDouble(in));
+  block->setPass(static_cast<unsigned int>(readSize(in)));
+  size_t nbSeq = readSize(in);
+  for (size_t i = 0; i < nbSeq; ++i)
+  {
+    string name = readString(in);
+    string content = readString(in);
+    bool hasCoordinates = readSize(in) == 1;
+    size_t begin = readSize(in);
+    char strand = static_cast<char>(in.get());
+    size_t srcSize = readSize(in);
+    checkStream_(in);
+    auto seq = make_unique<MafSequence>(name, content, begin, strand, srcSize);
+    if (!hasCoordinates)
+      seq->removeCoordinates();
+
+    // Annotation sizes are shifted by one, so that an empty annotation can be distinguished from no annotation.
+    size_t maskSize = readSize(in);
+    if (maskSize > 0)
+    {
+      vector<bool> mask(maskSize - 1);
+      for (size_t j = 0; j < mask.size(); j += 8)
+      {
+        int byte = in.get();
+        for (size_t k = 0; k < 8 && j + k < mask.size(); ++k)
+        {
+          mask[j + k] = (byte >> k) & 1;
+        }
+      }
+      checkStream_(in);
+      seq->addAnnotation(make_shared<SequenceMask>(mask));
+    }
+
+    size_t qualSize = readSize(in);
+    if (qualSize > 0)
+    {
+      vector<int> scores(qualSize - 1);
+      for (size_t j = 0; j < scores.size(); ++j)
+      {
+        int32_t x;
+        in.read(reinterpret_cast<char*>(&x), sizeof(x));
+        scores[j] = static_cast<int>(x);
+      }
+      checkStream_(in);
+      seq->addAnnotation(make_shared<SequenceQuality>(scores));
+    }
+    block->addSequence(seq);
+  }
+
+  size_t nbColumns = readSize(in);
+  if (nbColumns > 0)
+  {
+    nbColumns--;
+    if (nbColumns != static_cast<size_t>(block->getNumberOfSites()))
+      throw IOException("MafBlockSerializer::read. Column mask does not match the size of the block.");
+    vector<uint64_t> words((nbColumns + 63) / 64);
+    in.read(reinterpret_cast<char*>(words.data()), static_cast<streamsize>(words.size() * sizeof(uint64_t)));
+    checkStream_(in);
+    block->setProperty(MafColumnMask::PROPERTY, make_unique<MafColumnMask>(MafBitPlane::fromWords(nbColumns, words)));
+  }
+  return block;
+}
+
+void MafBlockSerializer::writeSize(ostream& out, size_t n)
+{
+  uint64_t x = static_cast<uint64_t>(n);
+  out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+
+size_t MafBlockSerializer::readSize(istream& in)
+{
+  uint64_t x = 0;
+  in.read(reinterpret_cast<char*>(&x), sizeof(x));
+  checkStream_(in);
+  return static_cast<size_t>(x);
+}
+
+void MafBlockSerializer::writeDouble(ostream& out, double x)
+{
+  out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+
+double MafBlockSerializer::readDouble(istream& in)
+{
+  double x = 0;
+  in.read(reinterpret_cast<char*>(&x), sizeof(x));
+  checkStream_(in);
+  return x;
+}
+
+void MafBlockSerializer::writeString(ostream& out, const string& s)
+{
+  writeSize(out, s.size());
+  out.write(s.data(), static_cast<streamsize>(s.size()));
+}
+
+string MafBlockSerializer::readString(istream& in)
+{
+  size_t n = readSize(in);
+  string s(n, ' ');
+  in.read(&s[0], static_cast<streamsize>(n));
+  checkStream_(in);
+  return s;
+}
+
+void MafBlockSerializer::checkStream_(istream& in)
+{
+  if (!in)
+    throw IOException("MafBlockSerializer::read. Unexpected end of stream or corrupted data.");
+}
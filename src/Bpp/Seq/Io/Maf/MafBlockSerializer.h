@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFBLOCKSERIALIZER_H_
+#define _MAFBLOCKSERIALIZER_H_
+
+#include "MafBlock.h"
+
+// From the STL:
+#include <iostream>
+#include <string>
+#include <memory>
+
+namespace bpp
+{
+/**
+ * @brief Binary (de)serialization of maf blocks.
+ *
+ * This is a compact, non-portable format meant for temporary storage
+ * (buffers spilled to disk, checkpoints) and read back on the same machine.
+ * Sequence names, coordinates and content are stored, together with the block score and pass,
+ * the mask and quality annotations of the sequences, and the column mask of the block (see MafColumnMask).
+ * Other block properties and annotations are not supported, use isSerializable() to check
+ * whether a block can be stored without loss of information.
+ *
+ * The low-level functions used to store integers and strings are exposed so that they can be reused
+ * to store additional data in the same stream.
+ */
+class MafBlockSerializer
+{
+public:
+  /**
+   * @return True if the block can be written and read back without loss of information.
+   * @param block The block to check.
+   */
+  static bool isSerializable(const MafBlock& block);
+
+  /**
+   * @brief Write a block to a binary stream.
+   *
+   * @param out The output stream.
+   * @param block The block to write.
+   * @throw Exception If the block carries data that cannot be serialized.
+   */
+  static void write(std::ostream& out, const MafBlock& block);
+
+  /**
+   * @brief Read a block from a binary stream.
+   *
+   * @param in The input stream.
+   * @return A new block.
+   * @throw IOException If the stream is truncated or corrupted.
+   */
+  static std::unique_ptr<MafBlock> read(std::istream& in);
+
+  static void writeSize(std::ostream& out, size_t n);
+  static size_t readSize(std::istream& in);
+  static void writeDouble(std::ostream& out, double x);
+  static double readDouble(std::istream& in);
+  static void writeString(std::ostream& out, const std::string& s);
+  static std::string readString(std::istream& in);
+
+private:
+  static void checkStream_(std::istream& in);
+};
+} // end of namespace bpp.
+
+#endif // _MAFBLOCKSERIALIZER_H_
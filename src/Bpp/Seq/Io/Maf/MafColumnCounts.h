@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFCOLUMNCOUNTS_H_
+#define _MAFCOLUMNCOUNTS_H_
+
+// From the STL:
+#include <array>
+#include <vector>
+#include <algorithm>
+
+namespace bpp
+{
+/**
+ * @brief Counts of the states in a column, for an alphabet with N resolved states.
+ *
+ * Resolved states are coded from 0 to N-1 and counted in a fixed-size array.
+ * Gaps (coded -1, as in all Bio++ alphabets) and unresolved states (all other codes)
+ * are only counted as a whole. The alphabet size being a template parameter,
+ * the counting loop is fully specialized for nucleotides (see MafNucleotideCounts).
+ */
+template<size_t N>
+class MafColumnCounts
+{
+private:
+  std::array<unsigned int, N> counts_;
+  unsigned int nbGaps_;
+  unsigned int nbUnresolved_;
+
+public:
+  MafColumnCounts() :
+    counts_(),
+    nbGaps_(0),
+    nbUnresolved_(0)
+  {
+    counts_.fill(0);
+  }
+
+public:
+  void clear()
+  {
+    counts_.fill(0);
+    nbGaps_ = 0;
+    nbUnresolved_ = 0;
+  }
+
+  /**
+   * @brief Add the states of a column to the counts.
+   *
+   * @param column A pointer toward the states of the column.
+   * @param n The number of states in the column.
+   */
+  void add(const int* column, size_t n)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      int state = column[j];
+      if (static_cast<unsigned int>(state) < N)
+        counts_[static_cast<size_t>(state)]++;
+      else if (state == -1)
+        nbGaps_++;
+      else
+        nbUnresolved_++;
+    }
+  }
+
+  /**
+   * @brief Reset the counts and count the states of a column.
+   */
+  void count(const int* column, size_t n)
+  {
+    clear();
+    add(column, n);
+  }
+
+  unsigned int getCount(size_t state) const { return counts_[state]; }
+
+  unsigned int getNumberOfGaps() const { return nbGaps_; }
+
+  unsigned int getNumberOfUnresolved() const { return nbUnresolved_; }
+
+  bool hasGap() const { return nbGaps_ > 0; }
+
+  /**
+   * @return True if the column contains neither gaps nor unresolved states.
+   */
+  bool isComplete() const { return nbGaps_ == 0 && nbUnresolved_ == 0; }
+
+  /**
+   * @return The number of distinct resolved states.
+   */
+  size_t getNumberOfAlleles() const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+      n += (counts_[i] > 0);
+    }
+    return n;
+  }
+
+  /**
+   * @return The number of distinct states, including gaps and unresolved states, observed more than once.
+   * This is the criterion used by SiteTools::isParsimonyInformativeSite.
+   *
+   * As unresolved states are only counted as a whole, the column is scanned again if it contains more than one of them.
+   * @param column A pointer toward the states of the column, as passed to count.
+   * @param n The number of states in the column.
+   */
+  size_t getNumberOfRepeatedStates(const int* column, size_t n) const
+  {
+    size_t nbRepeated = (nbGaps_ > 1);
+    for (size_t i = 0; i < N; ++i)
+    {
+      nbRepeated += (counts_[i] > 1);
+    }
+    if (nbUnresolved_ > 1)
+    {
+      std::vector<int> unresolved;
+      for (size_t j = 0; j < n; ++j)
+      {
+        if (column[j] != -1 && static_cast<unsigned int>(column[j]) >= N)
+          unresolved.push_back(column[j]);
+      }
+      std::sort(unresolved.begin(), unresolved.end());
+      for (size_t j = 1; j < unresolved.size(); ++j)
+      {
+        // Count each repeated state once, on its second occurrence:
+        if (unresolved[j] == unresolved[j - 1] && (j == 1 || unresolved[j - 1] != unresolved[j - 2]))
+          nbRepeated++;
+      }
+    }
+    return nbRepeated;
+  }
+};
+
+/**
+ * @brief State counts for nucleotide alphabets (DNA or RNA).
+ */
+typedef MafColumnCounts<4> MafNucleotideCounts;
+} // end of namespace bpp.
+
+#endif // _MAFCOLUMNCOUNTS_H_
@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafColumnMask.h"
+
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <string>
+
+using namespace std;
+
+const string MafColumnMask::PROPERTY = "ColumnMask";
+
+void MafColumnMask::exclude(size_t begin, size_t end)
+{
+  if (end > excluded_.size() || begin > end)
+    throw Exception("MafColumnMask::exclude. Invalid range [" + TextTools::toString(begin) + ", " + TextTools::toString(end) + "[.");
+  for (size_t i = begin; i < end; ++i)
+  {
+    excluded_.set(i);
+  }
+}
+
+vector<size_t> MafColumnMask::getKeptRegions() const
+{
+  vector<size_t> pos;
+  size_t n = excluded_.size();
+  size_t i = 0;
+  while (i < n)
+  {
+    while (i < n && excluded_.test(i))
+    {
+      ++i;
+    }
+    if (i == n)
+      break;
+    pos.push_back(i);
+    while (i < n && !excluded_.test(i))
+    {
+      ++i;
+    }
+    pos.push_back(i);
+  }
+  return pos;
+}
+
+unique_ptr<MafColumnMask> MafColumnMask::subMask(size_t begin, size_t end) const
+{
+  if (end > excluded_.size() || begin > end)
+    throw Exception("MafColumnMask::subMask. Invalid range [" + TextTools::toString(begin) + ", " + TextTools::toString(end) + "[.");
+  auto mask = make_unique<MafColumnMask>(end - begin);
+  for (size_t i = begin; i < end; ++i)
+  {
+    if (excluded_.test(i))
+      mask->excluded_.set(i - begin);
+  }
+  return mask;
+}
+
+void MafColumnMask::reverse()
+{
+  size_t n = excluded_.size();
+  MafBitPlane reversed(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (excluded_.test(i))
+      reversed.set(n - 1 - i);
+  }
+  excluded_ = reversed;
+}
+
+const MafColumnMask* MafColumnMask::getColumnMask(const MafBlock& block)
+{
+  if (!block.hasProperty(PROPERTY))
+    return nullptr;
+  auto mask = dynamic_cast<const MafColumnMask*>(&block.getProperty(PROPERTY));
+  if (mask && mask->getNumberOfColumns() != static_cast<size_t>(block.getNumberOfSites()))
+    throw Exception("MafColumnMask::getColumnMask. Column mask does not match the size of block " + block.getDescription() + ".");
+  return mask;
+}
+
+void MafColumnMask::setSubMask(MafBlock& region, const MafBlock& block, size_t begin, size_t end)
+{
+  const MafColumnMask* mask = getColumnMask(block);
+  if (mask)
+    region.setProperty(PROPERTY, mask->subMask(begin, end));
+}
+
+unique_ptr<MafColumnMask> MafColumnMask::concatenate(const MafBlock& block1, size_t spacerSize, const MafBlock& block2)
+{
+  const MafColumnMask* mask1 = getColumnMask(block1);
+  const MafColumnMask* mask2 = getColumnMask(block2);
+  if (!mask1 && !mask2)
+    return nullptr;
+  size_t n1 = static_cast<size_t>(block1.getNumberOfSites());
+  size_t n2 = static_cast<size_t>(block2.getNumberOfSites());
+  auto mask = make_unique<MafColumnMask>(n1 + spacerSize + n2);
+  for (size_t i = 0; mask1 && i < n1; ++i)
+  {
+    if (mask1->isExcluded(i))
+      mask->excluded_.set(i);
+  }
+  for (size_t i = 0; mask2 && i < n2; ++i)
+  {
+    if (mask2->isExcluded(i))
+      mask->excluded_.set(n1 + spacerSize + i);
+  }
+  return mask;
+}
+
+void MafColumnMask::deleteSites(MafBlock& block, size_t begin, size_t n)
+{
+  const MafColumnMask* mask = getColumnMask(block);
+  if (!mask)
+  {
+    block.deleteSites(begin, n);
+    return;
+  }
+  size_t nc = mask->getNumberOfColumns();
+  if (begin + n > nc)
+    throw Exception("MafColumnMask::deleteSites. Invalid range [" + TextTools::toString(begin) + ", " + TextTools::toString(begin + n) + "[.");
+  auto newMask = make_unique<MafColumnMask>(nc - n);
+  for (size_t i = 0; i < nc - n; ++i)
+  {
+    if (mask->isExcluded(i < begin ? i : i + n))
+      newMask->excluded_.set(i);
+  }
+  block.deleteSites(begin, n);
+  block.setProperty(PROPERTY, std::move(newMask));
+}
+
+void MafColumnMask::excludeRegions(MafBlock& block, const vector<size_t>& pos)
+{
+  size_t nc = static_cast<size_t>(block.getNumberOfSites());
+  const MafColumnMask* current = getColumnMask(block);
+  auto mask = current ? unique_ptr<MafColumnMask>(current->clone()) : make_unique<MafColumnMask>(nc);
+  for (size_t i = 0; i + 1 < pos.size(); i += 2)
+  {
+    mask->exclude(pos[i], pos[i + 1]);
+  }
+  block.setProperty(PROPERTY, std::move(mask));
+}
+
+void MafColumnMask::forEachKeptRegion(const MafBlock& block, const function<void(const MafBlock&)>& f)
+{
+  const MafColumnMask* mask = getColumnMask(block);
+  if (!mask)
+  {
+    f(block);
+    return;
+  }
+  vector<size_t> pos = mask->getKeptRegions();
+  for (size_t i = 0; i < pos.size(); i += 2)
+  {
+    MafBlock region;
+    region.setScore(block.getScore());
+    region.setPass(block.getPass());
+    for (size_t j = 0; j < block.getNumberOfSequences(); ++j)
+    {
+      auto subseq = block.sequence(j).subSequence(pos[i], pos[i + 1] - pos[i]);
+      region.addSequence(subseq);
+    }
+    f(region);
+  }
+}
+
+unique_ptr<MafBlock> MafColumnMask::compact(const MafBlock& block, const MafColumnMask& mask)
+{
+  if (mask.getNumberOfColumns() != static_cast<size_t>(block.getNumberOfSites()))
+    throw Exception("MafColumnMask::compact. Column mask does not match the size of block " + block.getDescription() + ".");
+  vector<size_t> pos = mask.getKeptRegions();
+  auto newBlock = make_unique<MafBlock>();
+  newBlock->setScore(block.getScore());
+  newBlock->setPass(block.getPass());
+  for (size_t j = 0; j < block.getNumberOfSequences(); ++j)
+  {
+    const MafSequence& seq = block.sequence(j);
+    const vector<int>& content = seq.getContent();
+    vector<int> kept;
+    kept.reserve(content.size() - mask.getNumberOfExcludedColumns());
+    for (size_t i = 0; i < pos.size(); i += 2)
+    {
+      kept.insert(kept.end(), content.begin() + static_cast<ptrdiff_t>(pos[i]), content.begin() + static_cast<ptrdiff_t>(pos[i + 1]));
+    }
+    size_t begin = 0;
+    if (seq.hasCoordinates())
+    {
+      begin = seq.start();
+      size_t first = pos.empty() ? content.size() : pos[0];
+      for (size_t i = 0; i < first; ++i)
+      {
+        if (!seq.getAlphabet()->isGap(content[i]))
+          begin++;
+      }
+    }
+    auto newSeq = make_unique<MafSequence>(seq.getName(), "", begin, seq.getStrand(), seq.getSrcSize());
+    newSeq->setContent(kept);
+    if (!seq.hasCoordinates())
+      newSeq->removeCoordinates();
+    newBlock->addSequence(newSeq);
+  }
+  return newBlock;
+}
@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFCOLUMNMASK_H_
+#define _MAFCOLUMNMASK_H_
+
+#include "MafBlock.h"
+#include "MafBitPlane.h"
+
+#include <Bpp/Clonable.h>
+
+// From the STL:
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace bpp
+{
+/**
+ * @brief A set of excluded columns, attached to a block as a property.
+ *
+ * Cleaning filters run in "annotate only" mode do not split blocks, but record the regions they would have
+ * removed in a column mask stored as the MafColumnMask::PROPERTY property of the block.
+ * Writers and statistics then ignore the excluded columns, so that the result is the same as if the block had been split,
+ * without the cost of copying every kept and removed region: column-wise writers and statistics skip excluded columns in place,
+ * and only writers which need contiguous blocks, such as MAF and alignment outputs, copy the kept regions (see forEachKeptRegion()).
+ */
+class MafColumnMask :
+  public virtual Clonable
+{
+private:
+  MafBitPlane excluded_;
+
+public:
+  static const std::string PROPERTY;
+
+public:
+  MafColumnMask(size_t nbColumns = 0) :
+    excluded_(nbColumns)
+  {}
+
+  /**
+   * @param excluded A plane with one bit set for each excluded column.
+   */
+  MafColumnMask(const MafBitPlane& excluded) :
+    excluded_(excluded)
+  {}
+
+  MafColumnMask* clone() const override { return new MafColumnMask(*this); }
+
+public:
+  size_t getNumberOfColumns() const { return excluded_.size(); }
+
+  size_t getNumberOfExcludedColumns() const { return excluded_.count(); }
+
+  /**
+   * @return True if column i is excluded. The position is not checked, see getColumnMask().
+   */
+  bool isExcluded(size_t i) const { return excluded_.test(i); }
+
+  const MafBitPlane& getBitPlane() const { return excluded_; }
+
+  /**
+   * @brief Exclude the columns [begin, end[.
+   */
+  void exclude(size_t begin, size_t end);
+
+  /**
+   * @return The kept regions, as a list of consecutive [begin, end[ pairs.
+   */
+  std::vector<size_t> getKeptRegions() const;
+
+  /**
+   * @return The mask restricted to the columns [begin, end[.
+   */
+  std::unique_ptr<MafColumnMask> subMask(size_t begin, size_t end) const;
+
+  /**
+   * @brief Reverse the order of the columns, as when a block is reverse complemented.
+   */
+  void reverse();
+
+  /**
+   * @return The column mask of a block, or nullptr if the block does not have one.
+   * @throw Exception If the mask does not have the same number of columns as the block,
+   * which happens when columns were added or removed without updating the mask.
+   */
+  static const MafColumnMask* getColumnMask(const MafBlock& block);
+
+  /**
+   * @brief Set the column mask of a region extracted from a block.
+   *
+   * @param region The block made of the columns [begin, end[ of the original block.
+   * @param block The original block. Nothing is done if it has no column mask.
+   * @param begin The first column of the region.
+   * @param end The column after the last column of the region.
+   */
+  static void setSubMask(MafBlock& region, const MafBlock& block, size_t begin, size_t end);
+
+  /**
+   * @return The column mask of the concatenation of two blocks, possibly separated by spacer columns,
+   * or nullptr if none of the blocks has a column mask. Columns of a block without column mask and spacer columns are kept.
+   *
+   * @param block1 The first block.
+   * @param spacerSize The number of columns inserted between the two blocks.
+   * @param block2 The second block.
+   */
+  static std::unique_ptr<MafColumnMask> concatenate(const MafBlock& block1, size_t spacerSize, const MafBlock& block2);
+
+  /**
+   * @brief Delete the columns [begin, begin + n[ of a block, and of its column mask if it has one.
+   */
+  static void deleteSites(MafBlock& block, size_t begin, size_t n);
+
+  /**
+   * @brief Exclude regions from a block, adding them to its column mask if it already has one.
+   *
+   * @param block The block to annotate.
+   * @param pos The bounds of the regions to exclude, as a list of consecutive [begin, end[ pairs.
+   */
+  static void excludeRegions(MafBlock& block, const std::vector<size_t>& pos);
+
+  /**
+   * @brief Apply a function to the kept regions of a block.
+   *
+   * If the block has no column mask, the function is called once on the block itself.
+   * Otherwise, it is called on a temporary copy of each kept region, in order.
+   */
+  static void forEachKeptRegion(const MafBlock& block, const std::function<void(const MafBlock&)>& f);
+
+  /**
+   * @return A copy of a block with the columns excluded by a mask removed.
+   * Kept regions are concatenated, and coordinates refer to the first kept column. Sequence annotations are not copied.
+   * This is only needed by analyses which cannot skip excluded columns in place.
+   */
+  static std::unique_ptr<MafBlock> compact(const MafBlock& block, const MafColumnMask& mask);
+};
+} // end of namespace bpp.
+
+#endif // _MAFCOLUMNMASK_H_
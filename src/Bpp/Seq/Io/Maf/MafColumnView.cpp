@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafColumnView.h"
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+
+using namespace std;
+
+vector<const MafSequence*> MafSpeciesSelection::getSequences(const MafBlock& block) const
+{
+  vector<const MafSequence*> rows;
+  if (noSpeciesMeansAllSpecies && species.empty())
+  {
+    for (size_t i = 0; i < block.getNumberOfSequences(); ++i)
+    {
+      rows.push_back(&block.sequence(i));
+    }
+  }
+  for (const auto& sp : species)
+  {
+    vector<const MafSequence*> seqs = block.getSequencesForSpecies(sp);
+    rows.insert(rows.end(), seqs.begin(), seqs.end());
+  }
+  return rows;
+}
+
+void MafColumnView::reset(const MafBlock& block, const MafSpeciesSelection& selection)
+{
+  vector<const MafSequence*> rows = selection.getSequences(block);
+  nbRows_ = rows.size();
+  nbColumns_ = static_cast<size_t>(block.getNumberOfSites());
+  names_.resize(nbRows_);
+  for (size_t j = 0; j < nbRows_; ++j)
+  {
+    names_[j] = rows[j]->getName();
+  }
+  states_.resize(nbRows_ * nbColumns_);
+  // Transpose by tiles of columns, so that both reads and writes stay in cache:
+  const size_t tile = 256;
+  for (size_t i0 = 0; i0 < nbColumns_; i0 += tile)
+  {
+    size_t i1 = min(nbColumns_, i0 + tile);
+    for (size_t j = 0; j < nbRows_; ++j)
+    {
+      const int* seq = rows[j]->getContent().data();
+      for (size_t i = i0; i < i1; ++i)
+      {
+        states_[i * nbRows_ + j] = seq[i];
+      }
+    }
+  }
+}
+
+MafColumnCursor::MafColumnCursor(const MafBlock& block) :
+  rows_(block.getNumberOfSequences()),
+  nbColumns_(static_cast<size_t>(block.getNumberOfSites())),
+  position_(0),
+  states_(),
+  counts_()
+{
+  for (size_t j = 0; j < rows_.size(); ++j)
+  {
+    rows_[j] = &block.sequence(j);
+  }
+  states_.resize(rows_.size());
+}
+
+MafColumnCursor::MafColumnCursor(const MafBlock& block, const MafSpeciesSelection& selection) :
+  rows_(selection.getSequences(block)),
+  nbColumns_(static_cast<size_t>(block.getNumberOfSites())),
+  position_(0),
+  states_(),
+  counts_()
+{
+  states_.resize(rows_.size());
+}
+
+void MafColumnCursor::moveTo(size_t i)
+{
+  if (i >= nbColumns_)
+    throw IndexOutOfBoundsException("MafColumnCursor::moveTo.", i, 0, nbColumns_ == 0 ? 0 : nbColumns_ - 1);
+  position_ = i;
+  for (size_t j = 0; j < rows_.size(); ++j)
+  {
+    states_[j] = rows_[j]->getContent()[i];
+  }
+  counts_.count(states_.data(), states_.size());
+}
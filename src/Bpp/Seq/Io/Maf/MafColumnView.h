@@ -0,0 +1,161 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFCOLUMNVIEW_H_
+#define _MAFCOLUMNVIEW_H_
+
+#include "MafBlock.h"
+#include "MafColumnCounts.h"
+
+// From the STL:
+#include <vector>
+#include <string>
+#include <tuple>
+
+namespace bpp
+{
+/**
+ * @brief A selection of species in a block.
+ *
+ * All sequences of each species are selected, in the order of the species list.
+ * If noSpeciesMeansAllSpecies is true and the list is empty, all sequences of the block are selected.
+ */
+struct MafSpeciesSelection
+{
+  std::vector<std::string> species;
+  bool noSpeciesMeansAllSpecies;
+
+  MafSpeciesSelection(const std::vector<std::string>& speciesList = std::vector<std::string>(), bool noSpeciesMeansAll = false) :
+    species(speciesList),
+    noSpeciesMeansAllSpecies(noSpeciesMeansAll)
+  {}
+
+  bool operator<(const MafSpeciesSelection& selection) const
+  {
+    return std::tie(noSpeciesMeansAllSpecies, species) < std::tie(selection.noSpeciesMeansAllSpecies, selection.species);
+  }
+
+  bool operator==(const MafSpeciesSelection& selection) const
+  {
+    return noSpeciesMeansAllSpecies == selection.noSpeciesMeansAllSpecies && species == selection.species;
+  }
+
+  /**
+   * @return The selected sequences of a block, in selection order.
+   */
+  std::vector<const MafSequence*> getSequences(const MafBlock& block) const;
+};
+
+/**
+ * @brief A site-major copy of the selected sequences of a block.
+ *
+ * The states of each column are stored contiguously, so that statistics computed site by site
+ * can read a column without building a Site object. A view is typically built once per block
+ * and shared by all statistics relying on the same species selection.
+ */
+class MafColumnView
+{
+private:
+  size_t nbRows_;
+  size_t nbColumns_;
+  std::vector<int> states_;
+  std::vector<std::string> names_;
+
+public:
+  MafColumnView() :
+    nbRows_(0),
+    nbColumns_(0),
+    states_(),
+    names_()
+  {}
+
+public:
+  /**
+   * @brief Fill the view with the sequences of a block.
+   *
+   * Memory is reused from one block to the other.
+   *
+   * @param block The block to read.
+   * @param selection The sequences to include.
+   */
+  void reset(const MafBlock& block, const MafSpeciesSelection& selection);
+
+  size_t getNumberOfRows() const { return nbRows_; }
+
+  size_t getNumberOfColumns() const { return nbColumns_; }
+
+  /**
+   * @return A pointer toward the getNumberOfRows() states of column i.
+   */
+  const int* column(size_t i) const { return states_.data() + i * nbRows_; }
+
+  /**
+   * @return The names of the selected sequences, in the order of the rows.
+   */
+  const std::vector<std::string>& getSequenceNames() const { return names_; }
+};
+
+/**
+ * @brief A cursor over the columns of a block, reading the sequences in place.
+ *
+ * Contrary to MafColumnView, nothing is copied when the cursor is created: the states of a column
+ * are gathered from the selected sequences when the cursor is moved to it, and counted at the same time.
+ * Per-site tests (gaps, unresolved states, number of alleles) are then answered without building Site objects.
+ * The cursor remains valid as long as the block is not modified.
+ */
+class MafColumnCursor
+{
+private:
+  std::vector<const MafSequence*> rows_;
+  size_t nbColumns_;
+  size_t position_;
+  std::vector<int> states_;
+  MafNucleotideCounts counts_;
+
+public:
+  /**
+   * @brief Build a cursor over all sequences of a block, in block order.
+   */
+  MafColumnCursor(const MafBlock& block);
+
+  /**
+   * @brief Build a cursor over a selection of sequences.
+   */
+  MafColumnCursor(const MafBlock& block, const MafSpeciesSelection& selection);
+
+public:
+  /**
+   * @brief Move the cursor to column i, which must be smaller than getNumberOfColumns().
+   */
+  void moveTo(size_t i);
+
+  size_t getPosition() const { return position_; }
+
+  size_t getNumberOfRows() const { return rows_.size(); }
+
+  size_t getNumberOfColumns() const { return nbColumns_; }
+
+  const MafSequence& getSequence(size_t j) const { return *rows_[j]; }
+
+  /**
+   * @return A pointer toward the getNumberOfRows() states of the current column.
+   */
+  const int* column() const { return states_.data(); }
+
+  int operator[](size_t j) const { return states_[j]; }
+
+  /**
+   * @return The counts of the states in the current column.
+   */
+  const MafNucleotideCounts& getCounts() const { return counts_; }
+
+  bool hasGap() const { return counts_.hasGap(); }
+
+  bool hasUnresolved() const { return counts_.getNumberOfUnresolved() > 0; }
+
+  bool isComplete() const { return counts_.isComplete(); }
+};
+} // end of namespace bpp.
+
+#endif // _MAFCOLUMNVIEW_H_
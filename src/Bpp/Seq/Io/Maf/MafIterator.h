@@ -7,6 +7,7 @@
 
 #include "MafBlock.h"
 #include "IterationListener.h"
+#include "MafProgressMonitor.h"
 
 // From the STL:
 #include <iostream>
@@ -36,6 +37,40 @@ public:
   virtual void setVerbose(bool yn) = 0;
 
   virtual void addIterationListener(std::unique_ptr<IterationListenerInterface> listener) = 0;
+
+  /**
+   * @brief Save the current state of the iterator to a binary stream.
+   *
+   * Filter iterators first save the state of their input iterator, so that calling this function on the last
+   * iterator of a pipeline saves the state of the whole pipeline. The checkpoint should be taken between two calls to nextBlock().
+   * The state of iteration listeners is saved as well, and all listeners have to support checkpoints
+   * (see IterationListenerInterface::saveState).
+   *
+   * @param out The stream where to write the checkpoint.
+   * @throw Exception If the state cannot be saved (for instance if the input stream does not support positioning).
+   */
+  virtual void saveCheckpoint(std::ostream& out) = 0;
+
+  /**
+   * @brief Restore the state of the iterator from a checkpoint.
+   *
+   * The pipeline has to be built in the exact same way as when the checkpoint was saved.
+   * Iteration is then considered as started, so that listeners are not notified a second time.
+   *
+   * @param in The stream where to read the checkpoint from.
+   * @throw Exception If the checkpoint does not match the pipeline.
+   */
+  virtual void restoreCheckpoint(std::istream& in) = 0;
+
+  /**
+   * @brief Attach a progress monitor to the iterator.
+   *
+   * Filter iterators forward the monitor to their input iterator, so that calling this function on the last
+   * iterator of a pipeline attaches the monitor to the whole pipeline.
+   *
+   * @param monitor The monitor to update, or a null pointer to detach the current one.
+   */
+  virtual void setProgressMonitor(std::shared_ptr<MafProgressMonitor> monitor) = 0;
 };
 
 
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "MafParser.h"
+#include "MafBlockSerializer.h"
 #include <Bpp/Seq/SequenceWithQuality.h>
 #include <Bpp/Seq/SequenceWithAnnotationTools.h>
 #include <Bpp/Text/TextTools.h>
@@ -178,6 +179,60 @@ std::unique_ptr<MafBlock> MafParser::analyseCurrentBlock_()
     block->addSequence(currentSequence);
   }
 
+  if (progress_ && block)
+  {
+    progress_->addBlocks();
+    streamoff pos = stream_->tellg();
+    if (pos >= 0)
+      progress_->setBytes(static_cast<size_t>(pos));
+  }
+
   // Returning block:
   return block;
 }
+
+void MafParser::saveState_(ostream& out)
+{
+  streamoff pos = stream_->tellg();
+  if (pos < 0 && stream_->eof())
+  {
+    // Once the end of the file is reached, tellg() fails until the stream state is cleared:
+    ios::iostate state = stream_->rdstate();
+    stream_->clear();
+    pos = stream_->tellg();
+    stream_->clear(state);
+  }
+  if (pos < 0)
+    throw Exception("MafParser::saveState_. Input stream does not support positioning, checkpoints are not available.");
+  MafBlockSerializer::writeSize(out, static_cast<size_t>(pos));
+  MafBlockSerializer::writeSize(out, firstBlock_ ? 1 : 0);
+}
+
+void MafParser::restoreState_(istream& in)
+{
+  size_t pos = MafBlockSerializer::readSize(in);
+  firstBlock_ = MafBlockSerializer::readSize(in) == 1;
+  stream_->clear();
+  stream_->seekg(static_cast<streamoff>(pos));
+  if (!*stream_)
+    throw IOException("MafParser::restoreState_. Could not reposition input stream.");
+}
+
+void MafParser::setProgressMonitor(shared_ptr<MafProgressMonitor> monitor)
+{
+  AbstractMafIterator::setProgressMonitor(monitor);
+  if (monitor && stream_)
+  {
+    streamoff pos = stream_->tellg();
+    if (pos >= 0)
+    {
+      stream_->seekg(0, ios::end);
+      streamoff end = stream_->tellg();
+      stream_->clear();
+      stream_->seekg(pos);
+      if (end >= 0)
+        monitor->setTotalBytes(static_cast<size_t>(end));
+      monitor->setBytes(static_cast<size_t>(pos));
+    }
+  }
+}
@@ -84,6 +84,18 @@ private:
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
 
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
+
+public:
+  /**
+   * @brief Attach a progress monitor.
+   *
+   * If the input stream can be positioned, its total size is passed to the monitor, so that the remaining time can be estimated.
+   */
+  void setProgressMonitor(std::shared_ptr<MafProgressMonitor> monitor);
+
 public:
   static constexpr short DOT_ERROR = 0;
   static constexpr short DOT_ASGAP = 1;
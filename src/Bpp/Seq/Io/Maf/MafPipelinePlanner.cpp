@@ -0,0 +1,402 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafPipelinePlanner.h"
+#include "SequenceFilterMafIterator.h"
+#include "BlockSizeMafIterator.h"
+#include "BlockLengthMafIterator.h"
+#include "AlignmentScoreFilterMafIterator.h"
+#include "ChromosomeMafIterator.h"
+#include "FullGapFilterMafIterator.h"
+#include "EntropyFilterMafIterator.h"
+#include "AlignmentFilterMafIterator.h"
+#include "MaskFilterMafIterator.h"
+#include "QualityFilterMafIterator.h"
+#include "WindowSplitMafIterator.h"
+#include "GenomicWindowMafIterator.h"
+
+#include <Bpp/Text/TextTools.h>
+#include <Bpp/Text/KeyvalTools.h>
+#include <Bpp/Text/StringTokenizer.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+
+using namespace std;
+
+const short MafPipelinePlanner::BARRIER = 0;
+const short MafPipelinePlanner::HEADER_PREDICATE = 1;
+const short MafPipelinePlanner::LENGTH_PREDICATE = 2;
+const short MafPipelinePlanner::COLUMN_FILTER = 3;
+
+MafPipelineStep MafPipelineStep::parse(const string& description)
+{
+  MafPipelineStep step;
+  KeyvalTools::parseProcedure(description, step.name, step.args);
+  return step;
+}
+
+string MafPipelineStep::toString() const
+{
+  string desc = name + "(";
+  for (auto it = args.begin(); it != args.end(); ++it)
+  {
+    if (it != args.begin())
+      desc += ", ";
+    desc += it->first + "=" + it->second;
+  }
+  return desc + ")";
+}
+
+string MafPipelineStep::getArgument(const string& key, const string& defaultValue) const
+{
+  auto it = args.find(key);
+  return it == args.end() ? defaultValue : it->second;
+}
+
+bool MafPipelineStep::getBooleanArgument(const string& key, bool defaultValue) const
+{
+  if (!hasArgument(key))
+    return defaultValue;
+  string value = TextTools::toLower(getArgument(key));
+  if (value == "yes" || value == "true" || value == "y" || value == "1")
+    return true;
+  if (value == "no" || value == "false" || value == "n" || value == "0")
+    return false;
+  throw Exception("MafPipelineStep::getBooleanArgument. Invalid boolean value for argument " + key + " in step " + name + ": " + value);
+}
+
+double MafPipelineStep::getDoubleArgument(const string& key, double defaultValue) const
+{
+  return hasArgument(key) ? TextTools::toDouble(getArgument(key)) : defaultValue;
+}
+
+unsigned int MafPipelineStep::getUnsignedArgument(const string& key, unsigned int defaultValue) const
+{
+  return hasArgument(key) ? TextTools::to<unsigned int>(getArgument(key)) : defaultValue;
+}
+
+vector<string> MafPipelineStep::getListArgument(const string& key) const
+{
+  string value = TextTools::removeSurroundingWhiteSpaces(getArgument(key));
+  if (value.size() >= 2 && value[0] == '(' && value[value.size() - 1] == ')')
+    value = value.substr(1, value.size() - 2);
+  vector<string> list;
+  StringTokenizer st(value, ",");
+  while (st.hasMoreToken())
+  {
+    string item = TextTools::removeSurroundingWhiteSpaces(st.nextToken());
+    if (!item.empty())
+      list.push_back(item);
+  }
+  return list;
+}
+
+namespace
+{
+void requireArguments(const MafPipelineStep& step, const vector<string>& keys)
+{
+  for (const auto& key : keys)
+  {
+    if (!step.hasArgument(key))
+      throw Exception("MafPipelinePlanner. Missing argument '" + key + "' for step " + step.name + ".");
+  }
+}
+}
+
+MafPipelinePlanner::MafPipelinePlanner() :
+  stepTypes_()
+{
+  // Species selection:
+  registerStep("Subset", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species"});
+    return make_shared<SequenceFilterMafIterator>(input,
+        step.getListArgument("species"),
+        step.getBooleanArgument("strict", false),
+        step.getBooleanArgument("keep", false),
+        step.getBooleanArgument("remove_duplicates", false));
+  }, BARRIER, 2.);
+
+  // Header-only predicates:
+  registerStep("BlockSize", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"min_size"});
+    return make_shared<BlockSizeMafIterator>(input, step.getUnsignedArgument("min_size", 0));
+  }, HEADER_PREDICATE, 1.);
+
+  registerStep("AlignmentScore", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"min_score"});
+    return make_shared<AlignmentScoreFilterMafIterator>(input, step.getDoubleArgument("min_score", 0));
+  }, HEADER_PREDICATE, 1.);
+
+  registerStep("Chromosome", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"reference", "chromosomes"});
+    vector<string> chrs = step.getListArgument("chromosomes");
+    return make_shared<ChromosomeMafIterator>(input, step.getArgument("reference"), set<string>(chrs.begin(), chrs.end()));
+  }, HEADER_PREDICATE, 1.);
+
+  registerStep("BlockLength", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"min_length"});
+    return make_shared<BlockLengthMafIterator>(input, step.getUnsignedArgument("min_length", 0));
+  }, LENGTH_PREDICATE, 1.);
+
+  // Column filters:
+  registerStep("FullGap", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species"});
+    return make_shared<FullGapFilterMafIterator>(input, step.getListArgument("species"));
+  }, COLUMN_FILTER, 5.);
+
+  registerStep("WindowSplit", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"window.size"});
+    unsigned int size = step.getUnsignedArgument("window.size", 0);
+    string align = step.getArgument("align", "center");
+    short option;
+    if (align == "left")
+      option = WindowSplitMafIterator::RAGGED_LEFT;
+    else if (align == "right")
+      option = WindowSplitMafIterator::RAGGED_RIGHT;
+    else if (align == "center")
+      option = WindowSplitMafIterator::CENTER;
+    else if (align == "adjust")
+      option = WindowSplitMafIterator::ADJUST;
+    else
+      throw Exception("MafPipelinePlanner. Invalid alignment option for step WindowSplit: " + align);
+    return make_shared<WindowSplitMafIterator>(input, size, step.getUnsignedArgument("window.step", size), option, step.getBooleanArgument("keep_small_blocks", false));
+  }, COLUMN_FILTER, 5.);
+
+  registerStep("MaskFilter", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species", "window.size", "window.step", "max_masked"});
+    return make_shared<MaskFilterMafIterator>(input,
+        step.getListArgument("species"),
+        step.getUnsignedArgument("window.size", 0),
+        step.getUnsignedArgument("window.step", 0),
+        step.getUnsignedArgument("max_masked", 0),
+        false);
+  }, COLUMN_FILTER, 8.);
+
+  registerStep("QualityFilter", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species", "window.size", "window.step", "min_qual"});
+    return make_shared<QualityFilterMafIterator>(input,
+        step.getListArgument("species"),
+        step.getUnsignedArgument("window.size", 0),
+        step.getUnsignedArgument("window.step", 0),
+        step.getUnsignedArgument("min_qual", 0),
+        false);
+  }, COLUMN_FILTER, 8.);
+
+  registerStep("AlignmentFilter", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species", "window.size", "window.step", "max_ent"});
+    if (step.hasArgument("max_prop_gap"))
+      return make_shared<AlignmentFilterMafIterator>(input,
+          step.getListArgument("species"),
+          step.getUnsignedArgument("window.size", 0),
+          step.getUnsignedArgument("window.step", 0),
+          step.getDoubleArgument("max_prop_gap", 0),
+          step.getDoubleArgument("max_ent", 0),
+          false,
+          step.getBooleanArgument("missing_as_gap", false));
+    requireArguments(step, {"max_gap"});
+    return make_shared<AlignmentFilterMafIterator>(input,
+        step.getListArgument("species"),
+        step.getUnsignedArgument("window.size", 0),
+        step.getUnsignedArgument("window.step", 0),
+        step.getUnsignedArgument("max_gap", 0),
+        step.getDoubleArgument("max_ent", 0),
+        false,
+        step.getBooleanArgument("missing_as_gap", false));
+  }, COLUMN_FILTER, 10.);
+
+  registerStep("AlignmentFilter2", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species", "window.size", "window.step", "max_pos"});
+    if (step.hasArgument("max_prop_gap"))
+      return make_shared<AlignmentFilter2MafIterator>(input,
+          step.getListArgument("species"),
+          step.getUnsignedArgument("window.size", 0),
+          step.getUnsignedArgument("window.step", 0),
+          step.getDoubleArgument("max_prop_gap", 0),
+          step.getUnsignedArgument("max_pos", 0),
+          false,
+          step.getBooleanArgument("missing_as_gap", false));
+    requireArguments(step, {"max_gap"});
+    return make_shared<AlignmentFilter2MafIterator>(input,
+        step.getListArgument("species"),
+        step.getUnsignedArgument("window.size", 0),
+        step.getUnsignedArgument("window.step", 0),
+        step.getUnsignedArgument("max_gap", 0),
+        step.getUnsignedArgument("max_pos", 0),
+        false,
+        step.getBooleanArgument("missing_as_gap", false));
+  }, COLUMN_FILTER, 10.);
+
+  registerStep("EntropyFilter", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"species", "window.size", "window.step", "max_ent", "max_pos"});
+    return make_shared<EntropyFilterMafIterator>(input,
+        step.getListArgument("species"),
+        step.getUnsignedArgument("window.size", 0),
+        step.getUnsignedArgument("window.step", 0),
+        step.getDoubleArgument("max_ent", 0),
+        step.getUnsignedArgument("max_pos", 0),
+        false,
+        step.getBooleanArgument("missing_as_gap", false),
+        step.getBooleanArgument("ignore_gaps", false));
+  }, COLUMN_FILTER, 20.);
+
+  // Windows spanning several blocks:
+  registerStep("GenomicWindow", [](shared_ptr<MafIteratorInterface> input, const MafPipelineStep& step) -> shared_ptr<MafIteratorInterface> {
+    requireArguments(step, {"reference", "window.size"});
+    unsigned int size = step.getUnsignedArgument("window.size", 0);
+    return make_shared<GenomicWindowMafIterator>(input, step.getArgument("reference"), size, step.getUnsignedArgument("window.step", size));
+  }, BARRIER, 5.);
+}
+
+void MafPipelinePlanner::registerStep(const string& name, StepBuilder builder, short kind, double cost)
+{
+  if (kind != BARRIER && kind != HEADER_PREDICATE && kind != LENGTH_PREDICATE && kind != COLUMN_FILTER)
+    throw Exception("MafPipelinePlanner::registerStep. Invalid kind for step " + name + ": " + TextTools::toString(kind));
+  StepType_ type;
+  type.builder = builder;
+  type.kind = kind;
+  type.cost = cost;
+  stepTypes_[name] = type;
+}
+
+vector<MafPipelineStep> MafPipelinePlanner::optimize(const vector<MafPipelineStep>& steps) const
+{
+  // Move each step upstream as long as it commutes with, and is cheaper than, the previous one:
+  vector<MafPipelineStep> plan;
+  for (const auto& step : steps)
+  {
+    plan.push_back(step);
+    for (size_t j = plan.size() - 1; j > 0 && commute_(plan[j - 1], plan[j]) && getCost_(plan[j]) < getCost_(plan[j - 1]); --j)
+    {
+      swap(plan[j - 1], plan[j]);
+    }
+  }
+
+  // Merge adjacent species selections:
+  vector<MafPipelineStep> merged;
+  for (const auto& step : plan)
+  {
+    MafPipelineStep mergedStep;
+    if (merged.size() > 0 && mergeSubsets_(merged.back(), step, mergedStep))
+      merged.back() = mergedStep;
+    else
+      merged.push_back(step);
+  }
+  return merged;
+}
+
+shared_ptr<MafIteratorInterface> MafPipelinePlanner::build(
+    shared_ptr<MafIteratorInterface> input,
+    const vector<MafPipelineStep>& steps,
+    bool optimizePlan) const
+{
+  vector<MafPipelineStep> plan = optimizePlan ? optimize(steps) : steps;
+  shared_ptr<MafIteratorInterface> it = input;
+  for (const auto& step : plan)
+  {
+    auto type = stepTypes_.find(step.name);
+    if (type == stepTypes_.end())
+      throw Exception("MafPipelinePlanner::build. Unknown step: " + step.name);
+    it = type->second.builder(it, step);
+    it->setVerbose(input->isVerbose());
+  }
+  return it;
+}
+
+vector<MafPipelineStep> MafPipelinePlanner::parsePipeline(const string& description)
+{
+  // Split at top-level commas:
+  vector<MafPipelineStep> steps;
+  string current;
+  int depth = 0;
+  for (char c : description + ",")
+  {
+    if (c == '(')
+      depth++;
+    else if (c == ')')
+      depth--;
+    if (c == ',' && depth == 0)
+    {
+      current = TextTools::removeSurroundingWhiteSpaces(current);
+      if (!current.empty())
+        steps.push_back(MafPipelineStep::parse(current));
+      current = "";
+    }
+    else
+    {
+      current += c;
+    }
+  }
+  if (depth != 0)
+    throw Exception("MafPipelinePlanner::parsePipeline. Unbalanced parentheses in pipeline description.");
+  return steps;
+}
+
+short MafPipelinePlanner::getKind_(const MafPipelineStep& step) const
+{
+  auto type = stepTypes_.find(step.name);
+  return type == stepTypes_.end() ? BARRIER : type->second.kind;
+}
+
+double MafPipelinePlanner::getCost_(const MafPipelineStep& step) const
+{
+  auto type = stepTypes_.find(step.name);
+  return type == stepTypes_.end() ? 1. : type->second.cost;
+}
+
+bool MafPipelinePlanner::commute_(const MafPipelineStep& step1, const MafPipelineStep& step2) const
+{
+  short k1 = getKind_(step1);
+  short k2 = getKind_(step2);
+  if (k1 == BARRIER || k2 == BARRIER)
+    return false;
+  if (k1 == HEADER_PREDICATE || k2 == HEADER_PREDICATE)
+    return true;
+  return false;
+}
+
+bool MafPipelinePlanner::mergeSubsets_(const MafPipelineStep& step1, const MafPipelineStep& step2, MafPipelineStep& merged)
+{
+  if (step1.name != "Subset" || step2.name != "Subset")
+    return false;
+  if (step1.getBooleanArgument("keep", false) || step2.getBooleanArgument("keep", false))
+    return false;
+  vector<string> sp1 = step1.getListArgument("species");
+  vector<string> sp2 = step2.getListArgument("species");
+  bool strict1 = step1.getBooleanArgument("strict", false);
+  bool strict2 = step2.getBooleanArgument("strict", false);
+  bool rmDup1 = step1.getBooleanArgument("remove_duplicates", false);
+  bool rmDup2 = step2.getBooleanArgument("remove_duplicates", false);
+  auto isIncluded = [](const vector<string>& a, const vector<string>& b) {
+    for (const auto& x : a)
+    {
+      if (find(b.begin(), b.end(), x) == b.end())
+        return false;
+    }
+    return true;
+  };
+
+  if (!strict1 && !rmDup1 && (!strict2 || isIncluded(sp2, sp1)))
+  {
+    // The second selection applies to the intersection of the two lists:
+    string inter;
+    for (const auto& x : sp1)
+    {
+      if (find(sp2.begin(), sp2.end(), x) != sp2.end())
+        inter += (inter.empty() ? "" : ",") + x;
+    }
+    merged = step2;
+    merged.args["species"] = "(" + inter + ")";
+    return true;
+  }
+  if (!strict2 && !rmDup2 && isIncluded(sp1, sp2))
+  {
+    // The second selection does not remove anything:
+    merged = step1;
+    return true;
+  }
+  return false;
+}
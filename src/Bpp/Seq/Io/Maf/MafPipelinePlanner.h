@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFPIPELINEPLANNER_H_
+#define _MAFPIPELINEPLANNER_H_
+
+#include "MafIterator.h"
+
+// From the STL:
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+
+namespace bpp
+{
+/**
+ * @brief One step of a declarative maf pipeline.
+ *
+ * A step is described using the usual keyval syntax, for instance
+ * "Subset(species=(hg19,mm10), strict=yes)" or "BlockSize(min_size=3)".
+ */
+class MafPipelineStep
+{
+public:
+  std::string name;
+  std::map<std::string, std::string> args;
+
+public:
+  MafPipelineStep() : name(), args() {}
+
+  MafPipelineStep(const std::string& stepName, const std::map<std::string, std::string>& stepArgs) :
+    name(stepName), args(stepArgs) {}
+
+public:
+  /**
+   * @brief Parse a step from its keyval description.
+   */
+  static MafPipelineStep parse(const std::string& description);
+
+  std::string toString() const;
+
+  bool hasArgument(const std::string& key) const { return args.find(key) != args.end(); }
+
+  std::string getArgument(const std::string& key, const std::string& defaultValue = "") const;
+
+  bool getBooleanArgument(const std::string& key, bool defaultValue) const;
+
+  double getDoubleArgument(const std::string& key, double defaultValue) const;
+
+  unsigned int getUnsignedArgument(const std::string& key, unsigned int defaultValue) const;
+
+  /**
+   * @return A list argument, given as (a,b,c). Parentheses are optional.
+   */
+  std::vector<std::string> getListArgument(const std::string& key) const;
+};
+
+
+/**
+ * @brief Build a chain of maf iterators from a declarative description, after reordering it to minimize work.
+ *
+ * The planner knows, for each type of step, how expensive it is and whether it commutes with other steps:
+ * - Header-only predicates (BlockSize, AlignmentScore, Chromosome) only look at the list of sequences, score and
+ *   reference chromosome of a block. They commute with each other, and with column filters, since these only
+ *   split blocks or remove columns, keeping all sequences, scores and chromosomes.
+ * - BlockLength depends on the number of columns, and only commutes with header-only predicates.
+ * - Column filters (EntropyFilter, AlignmentFilter, AlignmentFilter2, MaskFilter, QualityFilter, FullGap, WindowSplit)
+ *   are expensive, as they look at every column of a block.
+ * - Any other step (species selections, genomic windows, outputs, statistics, user-registered steps...) is a barrier that nothing crosses.
+ *
+ * Cheap steps are moved upstream of more expensive ones whenever the two commute, so that blocks that would eventually
+ * be discarded are removed before any costly computation takes place. The relative order of steps with the same cost is
+ * preserved. In addition, adjacent species selections (Subset) are merged when the result is equivalent.
+ *
+ * Built-in steps do not give access to removed blocks, so column filters are always built with keepTrashedBlocks=false.
+ * Additional step types can be registered with registerStep().
+ */
+class MafPipelinePlanner
+{
+public:
+  typedef std::function<std::shared_ptr<MafIteratorInterface>(
+        std::shared_ptr<MafIteratorInterface> input,
+        const MafPipelineStep& step)> StepBuilder;
+
+  static const short BARRIER;
+  static const short HEADER_PREDICATE;
+  static const short LENGTH_PREDICATE;
+  static const short COLUMN_FILTER;
+
+private:
+  struct StepType_
+  {
+    StepBuilder builder;
+    short kind;
+    double cost;
+  };
+
+  std::map<std::string, StepType_> stepTypes_;
+
+public:
+  MafPipelinePlanner();
+
+  virtual ~MafPipelinePlanner() {}
+
+public:
+  /**
+   * @brief Register a new type of step, or override an existing one.
+   *
+   * @param name The name of the step.
+   * @param builder The function creating the iterator.
+   * @param kind One of BARRIER, HEADER_PREDICATE, LENGTH_PREDICATE or COLUMN_FILTER.
+   * @param cost Relative cost of the step, only used for steps that commute.
+   */
+  void registerStep(const std::string& name, StepBuilder builder, short kind = BARRIER, double cost = 1.);
+
+  bool hasStep(const std::string& name) const { return stepTypes_.find(name) != stepTypes_.end(); }
+
+  /**
+   * @return An equivalent list of steps, reordered and simplified.
+   * @param steps The input pipeline, from upstream to downstream.
+   */
+  std::vector<MafPipelineStep> optimize(const std::vector<MafPipelineStep>& steps) const;
+
+  /**
+   * @brief Build the pipeline.
+   *
+   * @param input The input iterator (typically a parser).
+   * @param steps The pipeline, from upstream to downstream.
+   * @param optimizePlan Tell if the steps should be reordered first.
+   * @return The last iterator of the chain.
+   * @throw Exception If a step is unknown.
+   */
+  std::shared_ptr<MafIteratorInterface> build(
+      std::shared_ptr<MafIteratorInterface> input,
+      const std::vector<MafPipelineStep>& steps,
+      bool optimizePlan = true) const;
+
+  /**
+   * @brief Parse a pipeline description made of several steps, separated by commas.
+   *
+   * Example: "BlockSize(min_size=3), Subset(species=(hg19,mm10)), EntropyFilter(species=(hg19,mm10), max_ent=0.5)"
+   */
+  static std::vector<MafPipelineStep> parsePipeline(const std::string& description);
+
+private:
+  short getKind_(const MafPipelineStep& step) const;
+  double getCost_(const MafPipelineStep& step) const;
+  bool commute_(const MafPipelineStep& step1, const MafPipelineStep& step2) const;
+  static bool mergeSubsets_(const MafPipelineStep& step1, const MafPipelineStep& step2, MafPipelineStep& merged);
+};
+} // end of namespace bpp.
+
+#endif // _MAFPIPELINEPLANNER_H_
@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafProgressMonitor.h"
+
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <cstdio>
+
+using namespace std;
+
+double MafProgressMonitor::getElapsedTime() const
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - startTime_).count();
+}
+
+double MafProgressMonitor::getRemainingTime() const
+{
+  size_t total = getTotalBytes();
+  size_t done = getNumberOfBytes();
+  if (total == 0 || done == 0)
+    return -1.;
+  if (done >= total)
+    return 0.;
+  return getElapsedTime() * static_cast<double>(total - done) / static_cast<double>(done);
+}
+
+string MafProgressMonitor::getReport() const
+{
+  double elapsed = getElapsedTime();
+  size_t total = getTotalBytes();
+  size_t nbBlocks = getNumberOfBlocks();
+  size_t nbSites = getNumberOfSites();
+  string report = "Read " + formatBytes(getNumberOfBytes());
+  if (total > 0)
+  {
+    char percent[16];
+    snprintf(percent, sizeof(percent), "%.1f", 100. * static_cast<double>(getNumberOfBytes()) / static_cast<double>(total));
+    report += " / " + formatBytes(total) + " (" + percent + "%)";
+  }
+  report += ", " + TextTools::toString(nbBlocks) + " blocks";
+  if (elapsed > 0)
+    report += " (" + TextTools::toString(static_cast<double>(nbBlocks) / elapsed, 4) + " blocks/s)";
+  if (nbSites > 0)
+    report += ", " + TextTools::toString(nbSites) + " columns";
+  report += ", elapsed " + formatTime(elapsed);
+  double remaining = getRemainingTime();
+  if (remaining >= 0)
+    report += ", ETA " + formatTime(remaining);
+  return report;
+}
+
+void MafProgressMonitor::report()
+{
+  if (output_)
+    (*output_ << getReport()).endLine();
+}
+
+void MafProgressMonitor::start()
+{
+  stop(false);
+  startTime_ = chrono::steady_clock::now();
+  {
+    lock_guard<mutex> lock(mutex_);
+    running_ = true;
+  }
+  thread_ = thread(&MafProgressMonitor::run_, this);
+}
+
+void MafProgressMonitor::stop(bool finalReport)
+{
+  if (thread_.joinable())
+  {
+    {
+      lock_guard<mutex> lock(mutex_);
+      running_ = false;
+    }
+    condition_.notify_all();
+    thread_.join();
+    if (finalReport)
+      report();
+  }
+}
+
+void MafProgressMonitor::run_()
+{
+  unique_lock<mutex> lock(mutex_);
+  while (running_)
+  {
+    if (!condition_.wait_for(lock, interval_, [this] { return !running_; }))
+      report();
+  }
+}
+
+string MafProgressMonitor::formatBytes(size_t n)
+{
+  const char* units[] = { "B", "kB", "MB", "GB", "TB" };
+  double size = static_cast<double>(n);
+  size_t u = 0;
+  while (size >= 1024. && u < 4)
+  {
+    size /= 1024.;
+    ++u;
+  }
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), u == 0 ? "%.0f %s" : "%.1f %s", size, units[u]);
+  return buffer;
+}
+
+string MafProgressMonitor::formatTime(double seconds)
+{
+  size_t s = static_cast<size_t>(seconds + 0.5);
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%zuh%02zum%02zus", s / 3600, (s / 60) % 60, s % 60);
+  return buffer;
+}
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFPROGRESSMONITOR_H_
+#define _MAFPROGRESSMONITOR_H_
+
+#include <Bpp/App/ApplicationTools.h>
+
+// From the STL:
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace bpp
+{
+/**
+ * @brief Progress report for maf pipelines.
+ *
+ * Iterators only update counters, which is cheap enough to be done in inner loops.
+ * A background thread started with start() periodically prints a summary line with the amount of
+ * input read, the number of blocks and columns processed, the processing rate and, if the total size
+ * of the input is known, the estimated remaining time.
+ *
+ * A monitor is attached to a pipeline with MafIteratorInterface::setProgressMonitor(), which forwards it to all
+ * upstream iterators. The parser reports its position in the input stream and the number of blocks read, while
+ * filters report the number of columns they scanned.
+ *
+ * Reports are written from the background thread, and may therefore interleave with other messages written on the same stream.
+ */
+class MafProgressMonitor
+{
+private:
+  std::atomic<size_t> nbBlocks_;
+  std::atomic<size_t> nbSites_;
+  std::atomic<size_t> nbBytes_;
+  std::atomic<size_t> totalBytes_;
+  std::shared_ptr<OutputStream> output_;
+  std::chrono::milliseconds interval_;
+  std::chrono::steady_clock::time_point startTime_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool running_;
+
+public:
+  /**
+   * @param output The stream where to write reports.
+   * @param interval Time between two reports, in milliseconds.
+   */
+  MafProgressMonitor(std::shared_ptr<OutputStream> output = ApplicationTools::message, unsigned int interval = 2000) :
+    nbBlocks_(0),
+    nbSites_(0),
+    nbBytes_(0),
+    totalBytes_(0),
+    output_(output),
+    interval_(interval),
+    startTime_(std::chrono::steady_clock::now()),
+    thread_(),
+    mutex_(),
+    condition_(),
+    running_(false)
+  {}
+
+  MafProgressMonitor(const MafProgressMonitor& monitor) = delete;
+  MafProgressMonitor& operator=(const MafProgressMonitor& monitor) = delete;
+
+  virtual ~MafProgressMonitor() { stop(false); }
+
+public:
+  /**
+   * @name Counters, safe to update from any thread.
+   *
+   * @{
+   */
+  void addBlocks(size_t n = 1) { nbBlocks_.fetch_add(n, std::memory_order_relaxed); }
+  void addSites(size_t n) { nbSites_.fetch_add(n, std::memory_order_relaxed); }
+  void setBytes(size_t n) { nbBytes_.store(n, std::memory_order_relaxed); }
+
+  /**
+   * @param n The total size of the input, in bytes. 0 means unknown, in which case no remaining time is estimated.
+   */
+  void setTotalBytes(size_t n) { totalBytes_.store(n, std::memory_order_relaxed); }
+
+  size_t getNumberOfBlocks() const { return nbBlocks_.load(std::memory_order_relaxed); }
+  size_t getNumberOfSites() const { return nbSites_.load(std::memory_order_relaxed); }
+  size_t getNumberOfBytes() const { return nbBytes_.load(std::memory_order_relaxed); }
+  size_t getTotalBytes() const { return totalBytes_.load(std::memory_order_relaxed); }
+  /** @} */
+
+  /**
+   * @return The time elapsed since the creation of the monitor, or the last call to start(), in seconds.
+   */
+  double getElapsedTime() const;
+
+  /**
+   * @return The estimated remaining time in seconds, or a negative value if it cannot be computed.
+   */
+  double getRemainingTime() const;
+
+  /**
+   * @return A one line summary of the progress.
+   */
+  std::string getReport() const;
+
+  /**
+   * @brief Print a report now.
+   */
+  void report();
+
+  /**
+   * @brief Start periodic reports, and reset the timer.
+   */
+  void start();
+
+  /**
+   * @brief Stop periodic reports.
+   *
+   * @param finalReport Tell if a last report should be printed.
+   */
+  void stop(bool finalReport = true);
+
+  bool isRunning() const { return thread_.joinable(); }
+
+  /**
+   * @return A human readable representation of a size in bytes.
+   */
+  static std::string formatBytes(size_t n);
+
+  /**
+   * @return A human readable representation of a duration, as HhMMmSSs.
+   */
+  static std::string formatTime(double seconds);
+
+private:
+  void run_();
+};
+} // end of namespace bpp.
+
+#endif // _MAFPROGRESSMONITOR_H_
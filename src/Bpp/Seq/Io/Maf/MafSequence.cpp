@@ -6,23 +6,36 @@
 
 // From the STL:
 #include <string>
+#include <algorithm>
 
 using namespace bpp;
 using namespace std;
 
 unique_ptr<MafSequence> MafSequence::subSequence(size_t startAt, size_t length) const
 {
-  string subseq = toString().substr(startAt, length);
   size_t begin = begin_;
   if (hasCoordinates_)
   {
-    for (size_t i = 0; i < startAt; ++i)
+    const vector<int>& content = getContent();
+    size_t end = min(startAt, content.size());
+    for (size_t i = 0; i < end; ++i)
     {
-      if (!getAlphabet()->isGap(operator[](i)))
+      if (!getAlphabet()->isGap(content[i]))
         begin++;
     }
   }
-  auto newSeq = make_unique<MafSequence>(getName(), subseq, begin, strand_, srcSize_);
+  return subSequence(startAt, length, begin);
+}
+
+unique_ptr<MafSequence> MafSequence::subSequence(size_t startAt, size_t length, size_t begin) const
+{
+  const vector<int>& content = getContent();
+  if (startAt > content.size())
+    throw Exception("MafSequence::subSequence. Start position " + TextTools::toString(startAt) + " is beyond the end of sequence " + getName() + ".");
+  length = min(length, content.size() - startAt);
+  auto first = content.begin() + static_cast<ptrdiff_t>(startAt);
+  auto newSeq = make_unique<MafSequence>(getName(), string(), begin, strand_, srcSize_);
+  newSeq->setContent(vector<int>(first, first + static_cast<ptrdiff_t>(length)));
   if (!hasCoordinates_)
     newSeq->removeCoordinates();
   vector<string> anno = getAnnotationTypes();
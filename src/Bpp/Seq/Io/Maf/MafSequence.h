@@ -250,6 +250,18 @@ public:
    */
   std::unique_ptr<MafSequence> subSequence(size_t startAt, size_t length) const;
 
+  /**
+   * @brief Extract a sub-sequence, whose genomic start position is already known.
+   *
+   * This avoids counting the sites before the sub-sequence, when several consecutive sub-sequences are extracted.
+   *
+   * @return A subsequence.
+   * @param startAt Beginning of sub-sequence.
+   * @param length  the length of the sub-sequence.
+   * @param begin   the genomic start position of the sub-sequence (ignored if the sequence has no coordinates).
+   */
+  std::unique_ptr<MafSequence> subSequence(size_t startAt, size_t length, size_t begin) const;
+
 private:
   void beforeSequenceChanged(const IntSymbolListEditionEvent& event) override {}
   void afterSequenceChanged(const IntSymbolListEditionEvent& event) override
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "MafStatistics.h"
+#include "MafBlockSerializer.h"
 #include <Bpp/Seq/Container/SequenceContainerTools.h>
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
 #include <Bpp/Seq/Container/SiteContainerTools.h>
@@ -14,6 +15,9 @@
 // From the STL:
 #include <cmath>
 #include <map>
+#include <algorithm>
+#include <bitset>
+#include <limits>
 
 using namespace bpp;
 using namespace std;
@@ -30,6 +34,32 @@ void PairwiseDivergenceMafStatistics::compute(const MafBlock& block)
     result_.setValue(100. - SequenceTools::getPercentIdentity(*seqs1[0], *seqs2[0], true));
 }
 
+void AbstractMafColumnStatistics::compute(const MafBlock& block)
+{
+  vector<MafSpeciesSelection> selections = getSpeciesSelections();
+  vector<MafColumnView> views(selections.size());
+  vector<const MafColumnView*> pviews;
+  for (size_t k = 0; k < selections.size(); ++k)
+  {
+    views[k].reset(block, selections[k]);
+    pviews.push_back(&views[k]);
+  }
+  beginBlock(block, pviews);
+  size_t nc = static_cast<size_t>(block.getNumberOfSites());
+  for (size_t i = 0; i < nc; ++i)
+  {
+    processColumn(i);
+  }
+  endBlock();
+}
+
+string AbstractSpeciesSelectionMafStatistics::getSpeciesConfiguration_() const
+{
+  if (species_.size() == 0 && noSpeciesMeansAllSpecies_)
+    return "species=all";
+  return "species=" + VectorTools::paste(species_, ",");
+}
+
 unique_ptr<SiteContainerInterface> AbstractSpeciesSelectionMafStatistics::getSiteContainer_(const MafBlock& block)
 {
   auto alignment = make_unique<VectorSiteContainer>(block.getAlphabet());
@@ -70,6 +100,26 @@ AbstractSpeciesMultipleSelectionMafStatistics::AbstractSpeciesMultipleSelectionM
     throw Exception("AbstractSpeciesMultipleSelectionMafStatistics (constructor). Species selections must be fully distinct.");
 }
 
+vector<MafSpeciesSelection> AbstractSpeciesMultipleSelectionMafStatistics::getSpeciesSelections_() const
+{
+  vector<MafSpeciesSelection> selections;
+  for (const auto& species : species_)
+  {
+    selections.push_back(MafSpeciesSelection(species));
+  }
+  return selections;
+}
+
+string AbstractSpeciesMultipleSelectionMafStatistics::getSpeciesConfiguration_() const
+{
+  string configuration = "species=";
+  for (const auto& species : species_)
+  {
+    configuration += "(" + VectorTools::paste(species, ",") + ")";
+  }
+  return configuration;
+}
+
 vector<unique_ptr<SiteContainerInterface>> AbstractSpeciesMultipleSelectionMafStatistics::getSiteContainers_(const MafBlock& block)
 {
   vector<unique_ptr<SiteContainerInterface>> alignments;
@@ -106,23 +156,77 @@ vector<string> CharacterCountsMafStatistics::getSupportedTags() const
   return tags;
 }
 
-void CharacterCountsMafStatistics::compute(const MafBlock& block)
+void CharacterCountsMafStatistics::initTagIndices_()
 {
-  std::map<int, unsigned int> counts;
-  auto sites = getSiteContainer_(block);
-  SequenceContainerTools::getCounts(*sites, counts);
-  for (int i = 0; i < static_cast<int>(alphabet_->getSize()); ++i)
+  // Tags are resolved once, so that results are updated without any lookup:
+  tagIndices_.clear();
+  for (const auto& tag : CharacterCountsMafStatistics::getSupportedTags())
+  {
+    tagIndices_.push_back(result_.getTagIndex(tag));
+  }
+}
+
+void CharacterCountsMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
+{
+  view_ = views[0];
+  nucleotideCounts_.clear();
+  counts_.clear();
+}
+
+void CharacterCountsMafStatistics::processColumn(size_t i)
+{
+  const int* column = view_->column(i);
+  if (isNucleic_)
+  {
+    nucleotideCounts_.add(column, view_->getNumberOfRows());
+  }
+  else
   {
-    result_.setValue(alphabet_->intToChar(i), counts[i]);
+    for (size_t j = 0; j < view_->getNumberOfRows(); ++j)
+    {
+      counts_[column[j]]++;
+    }
+  }
+}
+
+void CharacterCountsMafStatistics::endBlock()
+{
+  // Indices follow the order of getSupportedTags:
+  size_t nbStates = alphabet_->getSize();
+  if (isNucleic_)
+  {
+    for (size_t i = 0; i < nbStates; ++i)
+    {
+      result_.setValueAt(tagIndices_[i], nucleotideCounts_.getCount(i));
+    }
+    result_.setValueAt(tagIndices_[nbStates], nucleotideCounts_.getNumberOfGaps());
+    result_.setValueAt(tagIndices_[nbStates + 1], static_cast<double>(nucleotideCounts_.getNumberOfUnresolved()));
+  }
+  else
+  {
+    for (size_t i = 0; i < nbStates; ++i)
+    {
+      result_.setValueAt(tagIndices_[i], counts_[static_cast<int>(i)]);
+    }
+    result_.setValueAt(tagIndices_[nbStates], counts_[alphabet_->getGapCharacterCode()]);
+    double countUnres = 0;
+    for (auto& it : counts_)
+    {
+      if (alphabet_->isUnresolved(it.first))
+        countUnres += it.second;
+    }
+    result_.setValueAt(tagIndices_[nbStates + 1], countUnres);
   }
-  result_.setValue("Gap", counts[alphabet_->getGapCharacterCode()]);
-  double countUnres = 0;
-  for (auto& it : counts)
+}
+
+string SiteFrequencySpectrumMafStatistics::getConfiguration() const
+{
+  vector<string> bounds;
+  for (double bound : categorizer_.getBounds())
   {
-    if (alphabet_->isUnresolved(it.first))
-      countUnres += it.second;
+    bounds.push_back(TextTools::toString(bound, 17));
   }
-  result_.setValue("Unresolved", countUnres);
+  return getShortName() + "(bounds=" + VectorTools::paste(bounds, ",") + "," + getSpeciesConfiguration_() + ",outgroup=" + outgroup_ + ")";
 }
 
 vector<string> SiteFrequencySpectrumMafStatistics::getSupportedTags() const
@@ -138,136 +242,143 @@ vector<string> SiteFrequencySpectrumMafStatistics::getSupportedTags() const
   return tags;
 }
 
-void SiteFrequencySpectrumMafStatistics::compute(const MafBlock& block)
+void SiteFrequencySpectrumMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
 {
-  unsigned int nbUnresolved = 0;
-  unsigned int nbSaturated = 0;
-  unsigned int nbIgnored = 0;
+  view_ = views[0];
+  nbUnresolved_ = 0;
+  nbSaturated_ = 0;
+  nbIgnored_ = 0;
   counts_.assign(categorizer_.getNumberOfCategories(), 0);
-  int state;
-  bool hasOutgroup = (outgroup_ != "");
-  bool isAnalyzable;
-  unique_ptr<SiteContainerInterface> alignment;
-  const SequenceInterface* outgroupSeq = nullptr;
-  if (hasOutgroup)
+  outgroupSeq_ = nullptr;
+  if (outgroup_ != "")
   {
-    isAnalyzable = (block.hasSequenceForSpecies(outgroup_) && block.getNumberOfSequences() > 1);
-    if (isAnalyzable)
+    isAnalyzable_ = (block.hasSequenceForSpecies(outgroup_) && block.getNumberOfSequences() > 1);
+    if (isAnalyzable_)
     {
       // We need to extract the outgroup sequence:
-      outgroupSeq = &block.sequenceForSpecies(outgroup_); // Here we assume there is only one! Otherwise we take the first one...
-      alignment = getSiteContainer_(block);
+      outgroupSeq_ = &block.sequenceForSpecies(outgroup_).getContent(); // Here we assume there is only one! Otherwise we take the first one...
     }
   }
   else
   {
-    isAnalyzable = (block.getNumberOfSequences() > 0);
-    if (isAnalyzable)
-      alignment = getSiteContainer_(block);
+    isAnalyzable_ = (block.getNumberOfSequences() > 0);
   }
-  if (isAnalyzable)
+  // Sites without any ingroup sequence are not analyzed:
+  size_t n = view_->getNumberOfRows();
+  isAnalyzable_ = isAnalyzable_ && n > 0;
+  // Derived allele counts range from 0 to the number of sequences:
+  if (categories_.size() != n + 1)
+    categories_ = categorizer_.getCategories(n);
+}
+
+void SiteFrequencySpectrumMafStatistics::processColumn(size_t i)
+{
+  if (!isAnalyzable_)
+    return;
+  const int* column = view_->column(i);
+  size_t n = view_->getNumberOfRows();
+  columnCounts_.count(column, n);
+  if (!columnCounts_.isComplete())
   {
-    for (size_t i = 0; i < alignment->getNumberOfSites(); ++i)
+    // The column is saturated if a third state occurs before the first gap or unresolved character, unresolved otherwise:
+    unsigned int seen = 0;
+    size_t nbSeen = 0;
+    for (size_t j = 0; j < n && static_cast<unsigned int>(column[j]) < 4 && nbSeen <= 2; ++j)
     {
-      // Note: we do not rely on SiteTool::getCounts as it would be unefficient to count everything.
-      const Site& site = alignment->site(i);
-      map<int, unsigned int> counts;
-      bool isUnresolved = false;
-      bool isSaturated = false;
-      for (size_t j = 0; !isUnresolved && !isSaturated && j < site.size(); ++j)
-      {
-        state = site[j];
-        if (alphabet_->isGap(state) || alphabet_->isUnresolved(state))
-        {
-          isUnresolved = true;
-        }
-        else
-        {
-          counts[state]++;
-          if (counts.size() > 2)
-          {
-            isSaturated = true;
-          }
-        }
-      }
-      if (isUnresolved)
-      {
-        nbUnresolved++;
-      }
-      else if (isSaturated)
-      {
-        nbSaturated++;
-      }
-      else if (hasOutgroup && (
-            alignment->getAlphabet()->isGap((*outgroupSeq)[i]) ||
-            alignment->getAlphabet()->isUnresolved((*outgroupSeq)[i])))
-      {
-        nbUnresolved++;
-      }
+      unsigned int bit = 1u << column[j];
+      nbSeen += ((seen & bit) == 0);
+      seen |= bit;
+    }
+    if (nbSeen > 2)
+      nbSaturated_++;
+    else
+      nbUnresolved_++;
+    return;
+  }
+  size_t nbAlleles = columnCounts_.getNumberOfAlleles();
+  if (nbAlleles > 2)
+  {
+    nbSaturated_++;
+    return;
+  }
+  bool hasOutgroup = (outgroupSeq_ != nullptr);
+  int outgroupState = hasOutgroup ? (*outgroupSeq_)[i] : 0;
+  if (hasOutgroup && (alphabet_->isGap(outgroupState) || alphabet_->isUnresolved(outgroupState)))
+  {
+    nbUnresolved_++;
+    return;
+  }
+  // Get the (at most two) observed states, in increasing order:
+  int state1 = -1;
+  int state2 = -1;
+  for (int s = 0; s < 4; ++s)
+  {
+    if (columnCounts_.getCount(static_cast<size_t>(s)) > 0)
+    {
+      if (state1 < 0)
+        state1 = s;
+      state2 = s;
+    }
+  }
+  // Determine frequency class:
+  size_t count = 0;
+  if (nbAlleles == 1)
+  {
+    if (hasOutgroup && state1 != outgroupState)
+      count = columnCounts_.getCount(static_cast<size_t>(state1)); // This is a derived state.
+    else
+      count = 0; // This is the ancestral state, or we do not know, so we put 0.
+  }
+  else
+  {
+    unsigned int count1 = columnCounts_.getCount(static_cast<size_t>(state1));
+    unsigned int count2 = columnCounts_.getCount(static_cast<size_t>(state2));
+    if (hasOutgroup)
+    {
+      if (state1 == outgroupState)
+        count = count2; // This is the ancestral state, therefore we other one is the derived state.
+      else if (state2 == outgroupState)
+        count = count1; // The second state is the ancestral one, therefore the first one is the derived state.
       else
       {
-        // Determine frequency class:
-        double count;
-        if (counts.size() == 1)
-        {
-          if (hasOutgroup)
-          {
-            if (counts.begin()->first == (*outgroupSeq)[i])
-              count = 0; // This is the ancestral state.
-            else
-              count = counts.begin()->second; // This is a derived state.
-          }
-          else
-          {
-            count = 0; // In this case we do not know, so we put 0.
-          }
-        }
-        else
-        {
-          map<int, unsigned int>::iterator it = counts.begin();
-          unsigned int count1 = it->second;
-          it++;
-          unsigned int count2 = it->second;
-          if (hasOutgroup)
-          {
-            if (counts.begin()->first == (*outgroupSeq)[i])
-              count = counts.rbegin()->second; // This is the ancestral state, therefore we other one is the derived state.
-            else if (counts.rbegin()->first == (*outgroupSeq)[i])
-              count = counts.begin()->second; // The second state is the ancestral one, therefore the first one is the derived state.
-            else
-            {
-              // None of the two states are ancestral! The position is therefore discarded.
-              isSaturated = true;
-            }
-          }
-          else
-          {
-            count = min(count1, count2); // In this case we do not know, so we take the minimum of the two values.
-          }
-        }
-        if (isSaturated)
-          nbSaturated++;
-        else
-        {
-          try
-          {
-            counts_[categorizer_.getCategory(count) - 1]++;
-          }
-          catch (OutOfRangeException& oof)
-          {
-            nbIgnored++;
-          }
-        }
+        // None of the two states are ancestral! The position is therefore discarded.
+        nbSaturated_++;
+        return;
       }
     }
+    else
+    {
+      count = min(count1, count2); // In this case we do not know, so we take the minimum of the two values.
+    }
+  }
+  size_t category = categories_[count];
+  if (category > 0)
+    counts_[category - 1]++;
+  else
+    nbIgnored_++;
+}
+
+void SiteFrequencySpectrumMafStatistics::initTagIndices_()
+{
+  // Tags are resolved once, so that results are updated without any lookup:
+  tagIndices_.clear();
+  for (const auto& tag : SiteFrequencySpectrumMafStatistics::getSupportedTags())
+  {
+    tagIndices_.push_back(result_.getTagIndex(tag));
   }
-  result_.setValue("Unresolved", nbUnresolved);
-  result_.setValue("Saturated", nbSaturated);
-  result_.setValue("Ignored", nbIgnored);
-  for (size_t i = 0; i < counts_.size(); ++i)
+}
+
+void SiteFrequencySpectrumMafStatistics::endBlock()
+{
+  // Indices follow the order of getSupportedTags:
+  size_t nbBins = counts_.size();
+  for (size_t i = 0; i < nbBins; ++i)
   {
-    result_.setValue("Bin" + TextTools::toString(i + 1), counts_[i]);
+    result_.setValueAt(tagIndices_[i], counts_[i]);
   }
+  result_.setValueAt(tagIndices_[nbBins], nbUnresolved_);
+  result_.setValueAt(tagIndices_[nbBins + 1], nbSaturated_);
+  result_.setValueAt(tagIndices_[nbBins + 2], nbIgnored_);
 }
 
 vector<string> FourSpeciesPatternCountsMafStatistics::getSupportedTags() const
@@ -280,48 +391,49 @@ vector<string> FourSpeciesPatternCountsMafStatistics::getSupportedTags() const
   return tags;
 }
 
-void FourSpeciesPatternCountsMafStatistics::compute(const MafBlock& block)
+void FourSpeciesPatternCountsMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
 {
+  view_ = views[0];
   counts_.assign(6, 0);
-  auto alignment = getSiteContainer_(block);
-  if (alignment->getNumberOfSequences() == 4)
+  nbIgnored_ = 0;
+}
+
+void FourSpeciesPatternCountsMafStatistics::processColumn(size_t i)
+{
+  if (view_->getNumberOfRows() != 4)
   {
-    unsigned int nbIgnored = 0;
-    for (size_t i = 0; i < block.getNumberOfSites(); ++i)
-    {
-      const Site& site = alignment->site(i);
-      if (SiteTools::isComplete(site))
-      {
-        if (site[0] == site[1] &&
-            site[2] != site[1] &&
-            site[3] == site[2])
-          counts_[0]++;
-        else if (site[1] == site[2] &&
-            site[1] != site[0] &&
-            site[3] == site[0])
-          counts_[1]++;
-        else if (site[0] == site[2] &&
-            site[1] != site[0] &&
-            site[3] == site[1])
-          counts_[2]++;
-      }
-      else
-      {
-        nbIgnored++;
-      }
-    }
-    result_.setValue("f1100", counts_[0]);
-    result_.setValue("f0110", counts_[1]);
-    result_.setValue("f1010", counts_[2]);
-    result_.setValue("Ignored", nbIgnored);
+    nbIgnored_++;
+    return;
   }
-  else
+  const int* site = view_->column(i);
+  for (size_t j = 0; j < 4; ++j)
   {
-    result_.setValue("f1100", 0);
-    result_.setValue("f0110", 0);
-    result_.setValue("f1010", 0);
-    result_.setValue("Ignored", static_cast<double>(block.getNumberOfSites()));
+    if (alphabet_->isGap(site[j]) || alphabet_->isUnresolved(site[j]))
+    {
+      nbIgnored_++;
+      return;
+    }
   }
+  if (site[0] == site[1] &&
+      site[2] != site[1] &&
+      site[3] == site[2])
+    counts_[0]++;
+  else if (site[1] == site[2] &&
+      site[1] != site[0] &&
+      site[3] == site[0])
+    counts_[1]++;
+  else if (site[0] == site[2] &&
+      site[1] != site[0] &&
+      site[3] == site[1])
+    counts_[2]++;
+}
+
+void FourSpeciesPatternCountsMafStatistics::endBlock()
+{
+  result_.setValue("f1100", counts_[0]);
+  result_.setValue("f0110", counts_[1]);
+  result_.setValue("f1010", counts_[2]);
+  result_.setValue("Ignored", nbIgnored_); // All sites are ignored if the selection does not contain exactly four sequences.
 }
 
 vector<string> SiteMafStatistics::getSupportedTags() const
@@ -337,47 +449,83 @@ vector<string> SiteMafStatistics::getSupportedTags() const
   return tags;
 }
 
-void SiteMafStatistics::compute(const MafBlock& block)
+void SiteMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
+{
+  alphabet_ = block.getAlphabet();
+  isNucleic_ = AlphabetTools::isNucleicAlphabet(*alphabet_);
+  view_ = views[0];
+  counts_.assign(7, 0);
+}
+
+void SiteMafStatistics::processColumn(size_t i)
 {
-  auto alignment = getSiteContainer_(block);
-  unsigned int nbNg = 0;
-  unsigned int nbCo = 0;
-  unsigned int nbPi = 0;
-  unsigned int nbP1 = 0;
-  unsigned int nbP2 = 0;
-  unsigned int nbP3 = 0;
-  unsigned int nbP4 = 0;
-  if (alignment->getNumberOfSequences() > 0)
+  size_t n = view_->getNumberOfRows();
+  if (n == 0)
+    return;
+  const int* site = view_->column(i);
+  bool hasGap = false;
+  bool isComplete = true;
+  size_t nbStates = 0;
+  size_t nbRepeated = 0; // Number of states, including gaps and unresolved ones, observed at least twice.
+  if (isNucleic_)
+  {
+    columnCounts_.count(site, n);
+    hasGap = columnCounts_.hasGap();
+    isComplete = columnCounts_.isComplete();
+    nbStates = columnCounts_.getNumberOfAlleles();
+    nbRepeated = columnCounts_.getNumberOfRepeatedStates(site, n);
+  }
+  else
   {
-    for (size_t i = 0; i < alignment->getNumberOfSites(); ++i)
+    map<int, size_t> counts;
+    for (size_t j = 0; j < n; ++j)
     {
-      if (!SiteTools::hasGap(alignment->site(i)))
-        nbNg++;
-      if (SiteTools::isComplete(alignment->site(i)))
+      if (alphabet_->isGap(site[j]))
       {
-        nbCo++;
-        map<int, size_t> counts;
-        SiteTools::getCounts(alignment->site(i), counts);
-        switch (counts.size())
-        {
-        case 1: nbP1++; break;
-        case 2: nbP2++; break;
-        case 3: nbP3++; break;
-        case 4: nbP4++; break;
-        default: throw Exception("The impossible happened. Probably a distortion in the Minkowski space.");
-        }
+        hasGap = true;
+        isComplete = false;
+      }
+      else if (alphabet_->isUnresolved(site[j]))
+      {
+        isComplete = false;
       }
-      if (SiteTools::isParsimonyInformativeSite(alignment->site(i)))
-        nbPi++;
+      counts[site[j]]++;
+    }
+    nbStates = counts.size();
+    for (const auto& it : counts)
+    {
+      if (it.second > 1)
+        nbRepeated++;
+    }
+  }
+  if (!hasGap)
+    counts_[0]++;
+  if (isComplete)
+  {
+    counts_[1]++;
+    switch (nbStates)
+    {
+    case 1: counts_[2]++; break;
+    case 2: counts_[3]++; break;
+    case 3: counts_[4]++; break;
+    case 4: counts_[5]++; break;
+    default: throw Exception("The impossible happened. Probably a distortion in the Minkowski space.");
     }
   }
-  result_.setValue("NbWithoutGap", nbNg);
-  result_.setValue("NbComplete", nbCo);
-  result_.setValue("NbConstant", nbP1);
-  result_.setValue("NbBiallelic", nbP2);
-  result_.setValue("NbTriallelic", nbP3);
-  result_.setValue("NbQuadriallelic", nbP4);
-  result_.setValue("NbParsimonyInformative", nbPi);
+  // A site is parsimony informative if at least two states are observed at least twice:
+  if (nbRepeated > 1)
+    counts_[6]++;
+}
+
+void SiteMafStatistics::endBlock()
+{
+  result_.setValue("NbWithoutGap", counts_[0]);
+  result_.setValue("NbComplete", counts_[1]);
+  result_.setValue("NbConstant", counts_[2]);
+  result_.setValue("NbBiallelic", counts_[3]);
+  result_.setValue("NbTriallelic", counts_[4]);
+  result_.setValue("NbQuadriallelic", counts_[5]);
+  result_.setValue("NbParsimonyInformative", counts_[6]);
 }
 
 vector<string> PolymorphismMafStatistics::getSupportedTags() const
@@ -396,117 +544,96 @@ vector<string> PolymorphismMafStatistics::getSupportedTags() const
   return tags;
 }
 
-vector<int> PolymorphismMafStatistics::getPatterns_(const SiteContainerInterface& sites)
+int PolymorphismMafStatistics::getPattern_(const MafColumnView& view, size_t i) const
 {
-  vector<int> patterns(sites.getNumberOfSites());
-  for (size_t i = 0; i < sites.getNumberOfSites(); ++i)
+  size_t n = view.getNumberOfRows();
+  if (n == 0)
+    return -1; // Unresolved
+  const int* site = view.column(i);
+  bool isConstant = true;
+  for (size_t j = 0; j < n; ++j)
   {
-    const Site& site = sites.site(i);
-    int s = -1; // Unresolved
-    if (SiteTools::isComplete(site))
-    {
-      if (SiteTools::isConstant(site))
-      {
-        s = site[0]; // The fixed state
-      }
-      else
-      {
-        s = -10; // Polymorphic.
-      }
-    }
-    patterns[i] = s;
+    if (alphabet_->isGap(site[j]) || alphabet_->isUnresolved(site[j]))
+      return -1; // Unresolved
+    if (site[j] != site[0])
+      isConstant = false;
   }
-  return patterns;
+  return isConstant ? site[0] : -10; // The fixed state, or polymorphic.
 }
 
-void PolymorphismMafStatistics::compute(const MafBlock& block)
+void PolymorphismMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
 {
-  vector<unique_ptr<SiteContainerInterface>> alignments = getSiteContainers_(block);
-  unsigned int nbF = 0;
-  unsigned int nbP = 0;
-  unsigned int nbFF = 0;
-  unsigned int nbFP = 0;
-  unsigned int nbPF = 0;
-  unsigned int nbX = 0;
-  unsigned int nbFX = 0;
-  unsigned int nbPX = 0;
-  unsigned int nbXF = 0;
-  unsigned int nbXP = 0;
-  // Get all patterns:
-  vector<int> patterns1(block.getNumberOfSites(), -1);
-  vector<int> patterns2(block.getNumberOfSites(), -1);
-  if (alignments[0]->getNumberOfSequences() > 0)
-  {
-    patterns1 = getPatterns_(*alignments[0]);
-  }
-  if (alignments[1]->getNumberOfSequences() > 0)
-  {
-    patterns2 = getPatterns_(*alignments[1]);
-  }
-  // Compare patterns:
-  for (size_t i = 0; i < block.getNumberOfSites(); ++i)
+  alphabet_ = block.getAlphabet();
+  view1_ = views[0];
+  view2_ = views[1];
+  counts_.assign(10, 0);
+}
+
+void PolymorphismMafStatistics::processColumn(size_t i)
+{
+  // Counts are stored in the order F, P, FF, FP, PF, X, FX, PX, XF, XP:
+  int p1 = getPattern_(*view1_, i);
+  int p2 = getPattern_(*view2_, i);
+  switch (p1)
   {
-    int p1 = patterns1[i];
-    int p2 = patterns2[i];
-    switch (p1)
+  case -1:
+    switch (p2)
     {
     case -1:
-      switch (p2)
-      {
-      case -1:
-        nbX++;
-        break;
-      case -10:
-        nbXP++;
-        break;
-      default:
-        nbXF++;
-      }
+      counts_[5]++;
+      break;
+    case -10:
+      counts_[9]++;
       break;
+    default:
+      counts_[8]++;
+    }
+    break;
 
+  case -10:
+    switch (p2)
+    {
+    case -1:
+      counts_[7]++;
+      break;
     case -10:
-      switch (p2)
-      {
-      case -1:
-        nbPX++;
-        break;
-      case -10:
-        nbP++;
-        break;
-      default:
-        nbPF++;
-      }
+      counts_[1]++;
       break;
+    default:
+      counts_[4]++;
+    }
+    break;
 
+  default:
+    switch (p2)
+    {
+    case -1:
+      counts_[6]++;
+      break;
+    case -10:
+      counts_[3]++;
+      break;
     default:
-      switch (p2)
-      {
-      case -1:
-        nbFX++;
-        break;
-      case -10:
-        nbFP++;
-        break;
-      default:
-        if (p1 == p2)
-          nbF++;
-        else
-          nbFF++;
-      }
+      if (p1 == p2)
+        counts_[0]++;
+      else
+        counts_[2]++;
     }
   }
+}
 
-  // Set results:
-  result_.setValue("F", nbF);
-  result_.setValue("P", nbP);
-  result_.setValue("FF", nbFF);
-  result_.setValue("FP", nbFP);
-  result_.setValue("PF", nbPF);
-  result_.setValue("X", nbX);
-  result_.setValue("FX", nbFX);
-  result_.setValue("PX", nbPX);
-  result_.setValue("XF", nbXF);
-  result_.setValue("XP", nbXP);
+void PolymorphismMafStatistics::endBlock()
+{
+  result_.setValue("F", counts_[0]);
+  result_.setValue("P", counts_[1]);
+  result_.setValue("FF", counts_[2]);
+  result_.setValue("FP", counts_[3]);
+  result_.setValue("PF", counts_[4]);
+  result_.setValue("X", counts_[5]);
+  result_.setValue("FX", counts_[6]);
+  result_.setValue("PX", counts_[7]);
+  result_.setValue("XF", counts_[8]);
+  result_.setValue("XP", counts_[9]);
 }
 
 vector<string> SequenceDiversityMafStatistics::getSupportedTags() const
@@ -519,32 +646,76 @@ vector<string> SequenceDiversityMafStatistics::getSupportedTags() const
   return tags;
 }
 
-void SequenceDiversityMafStatistics::compute(const MafBlock& block)
+void SequenceDiversityMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
 {
-  unique_ptr<SiteContainerInterface> alignment = getSiteContainer_(block);
-  // Get only complete sites:
-  unique_ptr<VectorSiteContainer> alignment2 = SiteContainerTools::getCompleteSites<Site, Sequence>(*alignment);
+  if (!AlphabetTools::isNucleicAlphabet(*block.getAlphabet()))
+    throw Exception("SequenceDiversityMafStatistics::beginBlock. Only nucleotide alphabets are supported.");
+  vector<const MafSequence*> rows = getSpeciesSelection_().getSequences(block);
+  nbSequences_ = rows.size();
+  nbTot_ = 0;
+  nbSegregating_ = 0;
+  nbDifferences_ = 0;
 
-  double S = 0;
-  size_t nbTot = 0;
-  size_t n = alignment2->getNumberOfSequences();
-  if (n > 0)
+  // One plane per sequence and nucleotide. Gaps and unresolved characters are in none of them:
+  size_t nc = static_cast<size_t>(block.getNumberOfSites());
+  planes_.assign(4 * nbSequences_, MafBitPlane(nc));
+  for (size_t j = 0; j < nbSequences_; ++j)
   {
-    for (size_t i = 0; i < alignment2->getNumberOfSites(); ++i)
+    const vector<int>& content = rows[j]->getContent();
+    for (size_t i = 0; i < nc; ++i)
     {
-      const Site& site = alignment2->site(i);
-      if (SiteTools::isComplete(site))
-      {
-        nbTot++;
-        if (!SiteTools::isConstant(site))
-          S++;
-      }
+      if (static_cast<unsigned int>(content[i]) < 4)
+        planes_[4 * j + static_cast<size_t>(content[i])].set(i);
     }
   }
-  else
+  vector<const MafBitPlane*> planes(nbSequences_);
+  for (size_t k = 0; k < 4; ++k)
+  {
+    for (size_t j = 0; j < nbSequences_; ++j)
+    {
+      planes[j] = &planes_[4 * j + k];
+    }
+    if (nbSequences_ > 0)
+      MafBitPlane::countColumns(planes, alleleCounts_[k]);
+    else
+      alleleCounts_[k].assign(nc, 0);
+  }
+}
+
+void SequenceDiversityMafStatistics::processColumn(size_t i)
+{
+  // Only complete sites are analyzed:
+  size_t n = nbSequences_;
+  if (n == 0)
+    return;
+  size_t nbResolved = 0;
+  size_t sumSquares = 0;
+  for (size_t k = 0; k < 4; ++k)
   {
-    nbTot = alignment2->getNumberOfSites();
+    size_t c = alleleCounts_[k][i];
+    nbResolved += c;
+    sumSquares += c * c;
   }
+  if (nbResolved < n)
+    return;
+  nbTot_++;
+  // Number of pairs of sequences with distinct states:
+  size_t nbDiff = (n * n - sumSquares) / 2;
+  if (nbDiff > 0)
+    nbSegregating_++;
+  nbDifferences_ += static_cast<double>(nbDiff);
+}
+
+void SequenceDiversityMafStatistics::endBlock()
+{
+  computeDiversity_(nbSequences_, static_cast<double>(nbTot_), nbSegregating_, nbDifferences_, result_);
+}
+
+const SequenceDiversityMafStatistics::Constants_& SequenceDiversityMafStatistics::getConstants_(size_t n)
+{
+  auto it = constants_.find(n);
+  if (it != constants_.end())
+    return it->second;
 
   double a1 = 0;
   double a2 = 0;
@@ -554,35 +725,985 @@ void SequenceDiversityMafStatistics::compute(const MafBlock& block)
     a1 += 1. / i;
     a2 += 1. / (i * i);
   }
-  double wt = S / (static_cast<double>(nbTot) * a1);
   double b1 = (dn + 1) / (3 * (dn - 1));
   double b2 = 2 * (dn * dn + dn + 3) / (9 * dn * (dn - 1));
   double c1 = b1 - 1. / a1;
   double c2 = b2 - (dn + 2) / (a1 * dn) + a2 / (a1 * a1);
-  double e1 = c1 / a1;
-  double e2 = c2 / (a1 * a1 + a2);
+  Constants_& constants = constants_[n];
+  constants.a1 = a1;
+  constants.a2 = a2;
+  constants.e1 = c1 / a1;
+  constants.e2 = c2 / (a1 * a1 + a2);
+  return constants;
+}
+
+void SequenceDiversityMafStatistics::computeDiversity_(size_t n, double nbTot, double nbSegregating, double nbDifferences, MafStatisticsResult& result)
+{
+  double S = nbSegregating;
+  double dn = static_cast<double>(n);
+  const Constants_& constants = getConstants_(n);
+  double wt = S / (nbTot * constants.a1);
+
+  // Pairwise heterozygosity, as the proportion of differences averaged over all pairs of sequences:
+  double pi = nbDifferences / nbTot / (dn * (dn - 1) / 2);
 
-  // Compute pairwise heterozigosity:
-  double pi = 0;
-  for (size_t i = 0; i < n - 1; ++i)
+  // Compute Tajima's D:
+  double tajd = nbTot * (pi - wt) / sqrt(constants.e1 * S + constants.e2 * S * (S - 1));
+
+  result.setValue("NbSeggregating", S);
+  result.setValue("WattersonTheta", wt);
+  result.setValue("TajimaPi", pi);
+  result.setValue("TajimaD", tajd);
+}
+
+void SequenceDiversityMafStatistics::accumulate()
+{
+  array<double, 3>& totals = totals_[nbSequences_];
+  totals[0] += static_cast<double>(nbTot_);
+  totals[1] += nbSegregating_;
+  totals[2] += nbDifferences_;
+}
+
+void SequenceDiversityMafStatistics::merge(const MafStatisticsAccumulatorInterface& accumulator)
+{
+  auto stats = dynamic_cast<const SequenceDiversityMafStatistics*>(&accumulator);
+  if (!stats)
+    throw Exception("SequenceDiversityMafStatistics::merge. Accumulator is not a SequenceDiversityMafStatistics.");
+  for (const auto& it : stats->totals_)
   {
-    for (size_t j = i + 1; j < n; ++j)
+    array<double, 3>& totals = totals_[it.first];
+    for (size_t k = 0; k < 3; ++k)
     {
-      pi += SiteContainerTools::computeSimilarity(
-            alignment2->sequence(i),
-            alignment2->sequence(j),
-            true,
-            SiteContainerTools::SIMILARITY_NOGAP,
-            true);
+      totals[k] += it.second[k];
     }
   }
-  pi /= static_cast<double>((n - 1) * n / 2);
+}
 
-  // Compute Tajima's D:
-  double tajd = static_cast<double>(nbTot) * (pi - wt) / sqrt(e1 * S + e2 * S * (S - 1));
+void SequenceDiversityMafStatistics::saveAccumulator(ostream& out) const
+{
+  MafBlockSerializer::writeSize(out, totals_.size());
+  for (const auto& it : totals_)
+  {
+    MafBlockSerializer::writeSize(out, it.first);
+    for (double x : it.second)
+    {
+      MafBlockSerializer::writeDouble(out, x);
+    }
+  }
+}
+
+void SequenceDiversityMafStatistics::restoreAccumulator(istream& in)
+{
+  totals_.clear();
+  size_t n = MafBlockSerializer::readSize(in);
+  for (size_t i = 0; i < n; ++i)
+  {
+    array<double, 3>& totals = totals_[MafBlockSerializer::readSize(in)];
+    for (double& x : totals)
+    {
+      x = MafBlockSerializer::readDouble(in);
+    }
+  }
+}
+
+void SequenceDiversityMafStatistics::finalize()
+{
+  if (totals_.size() == 1)
+  {
+    const auto& it = *totals_.begin();
+    computeDiversity_(it.first, it.second[0], it.second[1], it.second[2], accumulatedResult_);
+    return;
+  }
+  // Estimates per site are summed over the distinct numbers of sequences. Sites with less than two sequences are not informative:
+  double nbTot = 0;
+  double S = 0;
+  double sumWt = 0;
+  double sumPi = 0;
+  for (const auto& it : totals_)
+  {
+    if (it.first < 2)
+      continue;
+    double dn = static_cast<double>(it.first);
+    double a1 = getConstants_(it.first).a1;
+    nbTot += it.second[0];
+    S += it.second[1];
+    sumWt += it.second[1] / a1;
+    sumPi += it.second[2] / (dn * (dn - 1) / 2);
+  }
+  accumulatedResult_.setValue("NbSeggregating", S);
+  accumulatedResult_.setValue("WattersonTheta", sumWt / nbTot);
+  accumulatedResult_.setValue("TajimaPi", sumPi / nbTot);
+  accumulatedResult_.setValue("TajimaD", NumConstants::NaN());
+}
 
-  result_.setValue("NbSeggregating", S);
-  result_.setValue("WattersonTheta", wt);
-  result_.setValue("TajimaPi", pi);
-  result_.setValue("TajimaD", tajd);
+void AbstractAdditiveMafStatistics::accumulate()
+{
+  const MafStatisticsResult& result = getResult();
+  if (tagIndices_.empty())
+    initSums_();
+  for (size_t k = 0; k < tagIndices_.size(); ++k)
+  {
+    if (result.hasValueAt(tagIndices_[k]))
+      sums_[k] += result.getNumericValueAt(tagIndices_[k]);
+  }
+}
+
+void AbstractAdditiveMafStatistics::initSums_()
+{
+  // Tags are resolved once, sums are stored in the order of getSupportedTags:
+  const MafStatisticsResult& result = getResult();
+  for (const auto& tag : getSupportedTags())
+  {
+    tagIndices_.push_back(result.getTagIndex(tag));
+  }
+  // Sums restored from a checkpoint are kept:
+  if (sums_.size() != tagIndices_.size())
+    sums_.assign(tagIndices_.size(), 0.);
+}
+
+void AbstractAdditiveMafStatistics::merge(const MafStatisticsAccumulatorInterface& accumulator)
+{
+  auto stats = dynamic_cast<const AbstractAdditiveMafStatistics*>(&accumulator);
+  if (!stats || stats->getShortName() != getShortName())
+    throw Exception("AbstractAdditiveMafStatistics::merge. Accumulators are not instances of the same statistic.");
+  if (stats->sums_.empty())
+    return;
+  if (tagIndices_.empty())
+    initSums_();
+  if (stats->sums_.size() != sums_.size())
+    throw Exception("AbstractAdditiveMafStatistics::merge. Accumulators have distinct numbers of tags: " + TextTools::toString(stats->sums_.size()) + " and " + TextTools::toString(sums_.size()) + ".");
+  for (size_t k = 0; k < sums_.size(); ++k)
+  {
+    sums_[k] += stats->sums_[k];
+  }
+}
+
+void AbstractAdditiveMafStatistics::saveAccumulator(ostream& out) const
+{
+  MafBlockSerializer::writeSize(out, sums_.size());
+  for (double x : sums_)
+  {
+    MafBlockSerializer::writeDouble(out, x);
+  }
+}
+
+void AbstractAdditiveMafStatistics::restoreAccumulator(istream& in)
+{
+  // Tag indices are resolved when the next block is accumulated:
+  sums_.resize(MafBlockSerializer::readSize(in));
+  for (double& x : sums_)
+  {
+    x = MafBlockSerializer::readDouble(in);
+  }
+}
+
+void AbstractAdditiveMafStatistics::finalize()
+{
+  vector<string> tags = getSupportedTags();
+  for (size_t k = 0; k < tags.size(); ++k)
+  {
+    accumulatedResult_.setValue(tags[k], k < sums_.size() ? sums_[k] : 0.);
+  }
+}
+
+const size_t DivergenceMatrixMafStatistics::TILE_SIZE = 64;
+
+DivergenceMatrixMafStatistics::DivergenceMatrixMafStatistics(const vector<string>& species) :
+  AbstractMafStatistics(),
+  species_(species),
+  planes_(),
+  present_(species.size(), false),
+  mismatches_(species.size() * (species.size() - 1) / 2, 0),
+  comparable_(species.size() * (species.size() - 1) / 2, 0),
+  tagIndices_(),
+  totalMismatches_(species.size() * (species.size() - 1) / 2, 0.),
+  totalComparable_(species.size() * (species.size() - 1) / 2, 0.),
+  accumulatedResult_()
+{
+  if (species.size() < 2)
+    throw Exception("DivergenceMatrixMafStatistics (constructor). At least two species should be provided.");
+  for (const auto& tag : DivergenceMatrixMafStatistics::getSupportedTags())
+  {
+    tagIndices_.push_back(result_.getTagIndex(tag));
+  }
+}
+
+vector<string> DivergenceMatrixMafStatistics::getSupportedTags() const
+{
+  vector<string> tags;
+  for (size_t i = 0; i + 1 < species_.size(); ++i)
+  {
+    for (size_t j = i + 1; j < species_.size(); ++j)
+    {
+      tags.push_back(species_[i] + "-" + species_[j]);
+    }
+  }
+  return tags;
+}
+
+void DivergenceMatrixMafStatistics::compute(const MafBlock& block)
+{
+  if (!AlphabetTools::isNucleicAlphabet(*block.getAlphabet()))
+    throw Exception("DivergenceMatrixMafStatistics::compute. Only nucleotide alphabets are supported.");
+  size_t nbSpecies = species_.size();
+  size_t nc = static_cast<size_t>(block.getNumberOfSites());
+  size_t nbWords = (nc + 63) / 64;
+
+  // Encode each sequence as four nucleotide planes and one plane of resolved sites:
+  planes_.assign(nbSpecies * 5 * nbWords, 0);
+  for (size_t k = 0; k < nbSpecies; ++k)
+  {
+    vector<const MafSequence*> seqs = block.getSequencesForSpecies(species_[k]);
+    if (seqs.size() > 1)
+      throw Exception("DivergenceMatrixMafStatistics::compute. Duplicated sequence for species " + species_[k] + ".");
+    present_[k] = (seqs.size() == 1);
+    if (!present_[k])
+      continue;
+    const vector<int>& content = seqs[0]->getContent();
+    uint64_t* planes = &planes_[k * 5 * nbWords];
+    for (size_t i = 0; i < nc; ++i)
+    {
+      int state = content[i];
+      if (static_cast<unsigned int>(state) < 4)
+      {
+        uint64_t bit = uint64_t(1) << (i & 63);
+        planes[static_cast<size_t>(state) * nbWords + (i >> 6)] |= bit;
+        planes[4 * nbWords + (i >> 6)] |= bit;
+      }
+    }
+  }
+
+  // Compare all pairs, one tile of sites at a time:
+  fill(mismatches_.begin(), mismatches_.end(), 0);
+  fill(comparable_.begin(), comparable_.end(), 0);
+  for (size_t w0 = 0; w0 < nbWords; w0 += TILE_SIZE)
+  {
+    size_t w1 = min(nbWords, w0 + TILE_SIZE);
+    size_t p = 0;
+    for (size_t i = 0; i + 1 < nbSpecies; ++i)
+    {
+      const uint64_t* planes1 = &planes_[i * 5 * nbWords];
+      for (size_t j = i + 1; j < nbSpecies; ++j, ++p)
+      {
+        if (!present_[i] || !present_[j])
+          continue;
+        const uint64_t* planes2 = &planes_[j * 5 * nbWords];
+        unsigned int nbMismatches = 0;
+        unsigned int nbComparable = 0;
+        for (size_t w = w0; w < w1; ++w)
+        {
+          uint64_t comparable = planes1[4 * nbWords + w] & planes2[4 * nbWords + w];
+          uint64_t match = (planes1[w] & planes2[w])
+                           | (planes1[nbWords + w] & planes2[nbWords + w])
+                           | (planes1[2 * nbWords + w] & planes2[2 * nbWords + w])
+                           | (planes1[3 * nbWords + w] & planes2[3 * nbWords + w]);
+          nbComparable += static_cast<unsigned int>(bitset<64>(comparable).count());
+          nbMismatches += static_cast<unsigned int>(bitset<64>(comparable & ~match).count());
+        }
+        mismatches_[p] += nbMismatches;
+        comparable_[p] += nbComparable;
+      }
+    }
+  }
+
+  size_t p = 0;
+  for (size_t i = 0; i + 1 < nbSpecies; ++i)
+  {
+    for (size_t j = i + 1; j < nbSpecies; ++j, ++p)
+    {
+      if (present_[i] && present_[j] && comparable_[p] > 0)
+        result_.setValueAt(tagIndices_[p], 100. * static_cast<double>(mismatches_[p]) / static_cast<double>(comparable_[p]));
+      else
+        result_.setValueAt(tagIndices_[p], NumConstants::NaN());
+    }
+  }
+}
+
+void DivergenceMatrixMafStatistics::accumulate()
+{
+  for (size_t p = 0; p < mismatches_.size(); ++p)
+  {
+    totalMismatches_[p] += mismatches_[p];
+    totalComparable_[p] += comparable_[p];
+  }
+}
+
+void DivergenceMatrixMafStatistics::merge(const MafStatisticsAccumulatorInterface& accumulator)
+{
+  auto stats = dynamic_cast<const DivergenceMatrixMafStatistics*>(&accumulator);
+  if (!stats || stats->species_ != species_)
+    throw Exception("DivergenceMatrixMafStatistics::merge. Accumulators do not compare the same species.");
+  for (size_t p = 0; p < totalMismatches_.size(); ++p)
+  {
+    totalMismatches_[p] += stats->totalMismatches_[p];
+    totalComparable_[p] += stats->totalComparable_[p];
+  }
+}
+
+void DivergenceMatrixMafStatistics::resetAccumulator()
+{
+  fill(totalMismatches_.begin(), totalMismatches_.end(), 0.);
+  fill(totalComparable_.begin(), totalComparable_.end(), 0.);
+}
+
+void DivergenceMatrixMafStatistics::saveAccumulator(ostream& out) const
+{
+  MafBlockSerializer::writeSize(out, totalMismatches_.size());
+  for (size_t p = 0; p < totalMismatches_.size(); ++p)
+  {
+    MafBlockSerializer::writeDouble(out, totalMismatches_[p]);
+    MafBlockSerializer::writeDouble(out, totalComparable_[p]);
+  }
+}
+
+void DivergenceMatrixMafStatistics::restoreAccumulator(istream& in)
+{
+  if (MafBlockSerializer::readSize(in) != totalMismatches_.size())
+    throw Exception("DivergenceMatrixMafStatistics::restoreAccumulator. Totals do not match the number of pairs of species.");
+  for (size_t p = 0; p < totalMismatches_.size(); ++p)
+  {
+    totalMismatches_[p] = MafBlockSerializer::readDouble(in);
+    totalComparable_[p] = MafBlockSerializer::readDouble(in);
+  }
+}
+
+void DivergenceMatrixMafStatistics::finalize()
+{
+  vector<string> tags = getSupportedTags();
+  for (size_t p = 0; p < tags.size(); ++p)
+  {
+    accumulatedResult_.setValue(tags[p], totalComparable_[p] > 0 ? 100. * totalMismatches_[p] / totalComparable_[p] : NumConstants::NaN());
+  }
+}
+
+vector<vector<string>> AbbaBabaMafStatistics::getSelections_(
+    const vector<vector<string>>& populations,
+    const vector<string>& outgroup)
+{
+  vector<vector<string>> selections = populations;
+  selections.push_back(outgroup);
+  return selections;
+}
+
+AbbaBabaMafStatistics::AbbaBabaMafStatistics(
+    const vector<string>& names,
+    const vector<vector<string>>& populations,
+    const vector<string>& outgroup,
+    size_t jackknifeBlockSize) :
+  AbstractMafStatistics(),
+  AbstractSpeciesMultipleSelectionMafStatistics(getSelections_(populations, outgroup)),
+  AbstractMafColumnStatistics(),
+  names_(names),
+  jackknifeBlockSize_(jackknifeBlockSize),
+  triplets_(),
+  views_(),
+  counts_(populations.size() + 1),
+  frequencies_(populations.size() + 1, 0.),
+  sums_(),
+  nbColumns_(0),
+  tagIndices_(),
+  jackknifeSums_(),
+  currentJackknifeSums_(),
+  currentJackknifeSize_(0),
+  accumulatedResult_()
+{
+  if (populations.size() < 3)
+    throw Exception("AbbaBabaMafStatistics (constructor). At least three ingroup populations should be provided.");
+  if (names.size() != populations.size())
+    throw Exception("AbbaBabaMafStatistics (constructor). The number of names does not match the number of populations.");
+  if (outgroup.size() == 0)
+    throw Exception("AbbaBabaMafStatistics (constructor). The outgroup should contain at least one species.");
+  if (jackknifeBlockSize == 0)
+    throw Exception("AbbaBabaMafStatistics (constructor). Jackknife block size should be at least 1.");
+  size_t n = populations.size();
+  for (size_t i = 0; i + 1 < n; ++i)
+  {
+    for (size_t j = i + 1; j < n; ++j)
+    {
+      for (size_t k = 0; k < n; ++k)
+      {
+        if (k != i && k != j)
+          triplets_.push_back(Triplet_{i, j, k});
+      }
+    }
+  }
+  sums_.assign(2 * triplets_.size(), 0.);
+  currentJackknifeSums_.assign(2 * triplets_.size(), 0.);
+  for (const auto& tag : AbbaBabaMafStatistics::getSupportedTags())
+  {
+    tagIndices_.push_back(result_.getTagIndex(tag));
+  }
+}
+
+string AbbaBabaMafStatistics::getConfiguration() const
+{
+  // The last selection is the outgroup:
+  return getShortName() + "(names=" + VectorTools::paste(names_, ",") + "," + getSpeciesConfiguration_()
+         + ",jackknife=" + TextTools::toString(jackknifeBlockSize_) + ")";
+}
+
+vector<string> AbbaBabaMafStatistics::getSupportedTags() const
+{
+  vector<string> tags;
+  for (const auto& triplet : triplets_)
+  {
+    string name = getTripletName_(triplet);
+    tags.push_back(name + ".ABBA");
+    tags.push_back(name + ".BABA");
+    tags.push_back(name + ".D");
+    tags.push_back(name + ".SE");
+    tags.push_back(name + ".Z");
+  }
+  return tags;
+}
+
+void AbbaBabaMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
+{
+  if (!AlphabetTools::isNucleicAlphabet(*block.getAlphabet()))
+    throw Exception("AbbaBabaMafStatistics::beginBlock. Only nucleotide alphabets are supported.");
+  views_ = views;
+  nbColumns_ = 0;
+  fill(sums_.begin(), sums_.end(), 0.);
+}
+
+void AbbaBabaMafStatistics::processColumn(size_t i)
+{
+  // Jackknife blocks are measured in analysed columns, masked columns being skipped:
+  nbColumns_++;
+  // Find the two alleles of the site, over all populations:
+  int allele1 = -1;
+  int allele2 = -1;
+  for (size_t k = 0; k < views_.size(); ++k)
+  {
+    size_t n = views_[k]->getNumberOfRows();
+    if (n == 0)
+      return;
+    counts_[k].count(views_[k]->column(i), n);
+    for (int s = 0; s < 4; ++s)
+    {
+      if (counts_[k].getCount(static_cast<size_t>(s)) == 0 || s == allele1 || s == allele2)
+        continue;
+      if (allele1 < 0)
+        allele1 = s;
+      else if (allele2 < 0)
+        allele2 = s;
+      else
+        return; // More than two alleles.
+    }
+  }
+  if (allele2 < 0)
+    return; // Constant sites do not contribute.
+  for (size_t k = 0; k < views_.size(); ++k)
+  {
+    unsigned int c1 = counts_[k].getCount(static_cast<size_t>(allele1));
+    unsigned int c2 = counts_[k].getCount(static_cast<size_t>(allele2));
+    if (c1 + c2 == 0)
+      return; // No resolved character in this population.
+    frequencies_[k] = static_cast<double>(c1) / static_cast<double>(c1 + c2);
+  }
+
+  double pO = frequencies_.back();
+  for (size_t t = 0; t < triplets_.size(); ++t)
+  {
+    double p1 = frequencies_[triplets_[t].p1];
+    double p2 = frequencies_[triplets_[t].p2];
+    double p3 = frequencies_[triplets_[t].p3];
+    sums_[2 * t] += (1. - p1) * p2 * p3 * (1. - pO) + p1 * (1. - p2) * (1. - p3) * pO;
+    sums_[2 * t + 1] += p1 * (1. - p2) * p3 * (1. - pO) + (1. - p1) * p2 * (1. - p3) * pO;
+  }
+}
+
+void AbbaBabaMafStatistics::endBlock()
+{
+  for (size_t t = 0; t < triplets_.size(); ++t)
+  {
+    double abba = sums_[2 * t];
+    double baba = sums_[2 * t + 1];
+    result_.setValueAt(tagIndices_[5 * t], abba);
+    result_.setValueAt(tagIndices_[5 * t + 1], baba);
+    result_.setValueAt(tagIndices_[5 * t + 2], abba + baba > 0 ? (abba - baba) / (abba + baba) : NumConstants::NaN());
+    result_.setValueAt(tagIndices_[5 * t + 3], NumConstants::NaN());
+    result_.setValueAt(tagIndices_[5 * t + 4], NumConstants::NaN());
+  }
+}
+
+void AbbaBabaMafStatistics::accumulate()
+{
+  for (size_t k = 0; k < sums_.size(); ++k)
+  {
+    currentJackknifeSums_[k] += sums_[k];
+  }
+  currentJackknifeSize_ += nbColumns_;
+  if (currentJackknifeSize_ >= jackknifeBlockSize_)
+  {
+    jackknifeSums_.push_back(currentJackknifeSums_);
+    fill(currentJackknifeSums_.begin(), currentJackknifeSums_.end(), 0.);
+    currentJackknifeSize_ = 0;
+  }
+}
+
+void AbbaBabaMafStatistics::merge(const MafStatisticsAccumulatorInterface& accumulator)
+{
+  auto stats = dynamic_cast<const AbbaBabaMafStatistics*>(&accumulator);
+  if (!stats || stats->names_ != names_ || stats->getSpeciesSelections() != getSpeciesSelections())
+    throw Exception("AbbaBabaMafStatistics::merge. Accumulators do not compare the same populations.");
+  jackknifeSums_.insert(jackknifeSums_.end(), stats->jackknifeSums_.begin(), stats->jackknifeSums_.end());
+  // Incomplete jackknife blocks are merged together:
+  for (size_t k = 0; k < currentJackknifeSums_.size(); ++k)
+  {
+    currentJackknifeSums_[k] += stats->currentJackknifeSums_[k];
+  }
+  currentJackknifeSize_ += stats->currentJackknifeSize_;
+  if (currentJackknifeSize_ >= jackknifeBlockSize_)
+  {
+    jackknifeSums_.push_back(currentJackknifeSums_);
+    fill(currentJackknifeSums_.begin(), currentJackknifeSums_.end(), 0.);
+    currentJackknifeSize_ = 0;
+  }
+}
+
+void AbbaBabaMafStatistics::resetAccumulator()
+{
+  jackknifeSums_.clear();
+  fill(currentJackknifeSums_.begin(), currentJackknifeSums_.end(), 0.);
+  currentJackknifeSize_ = 0;
+}
+
+void AbbaBabaMafStatistics::saveAccumulator(ostream& out) const
+{
+  MafBlockSerializer::writeSize(out, currentJackknifeSums_.size());
+  MafBlockSerializer::writeSize(out, jackknifeSums_.size());
+  for (const auto& sums : jackknifeSums_)
+  {
+    for (double x : sums)
+    {
+      MafBlockSerializer::writeDouble(out, x);
+    }
+  }
+  for (double x : currentJackknifeSums_)
+  {
+    MafBlockSerializer::writeDouble(out, x);
+  }
+  MafBlockSerializer::writeSize(out, currentJackknifeSize_);
+}
+
+void AbbaBabaMafStatistics::restoreAccumulator(istream& in)
+{
+  size_t n = currentJackknifeSums_.size();
+  if (MafBlockSerializer::readSize(in) != n)
+    throw Exception("AbbaBabaMafStatistics::restoreAccumulator. Totals do not match the number of triplets.");
+  jackknifeSums_.assign(MafBlockSerializer::readSize(in), vector<double>(n));
+  for (auto& sums : jackknifeSums_)
+  {
+    for (double& x : sums)
+    {
+      x = MafBlockSerializer::readDouble(in);
+    }
+  }
+  for (double& x : currentJackknifeSums_)
+  {
+    x = MafBlockSerializer::readDouble(in);
+  }
+  currentJackknifeSize_ = MafBlockSerializer::readSize(in);
+}
+
+void AbbaBabaMafStatistics::finalize()
+{
+  // The last, incomplete jackknife block is also used:
+  vector<const vector<double>*> blocks;
+  for (const auto& sums : jackknifeSums_)
+  {
+    blocks.push_back(&sums);
+  }
+  if (currentJackknifeSize_ > 0)
+    blocks.push_back(&currentJackknifeSums_);
+  size_t m = blocks.size();
+  double dm = static_cast<double>(m);
+
+  vector<double> deleteOne(m);
+  for (size_t t = 0; t < triplets_.size(); ++t)
+  {
+    double abba = 0;
+    double baba = 0;
+    for (const auto& sums : blocks)
+    {
+      abba += (*sums)[2 * t];
+      baba += (*sums)[2 * t + 1];
+    }
+    double d = abba + baba > 0 ? (abba - baba) / (abba + baba) : NumConstants::NaN();
+    double se = NumConstants::NaN();
+    if (m > 1)
+    {
+      // Delete-one block jackknife:
+      double mean = 0;
+      for (size_t b = 0; b < m; ++b)
+      {
+        double abbaB = abba - (*blocks[b])[2 * t];
+        double babaB = baba - (*blocks[b])[2 * t + 1];
+        deleteOne[b] = (abbaB - babaB) / (abbaB + babaB);
+        mean += deleteOne[b];
+      }
+      mean /= dm;
+      double ss = 0;
+      for (size_t b = 0; b < m; ++b)
+      {
+        ss += (deleteOne[b] - mean) * (deleteOne[b] - mean);
+      }
+      se = sqrt((dm - 1.) / dm * ss);
+    }
+    string name = getTripletName_(triplets_[t]);
+    accumulatedResult_.setValue(name + ".ABBA", abba);
+    accumulatedResult_.setValue(name + ".BABA", baba);
+    accumulatedResult_.setValue(name + ".D", d);
+    accumulatedResult_.setValue(name + ".SE", se);
+    accumulatedResult_.setValue(name + ".Z", d / se);
+  }
+}
+
+vector<vector<string>> JointSiteFrequencySpectrumMafStatistics::getSelections_(
+    const vector<vector<string>>& populations,
+    const vector<string>& outgroup)
+{
+  vector<vector<string>> selections = populations;
+  if (outgroup.size() > 0)
+    selections.push_back(outgroup);
+  return selections;
+}
+
+JointSiteFrequencySpectrumMafStatistics::JointSiteFrequencySpectrumMafStatistics(
+    const vector<string>& names,
+    const vector<vector<string>>& populations,
+    const vector<string>& outgroup) :
+  AbstractMafStatistics(),
+  AbstractSpeciesMultipleSelectionMafStatistics(getSelections_(populations, outgroup)),
+  AbstractMafColumnStatistics(),
+  names_(names),
+  sampleSizes_(),
+  strides_(populations.size()),
+  folded_(outgroup.size() == 0),
+  views_(),
+  counts_(populations.size() + 1),
+  usableBlock_(false),
+  blockSpectrum_(),
+  nbSites_(0),
+  nbIgnored_(0),
+  spectrum_(),
+  totalSites_(0),
+  totalIgnored_(0),
+  accumulatedResult_()
+{
+  if (populations.size() < 2)
+    throw Exception("JointSiteFrequencySpectrumMafStatistics (constructor). At least two populations should be provided.");
+  if (names.size() != populations.size())
+    throw Exception("JointSiteFrequencySpectrumMafStatistics (constructor). The number of names does not match the number of populations.");
+  // Entries are stored in row-major order, as in dadi:
+  size_t size = 1;
+  for (size_t k = populations.size(); k > 0; --k)
+  {
+    if (populations[k - 1].size() == 0)
+      throw Exception("JointSiteFrequencySpectrumMafStatistics (constructor). Empty population: " + names[k - 1] + ".");
+    strides_[k - 1] = size;
+    size *= populations[k - 1].size() + 1;
+  }
+  for (const auto& population : populations)
+  {
+    sampleSizes_.push_back(population.size());
+  }
+  spectrum_.assign(size, 0.);
+}
+
+string JointSiteFrequencySpectrumMafStatistics::getConfiguration() const
+{
+  // If the spectrum is unfolded, the last selection is the outgroup:
+  return getShortName() + "(names=" + VectorTools::paste(names_, ",") + "," + getSpeciesConfiguration_()
+         + ",folded=" + (folded_ ? "yes" : "no") + ")";
+}
+
+vector<string> JointSiteFrequencySpectrumMafStatistics::getSupportedTags() const
+{
+  vector<string> tags;
+  tags.push_back("NbSites");
+  tags.push_back("NbIgnored");
+  return tags;
+}
+
+size_t JointSiteFrequencySpectrumMafStatistics::getIndex(const vector<size_t>& derived) const
+{
+  size_t index = 0;
+  for (size_t k = 0; k < strides_.size(); ++k)
+  {
+    index += derived[k] * strides_[k];
+  }
+  return index;
+}
+
+void JointSiteFrequencySpectrumMafStatistics::beginBlock(const MafBlock& block, const vector<const MafColumnView*>& views)
+{
+  if (!AlphabetTools::isNucleicAlphabet(*block.getAlphabet()))
+    throw Exception("JointSiteFrequencySpectrumMafStatistics::beginBlock. Only nucleotide alphabets are supported.");
+  views_ = views;
+  blockSpectrum_.clear();
+  nbSites_ = 0;
+  nbIgnored_ = 0;
+  // Sample sizes have to be constant:
+  usableBlock_ = folded_ || views_.back()->getNumberOfRows() > 0;
+  for (size_t k = 0; k < sampleSizes_.size(); ++k)
+  {
+    if (views_[k]->getNumberOfRows() != sampleSizes_[k])
+      usableBlock_ = false;
+  }
+}
+
+void JointSiteFrequencySpectrumMafStatistics::processColumn(size_t i)
+{
+  if (!usableBlock_)
+  {
+    nbIgnored_++;
+    return;
+  }
+  int alleles[2] = {-1, -1};
+  size_t nbAlleles = 0;
+  auto addAlleles = [&](const MafNucleotideCounts& counts)
+  {
+    for (int s = 0; s < 4; ++s)
+    {
+      if (counts.getCount(static_cast<size_t>(s)) == 0 || (nbAlleles > 0 && alleles[0] == s) || (nbAlleles > 1 && alleles[1] == s))
+        continue;
+      if (nbAlleles == 2)
+        return false;
+      alleles[nbAlleles++] = s;
+    }
+    return true;
+  };
+
+  // The ancestral state, if any, is the first allele:
+  if (!folded_)
+  {
+    MafNucleotideCounts& counts = counts_.back();
+    counts.count(views_.back()->column(i), views_.back()->getNumberOfRows());
+    if (!counts.isComplete() || counts.getNumberOfAlleles() != 1)
+    {
+      nbIgnored_++;
+      return;
+    }
+    addAlleles(counts);
+  }
+  size_t nbPopulations = sampleSizes_.size();
+  for (size_t k = 0; k < nbPopulations; ++k)
+  {
+    counts_[k].count(views_[k]->column(i), sampleSizes_[k]);
+    if (!counts_[k].isComplete() || !addAlleles(counts_[k]))
+    {
+      nbIgnored_++;
+      return;
+    }
+  }
+
+  // Count the second allele, which is the derived one for unfolded spectra:
+  size_t index = 0;
+  size_t nbDerived = 0;
+  size_t nbTotal = 0;
+  for (size_t k = 0; k < nbPopulations; ++k)
+  {
+    size_t d = nbAlleles == 2 ? counts_[k].getCount(static_cast<size_t>(alleles[1])) : 0;
+    index += d * strides_[k];
+    nbDerived += d;
+    nbTotal += sampleSizes_[k];
+  }
+  nbSites_++;
+  if (!folded_ || 2 * nbDerived < nbTotal)
+  {
+    blockSpectrum_[index] += 1.;
+  }
+  else
+  {
+    // The symmetric entry is obtained by reversing all indices:
+    size_t symmetric = spectrum_.size() - 1 - index;
+    if (2 * nbDerived > nbTotal)
+    {
+      blockSpectrum_[symmetric] += 1.;
+    }
+    else
+    {
+      blockSpectrum_[index] += 0.5;
+      blockSpectrum_[symmetric] += 0.5;
+    }
+  }
+}
+
+void JointSiteFrequencySpectrumMafStatistics::endBlock()
+{
+  result_.setValue("NbSites", nbSites_);
+  result_.setValue("NbIgnored", nbIgnored_);
+}
+
+void JointSiteFrequencySpectrumMafStatistics::accumulate()
+{
+  for (const auto& entry : blockSpectrum_)
+  {
+    spectrum_[entry.first] += entry.second;
+  }
+  totalSites_ += nbSites_;
+  totalIgnored_ += nbIgnored_;
+}
+
+void JointSiteFrequencySpectrumMafStatistics::merge(const MafStatisticsAccumulatorInterface& accumulator)
+{
+  auto stats = dynamic_cast<const JointSiteFrequencySpectrumMafStatistics*>(&accumulator);
+  if (!stats || stats->names_ != names_ || stats->getSpeciesSelections() != getSpeciesSelections())
+    throw Exception("JointSiteFrequencySpectrumMafStatistics::merge. Accumulators do not compare the same populations.");
+  for (size_t k = 0; k < spectrum_.size(); ++k)
+  {
+    spectrum_[k] += stats->spectrum_[k];
+  }
+  totalSites_ += stats->totalSites_;
+  totalIgnored_ += stats->totalIgnored_;
+}
+
+void JointSiteFrequencySpectrumMafStatistics::resetAccumulator()
+{
+  fill(spectrum_.begin(), spectrum_.end(), 0.);
+  totalSites_ = 0;
+  totalIgnored_ = 0;
+}
+
+void JointSiteFrequencySpectrumMafStatistics::saveAccumulator(ostream& out) const
+{
+  MafBlockSerializer::writeSize(out, spectrum_.size());
+  for (double x : spectrum_)
+  {
+    MafBlockSerializer::writeDouble(out, x);
+  }
+  MafBlockSerializer::writeDouble(out, totalSites_);
+  MafBlockSerializer::writeDouble(out, totalIgnored_);
+}
+
+void JointSiteFrequencySpectrumMafStatistics::restoreAccumulator(istream& in)
+{
+  if (MafBlockSerializer::readSize(in) != spectrum_.size())
+    throw Exception("JointSiteFrequencySpectrumMafStatistics::restoreAccumulator. Totals do not match the sample sizes.");
+  for (double& x : spectrum_)
+  {
+    x = MafBlockSerializer::readDouble(in);
+  }
+  totalSites_ = MafBlockSerializer::readDouble(in);
+  totalIgnored_ = MafBlockSerializer::readDouble(in);
+}
+
+void JointSiteFrequencySpectrumMafStatistics::finalize()
+{
+  accumulatedResult_.setValue("NbSites", totalSites_);
+  accumulatedResult_.setValue("NbIgnored", totalIgnored_);
+}
+
+void JointSiteFrequencySpectrumMafStatistics::writeDadiSpectrum(ostream& out) const
+{
+  for (size_t k = 0; k < sampleSizes_.size(); ++k)
+  {
+    out << (sampleSizes_[k] + 1) << " ";
+  }
+  out << (folded_ ? "folded" : "unfolded");
+  for (const auto& name : names_)
+  {
+    out << " \"" << name << "\"";
+  }
+  out << endl;
+  // Counts easily exceed the default precision of streams, so all digits are written:
+  streamsize precision = out.precision(numeric_limits<double>::max_digits10);
+  for (size_t i = 0; i < spectrum_.size(); ++i)
+  {
+    out << (i > 0 ? " " : "") << spectrum_[i];
+  }
+  out.precision(precision);
+  out << endl;
+
+  size_t nbTotal = 0;
+  for (size_t n : sampleSizes_)
+  {
+    nbTotal += n;
+  }
+  for (size_t i = 0; i < spectrum_.size(); ++i)
+  {
+    size_t nbDerived = 0;
+    for (size_t k = 0; k < sampleSizes_.size(); ++k)
+    {
+      nbDerived += (i / strides_[k]) % (sampleSizes_[k] + 1);
+    }
+    bool masked = nbDerived == 0 || (folded_ ? 2 * nbDerived > nbTotal : nbDerived == nbTotal);
+    out << (i > 0 ? " " : "") << (masked ? 1 : 0);
+  }
+  out << endl;
+}
+
+MafStatisticsEngine::MafStatisticsEngine(const vector<shared_ptr<MafStatisticsInterface>>& statistics) :
+  statistics_(statistics),
+  columnStatistics_(),
+  selections_(),
+  selectionIndices_(),
+  views_()
+{
+  // Identical species selections share the same view:
+  for (const auto& stat : statistics_)
+  {
+    auto columnStat = dynamic_cast<MafColumnStatisticsInterface*>(stat.get());
+    if (!columnStat)
+      continue;
+    columnStatistics_.push_back(columnStat);
+    vector<size_t> indices;
+    for (const auto& selection : columnStat->getSpeciesSelections())
+    {
+      auto it = find(selections_.begin(), selections_.end(), selection);
+      indices.push_back(static_cast<size_t>(it - selections_.begin()));
+      if (it == selections_.end())
+        selections_.push_back(selection);
+    }
+    selectionIndices_.push_back(indices);
+  }
+  views_.resize(selections_.size());
+}
+
+void MafStatisticsEngine::compute(const MafBlock& block, const MafColumnMask* mask)
+{
+  if (mask && mask->getNumberOfColumns() != static_cast<size_t>(block.getNumberOfSites()))
+    throw Exception("MafStatisticsEngine::compute. Column mask does not match the size of block " + block.getDescription() + ".");
+  if (!columnStatistics_.empty())
+  {
+    for (size_t k = 0; k < selections_.size(); ++k)
+    {
+      views_[k].reset(block, selections_[k]);
+    }
+    for (size_t s = 0; s < columnStatistics_.size(); ++s)
+    {
+      vector<const MafColumnView*> views;
+      for (size_t k : selectionIndices_[s])
+      {
+        views.push_back(&views_[k]);
+      }
+      columnStatistics_[s]->beginBlock(block, views);
+    }
+    size_t nc = static_cast<size_t>(block.getNumberOfSites());
+    for (size_t i = 0; i < nc; ++i)
+    {
+      if (mask && mask->isExcluded(i))
+        continue;
+      for (auto columnStat : columnStatistics_)
+      {
+        columnStat->processColumn(i);
+      }
+    }
+    for (auto columnStat : columnStatistics_)
+    {
+      columnStat->endBlock();
+    }
+  }
+  // Other statistics are computed independently, and only see the kept columns:
+  unique_ptr<MafBlock> compacted;
+  for (const auto& stat : statistics_)
+  {
+    if (dynamic_cast<MafColumnStatisticsInterface*>(stat.get()))
+      continue;
+    if (mask && !compacted)
+      compacted = MafColumnMask::compact(block, *mask);
+    stat->compute(compacted ? *compacted : block);
+  }
 }
@@ -6,6 +6,10 @@
 #define _MAFSTATISTICS_H_
 
 #include "MafBlock.h"
+#include "MafColumnView.h"
+#include "MafColumnCounts.h"
+#include "MafBitPlane.h"
+#include "MafColumnMask.h"
 
 // From bpp-core:
 #include <Bpp/Utils/MapTools.h>
@@ -14,53 +18,119 @@
 
 // From the STL:
 #include <map>
+#include <iostream>
 #include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
 
 namespace bpp
 {
 /**
  * @brief General interface for storing statistical results.
  *
+ * Values are stored densely: each tag is resolved once to an index, and values are stored in place in a vector,
+ * so that updating a result does not allocate any memory once all tags have been set.
+ * Values can be accessed by tag name or, more efficiently, by index (see getTagIndex).
+ *
  * @author Julien Dutheil
  * @see MafStatistics
  */
 class MafStatisticsResult
 {
 protected:
-  mutable std::map<std::string, std::unique_ptr<BppNumberI>> values_;
+  /**
+   * @brief Storage for one value, which can be a double, an integer or an unsigned integer.
+   */
+  struct Value_
+  {
+    char type; // 0 if no value is set, 'd', 'i' or 'u' otherwise.
+    BppDouble doubleValue;
+    BppInteger intValue;
+    BppUnsignedInteger unsignedValue;
+
+    Value_() : type(0), doubleValue(0), intValue(0), unsignedValue(0) {}
+  };
+
+  mutable std::map<std::string, size_t> indices_;
+  mutable std::vector<Value_> values_;
 
 public:
-  MafStatisticsResult() : values_() {}
+  MafStatisticsResult() : indices_(), values_() {}
   virtual ~MafStatisticsResult() {}
 
-  MafStatisticsResult(const MafStatisticsResult& msr) : values_()
-  {
-    for (auto& it : values_)
-    {
-      values_[it.first].reset(it.second->clone());
-    }
-  }
+  MafStatisticsResult(const MafStatisticsResult& msr) :
+    indices_(msr.indices_),
+    values_(msr.values_)
+  {}
 
   MafStatisticsResult& operator=(const MafStatisticsResult& msr)
   {
-    values_.clear();
-    for (auto& it : values_)
-    {
-      values_[it.first].reset(it.second->clone());
-    }
+    indices_ = msr.indices_;
+    values_ = msr.values_;
     return *this;
   }
 
 public:
+  /**
+   * @return The index of a tag. The tag is registered if it was not already, without any associated value.
+   * Indices are stable for the lifetime of the result.
+   * @param tag The name of the value.
+   */
+  size_t getTagIndex(const std::string& tag) const
+  {
+    auto it = indices_.find(tag);
+    if (it != indices_.end())
+      return it->second;
+    size_t index = values_.size();
+    indices_[tag] = index;
+    values_.push_back(Value_());
+    return index;
+  }
+
   virtual const BppNumberI& getValue(const std::string& tag) const
   {
-    auto it = values_.find(tag);
-    if (it != values_.end())
-      return *it->second;
+    auto it = indices_.find(tag);
+    if (it != indices_.end() && values_[it->second].type != 0)
+      return getValueAt(it->second);
     else
       throw Exception("MafStatisticsResult::getValue(). No value found for tag: " + tag + ".");
   }
 
+  /**
+   * @return The value with the given index.
+   * @param index The index of the value, as returned by getTagIndex.
+   * @throw Exception If no value is set for this index.
+   */
+  const BppNumberI& getValueAt(size_t index) const
+  {
+    const Value_& value = values_.at(index);
+    switch (value.type)
+    {
+    case 'd': return value.doubleValue;
+    case 'i': return value.intValue;
+    case 'u': return value.unsignedValue;
+    default: throw Exception("MafStatisticsResult::getValueAt(). No value found for index: " + TextTools::toString(index) + ".");
+    }
+  }
+
+  /**
+   * @return The value with the given index, converted to a double.
+   * @param index The index of the value, as returned by getTagIndex.
+   * @throw Exception If no value is set for this index.
+   */
+  double getNumericValueAt(size_t index) const
+  {
+    const Value_& value = values_.at(index);
+    switch (value.type)
+    {
+    case 'd': return value.doubleValue.getValue();
+    case 'i': return static_cast<double>(value.intValue.getValue());
+    case 'u': return static_cast<double>(value.unsignedValue.getValue());
+    default: throw Exception("MafStatisticsResult::getNumericValueAt(). No value found for index: " + TextTools::toString(index) + ".");
+    }
+  }
+
   /**
    * @brief Associate a value to a certain tag. Any existing tag will be overwritten
    *
@@ -69,7 +139,7 @@ public:
    */
   virtual void setValue(const std::string& tag, double value)
   {
-    values_[tag].reset(new BppDouble(value));
+    setValueAt(getTagIndex(tag), value);
   }
 
   /**
@@ -80,7 +150,7 @@ public:
    */
   virtual void setValue(const std::string& tag, int value)
   {
-    values_[tag].reset(new BppInteger(value));
+    setValueAt(getTagIndex(tag), value);
   }
 
   /**
@@ -91,7 +161,28 @@ public:
    */
   virtual void setValue(const std::string& tag, unsigned int value)
   {
-    values_[tag].reset(new BppUnsignedInteger(value));
+    setValueAt(getTagIndex(tag), value);
+  }
+
+  /**
+   * @brief Set the value with the given index, as returned by getTagIndex.
+   */
+  void setValueAt(size_t index, double value)
+  {
+    values_[index].type = 'd';
+    values_[index].doubleValue = BppDouble(value);
+  }
+
+  void setValueAt(size_t index, int value)
+  {
+    values_[index].type = 'i';
+    values_[index].intValue = BppInteger(value);
+  }
+
+  void setValueAt(size_t index, unsigned int value)
+  {
+    values_[index].type = 'u';
+    values_[index].unsignedValue = BppUnsignedInteger(value);
   }
 
   /**
@@ -100,13 +191,31 @@ public:
    */
   virtual bool hasValue(const std::string& tag) const
   {
-    return values_.find(tag) != values_.end();
+    auto it = indices_.find(tag);
+    return it != indices_.end() && values_[it->second].type != 0;
   }
 
   /**
-   * @return A vector with all available tags.
+   * @return A boolean saying whether a value is available for the given index.
    */
-  std::vector<std::string> getAvailableTags() const { return MapTools::getKeys(values_); }
+  bool hasValueAt(size_t index) const
+  {
+    return index < values_.size() && values_[index].type != 0;
+  }
+
+  /**
+   * @return A vector with all available tags, that is, tags with an associated value.
+   */
+  std::vector<std::string> getAvailableTags() const
+  {
+    std::vector<std::string> tags;
+    for (const auto& it : indices_)
+    {
+      if (values_[it.second].type != 0)
+        tags.push_back(it.first);
+    }
+    return tags;
+  }
 };
 
 /**
@@ -121,7 +230,8 @@ private:
 public:
   SimpleMafStatisticsResult(const std::string& name) : MafStatisticsResult(), name_(name)
   {
-    setValue(name, 0);
+    // The unique value has index 0:
+    setValueAt(getTagIndex(name), 0);
   }
   virtual ~SimpleMafStatisticsResult() {}
 
@@ -131,7 +241,7 @@ public:
     return MafStatisticsResult::getValue(tag);
   }
 
-  virtual const BppNumberI& getValue() const { return *values_[name_]; }
+  virtual const BppNumberI& getValue() const { return getValueAt(0); }
 
   virtual void setValue(const std::string& tag, double value)
   {
@@ -157,20 +267,11 @@ public:
       throw Exception("SimpleMafStatisticsResult::setValue(). Invalid tag name: " + tag + ".");
   }
 
-  virtual void setValue(double value)
-  {
-    values_[name_].reset(new BppDouble(value));
-  }
+  virtual void setValue(double value) { setValueAt(0, value); }
 
-  virtual void setValue(int value)
-  {
-    values_[name_].reset(new BppInteger(value));
-  }
+  virtual void setValue(int value) { setValueAt(0, value); }
 
-  virtual void setValue(unsigned int value)
-  {
-    values_[name_].reset(new BppUnsignedInteger(value));
-  }
+  virtual void setValue(unsigned int value) { setValueAt(0, value); }
 };
 
 /**
@@ -188,6 +289,13 @@ public:
 public:
   virtual std::string getShortName() const = 0;
   virtual std::string getFullName() const = 0;
+
+  /**
+   * @return A description of the statistic with all its parameters, including species selections.
+   * Statistics with the same configuration compute the same results on any block.
+   */
+  virtual std::string getConfiguration() const = 0;
+
   virtual const MafStatisticsResult& getResult() const = 0;
   virtual void compute(const MafBlock& block) = 0;
 
@@ -197,6 +305,62 @@ public:
   virtual std::vector<std::string> getSupportedTags() const = 0;
 };
 
+/**
+ * @brief Interface for statistics which can be accumulated over several blocks.
+ *
+ * After a block has been computed, accumulate() adds its contribution to running totals.
+ * Totals of distinct instances of the same statistic, for instance computed by different threads or
+ * on distinct shards (see ShardedMafPipelineRunner), can be combined with merge(), which is associative.
+ * Genome-wide results are computed from the totals by finalize(), typically when iterations stop
+ * (see StatisticsAccumulationIterationListener).
+ */
+class MafStatisticsAccumulatorInterface
+{
+public:
+  MafStatisticsAccumulatorInterface() {}
+  virtual ~MafStatisticsAccumulatorInterface() {}
+
+public:
+  /**
+   * @brief Add the last computed block to the totals.
+   */
+  virtual void accumulate() = 0;
+
+  /**
+   * @brief Add the totals of another instance of the same statistic.
+   *
+   * @param accumulator The instance to merge.
+   * @throw Exception If the two instances are not compatible.
+   */
+  virtual void merge(const MafStatisticsAccumulatorInterface& accumulator) = 0;
+
+  /**
+   * @brief Set all totals to zero.
+   */
+  virtual void resetAccumulator() = 0;
+
+  /**
+   * @brief Save and restore the totals, so that accumulation can be resumed from a checkpoint
+   * (see StatisticsAccumulationIterationListener).
+   *
+   * @throw Exception If the totals to restore do not match this instance.
+   */
+  virtual void saveAccumulator(std::ostream& out) const = 0;
+  virtual void restoreAccumulator(std::istream& in) = 0;
+
+  /**
+   * @brief Compute the genome-wide results from the current totals.
+   *
+   * Totals are left unchanged, so that more blocks or instances can be added afterwards.
+   */
+  virtual void finalize() = 0;
+
+  /**
+   * @return The genome-wide results, as computed by the last call to finalize().
+   */
+  virtual const MafStatisticsResult& getAccumulatedResult() const = 0;
+};
+
 /**
  * @brief Partial implementation of MafStatistics, for convenience.
  */
@@ -232,6 +396,42 @@ public:
   std::vector<std::string> getSupportedTags() const { return result_.getAvailableTags(); }
 };
 
+/**
+ * @brief Partial implementation of MafStatisticsAccumulatorInterface, for statistics made of counts.
+ *
+ * Totals are the sums over blocks of the values of each supported tag, and genome-wide results are these sums.
+ */
+class AbstractAdditiveMafStatistics :
+  public virtual MafStatisticsInterface,
+  public virtual MafStatisticsAccumulatorInterface
+{
+private:
+  std::vector<size_t> tagIndices_;
+  std::vector<double> sums_;
+  MafStatisticsResult accumulatedResult_;
+
+public:
+  AbstractAdditiveMafStatistics() :
+    tagIndices_(),
+    sums_(),
+    accumulatedResult_()
+  {}
+
+  virtual ~AbstractAdditiveMafStatistics() {}
+
+public:
+  void accumulate();
+  void merge(const MafStatisticsAccumulatorInterface& accumulator);
+  void resetAccumulator() { sums_.assign(sums_.size(), 0.); }
+  void finalize();
+  void saveAccumulator(std::ostream& out) const;
+  void restoreAccumulator(std::istream& in);
+  const MafStatisticsResult& getAccumulatedResult() const { return accumulatedResult_; }
+
+private:
+  void initSums_();
+};
+
 /**
  * @brief Computes the pairwise divergence for a pair of sequences in a maf block.
  */
@@ -251,6 +451,7 @@ public:
 public:
   std::string getShortName() const { return "Div." + species1_ + "-" + species2_; }
   std::string getFullName() const { return "Pairwise divergence between " + species1_ + " and " + species2_ + "."; }
+  std::string getConfiguration() const { return getShortName(); }
   void compute(const MafBlock& block);
 };
 
@@ -267,6 +468,7 @@ public:
 public:
   std::string getShortName() const { return "BlockSize"; }
   std::string getFullName() const { return "Number of sequences."; }
+  std::string getConfiguration() const { return getShortName(); }
   void compute(const MafBlock& block)
   {
     result_.setValue(static_cast<double>(block.getNumberOfSequences()));
@@ -277,15 +479,17 @@ public:
  * @brief Computes the number of columns in a maf block.
  */
 class BlockLengthMafStatistics :
-  public AbstractMafStatisticsSimple
+  public AbstractMafStatisticsSimple,
+  public AbstractAdditiveMafStatistics
 {
 public:
-  BlockLengthMafStatistics() : AbstractMafStatisticsSimple("BlockLength") {}
+  BlockLengthMafStatistics() : AbstractMafStatisticsSimple("BlockLength"), AbstractAdditiveMafStatistics() {}
   ~BlockLengthMafStatistics() {}
 
 public:
   std::string getShortName() const { return "BlockLength"; }
   std::string getFullName() const { return "Number of sites."; }
+  std::string getConfiguration() const { return getShortName(); }
   void compute(const MafBlock& block)
   {
     result_.setValue(static_cast<double>(block.getNumberOfSites()));
@@ -299,18 +503,20 @@ public:
  * If several sequences are found for a given species, an exception is thrown.
  */
 class SequenceLengthMafStatistics :
-  public AbstractMafStatisticsSimple
+  public AbstractMafStatisticsSimple,
+  public AbstractAdditiveMafStatistics
 {
 private:
   std::string species_;
 
 public:
-  SequenceLengthMafStatistics(const std::string& species) : AbstractMafStatisticsSimple("BlockSize"), species_(species) {}
+  SequenceLengthMafStatistics(const std::string& species) : AbstractMafStatisticsSimple("BlockSize"), AbstractAdditiveMafStatistics(), species_(species) {}
   ~SequenceLengthMafStatistics() {}
 
 public:
   std::string getShortName() const { return "SequenceLengthFor" + species_; }
   std::string getFullName() const { return "Sequence length for species " + species_; }
+  std::string getConfiguration() const { return getShortName(); }
   void compute(const MafBlock& block)
   {
     std::vector<const MafSequence*> seqs = block.getSequencesForSpecies(species_);
@@ -337,6 +543,7 @@ public:
 public:
   std::string getShortName() const { return "AlnScore"; }
   std::string getFullName() const { return "Alignment score."; }
+  std::string getConfiguration() const { return getShortName(); }
   void compute(const MafBlock& block)
   {
     result_.setValue(block.getScore());
@@ -371,6 +578,13 @@ public:
 
 protected:
   std::unique_ptr<SiteContainerInterface> getSiteContainer_(const MafBlock& block);
+
+  MafSpeciesSelection getSpeciesSelection_() const { return MafSpeciesSelection(species_, noSpeciesMeansAllSpecies_); }
+
+  /**
+   * @return The species selection, formatted for getConfiguration().
+   */
+  std::string getSpeciesConfiguration_() const;
 };
 
 
@@ -390,6 +604,68 @@ public:
 
 protected:
   std::vector<std::unique_ptr<SiteContainerInterface>> getSiteContainers_(const MafBlock& block);
+
+  std::vector<MafSpeciesSelection> getSpeciesSelections_() const;
+
+  /**
+   * @return The species selections, formatted for getConfiguration().
+   */
+  std::string getSpeciesConfiguration_() const;
+};
+
+
+/**
+ * @brief Interface for statistics computed column by column.
+ *
+ * Such statistics rely on one or several species selections, and read the columns of the corresponding views.
+ * When several of them are computed on the same block, views are built once and shared,
+ * and all statistics are updated in a single pass over the columns, see MafStatisticsEngine.
+ */
+class MafColumnStatisticsInterface :
+  public virtual MafStatisticsInterface
+{
+public:
+  MafColumnStatisticsInterface() {}
+  virtual ~MafColumnStatisticsInterface() {}
+
+public:
+  /**
+   * @return The species selections needed, one view being built for each of them.
+   */
+  virtual std::vector<MafSpeciesSelection> getSpeciesSelections() const = 0;
+
+  /**
+   * @brief Start the computation for a new block.
+   *
+   * @param block The block to analyse.
+   * @param views The views corresponding to each species selection, valid until endBlock() is called.
+   */
+  virtual void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views) = 0;
+
+  /**
+   * @brief Update the statistic with column i of the views.
+   */
+  virtual void processColumn(size_t i) = 0;
+
+  /**
+   * @brief Finish the computation for the current block, and set the result.
+   */
+  virtual void endBlock() = 0;
+};
+
+
+/**
+ * @brief Partial implementation of MafColumnStatisticsInterface, computing the statistic alone on a block.
+ */
+class AbstractMafColumnStatistics :
+  public virtual MafColumnStatisticsInterface
+{
+public:
+  AbstractMafColumnStatistics() {}
+  virtual ~AbstractMafColumnStatistics() {}
+
+public:
+  void compute(const MafBlock& block);
 };
 
 
@@ -407,10 +683,17 @@ protected:
  */
 class CharacterCountsMafStatistics :
   public AbstractMafStatistics,
-  public AbstractSpeciesSelectionMafStatistics
+  public AbstractSpeciesSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public AbstractAdditiveMafStatistics
 {
 private:
   std::shared_ptr<const Alphabet> alphabet_;
+  bool isNucleic_;
+  const MafColumnView* view_;
+  MafNucleotideCounts nucleotideCounts_; // Used for nucleic alphabets.
+  std::map<int, unsigned int> counts_;   // Used for other alphabets.
+  std::vector<size_t> tagIndices_;       // Indices of the supported tags in the result.
 
 public:
   CharacterCountsMafStatistics(
@@ -419,18 +702,42 @@ public:
       const std::string suffix) :
     AbstractMafStatistics(),
     AbstractSpeciesSelectionMafStatistics(species, true, suffix),
-    alphabet_(alphabet) {}
+    AbstractMafColumnStatistics(),
+    AbstractAdditiveMafStatistics(),
+    alphabet_(alphabet),
+    isNucleic_(AlphabetTools::isNucleicAlphabet(*alphabet)),
+    view_(nullptr),
+    nucleotideCounts_(),
+    counts_(),
+    tagIndices_()
+  {
+    initTagIndices_();
+  }
 
   CharacterCountsMafStatistics(const CharacterCountsMafStatistics& stats) :
     AbstractMafStatistics(stats),
     AbstractSpeciesSelectionMafStatistics(stats),
-    alphabet_(stats.alphabet_) {}
+    AbstractMafColumnStatistics(stats),
+    AbstractAdditiveMafStatistics(stats),
+    alphabet_(stats.alphabet_),
+    isNucleic_(stats.isNucleic_),
+    view_(nullptr),
+    nucleotideCounts_(),
+    counts_(),
+    tagIndices_(stats.tagIndices_)
+  {}
 
   CharacterCountsMafStatistics& operator=(const CharacterCountsMafStatistics& stats)
   {
     AbstractMafStatistics::operator=(stats);
     AbstractSpeciesSelectionMafStatistics::operator=(stats);
+    AbstractAdditiveMafStatistics::operator=(stats);
     alphabet_ = stats.alphabet_;
+    isNucleic_ = stats.isNucleic_;
+    view_ = nullptr;
+    nucleotideCounts_.clear();
+    counts_.clear();
+    tagIndices_ = stats.tagIndices_;
     return *this;
   }
 
@@ -439,8 +746,15 @@ public:
 public:
   std::string getShortName() const { return "Counts" + suffix_; }
   std::string getFullName() const { return "Character counts (" + suffix_ + ")."; }
-  void compute(const MafBlock& block);
+  std::string getConfiguration() const { return "Counts(" + alphabet_->getAlphabetType() + "," + getSpeciesConfiguration_() + ")"; }
   std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return std::vector<MafSpeciesSelection>(1, getSpeciesSelection_()); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
+
+private:
+  void initTagIndices_();
 };
 
 
@@ -452,7 +766,9 @@ public:
  */
 class SiteFrequencySpectrumMafStatistics :
   public AbstractMafStatistics,
-  public AbstractSpeciesSelectionMafStatistics
+  public AbstractSpeciesSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public AbstractAdditiveMafStatistics
 {
 private:
   class Categorizer
@@ -470,17 +786,31 @@ public:
 public:
     size_t getNumberOfCategories() const { return bounds_.size() - 1; }
 
+    const std::vector<double>& getBounds() const { return bounds_; }
+
     // Category numbers start at 1!
     size_t getCategory(double value) const
     {
-      if (value < bounds_[0])
+      // Bounds are sorted, the category is given by the first bound greater than the value:
+      size_t i = static_cast<size_t>(std::upper_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+      if (i == 0 || i == bounds_.size())
         throw OutOfRangeException("SiteFrequencySpectrumMafStatistics::Categorizer::getCategory.", value, *bounds_.begin(), *bounds_.rbegin());
-      for (size_t i = 1; i < bounds_.size(); ++i)
+      return i;
+    }
+
+    /**
+     * @return The category of each integer value from 0 to maxValue, 0 meaning that the value is out of range.
+     */
+    std::vector<size_t> getCategories(size_t maxValue) const
+    {
+      std::vector<size_t> categories(maxValue + 1, 0);
+      for (size_t k = 0; k <= maxValue; ++k)
       {
-        if (value < bounds_[i])
-          return i;
+        double value = static_cast<double>(k);
+        if (value >= bounds_.front() && value < bounds_.back())
+          categories[k] = getCategory(value);
       }
-      throw OutOfRangeException("SiteFrequencySpectrumMafStatistics::Categorizer::getCategory.", value, *bounds_.begin(), *bounds_.rbegin());
+      return categories;
     }
   };
 
@@ -489,6 +819,15 @@ private:
   Categorizer categorizer_;
   std::vector<unsigned int> counts_;
   std::string outgroup_;
+  const MafColumnView* view_;
+  const std::vector<int>* outgroupSeq_;
+  bool isAnalyzable_;
+  MafNucleotideCounts columnCounts_;
+  std::vector<size_t> categories_; // Category of each derived allele count, for the current number of sequences.
+  unsigned int nbUnresolved_;
+  unsigned int nbSaturated_;
+  unsigned int nbIgnored_;
+  std::vector<size_t> tagIndices_; // Indices of the supported tags in the result.
 
 public:
   SiteFrequencySpectrumMafStatistics(
@@ -498,29 +837,60 @@ public:
       const std::string outgroup = "") :
     AbstractMafStatistics(),
     AbstractSpeciesSelectionMafStatistics(ingroup),
+    AbstractMafColumnStatistics(),
+    AbstractAdditiveMafStatistics(),
     alphabet_(alphabet),
     categorizer_(bounds),
     counts_(bounds.size() - 1),
-    outgroup_(outgroup)
-  {}
+    outgroup_(outgroup),
+    view_(nullptr),
+    outgroupSeq_(nullptr),
+    isAnalyzable_(false),
+    columnCounts_(),
+    categories_(),
+    nbUnresolved_(0),
+    nbSaturated_(0),
+    nbIgnored_(0),
+    tagIndices_()
+  {
+    initTagIndices_();
+  }
 
   SiteFrequencySpectrumMafStatistics(const SiteFrequencySpectrumMafStatistics& stats) :
     AbstractMafStatistics(),
     AbstractSpeciesSelectionMafStatistics(stats),
+    AbstractMafColumnStatistics(stats),
+    AbstractAdditiveMafStatistics(stats),
     alphabet_(stats.alphabet_),
     categorizer_(stats.categorizer_),
     counts_(stats.counts_),
-    outgroup_(stats.outgroup_)
-  {}
+    outgroup_(stats.outgroup_),
+    view_(nullptr),
+    outgroupSeq_(nullptr),
+    isAnalyzable_(false),
+    columnCounts_(),
+    categories_(),
+    nbUnresolved_(0),
+    nbSaturated_(0),
+    nbIgnored_(0),
+    tagIndices_()
+  {
+    initTagIndices_();
+  }
 
   SiteFrequencySpectrumMafStatistics& operator=(const SiteFrequencySpectrumMafStatistics& stats)
   {
     AbstractMafStatistics::operator=(stats);
     AbstractSpeciesSelectionMafStatistics::operator=(stats);
+    AbstractAdditiveMafStatistics::operator=(stats);
     alphabet_    = stats.alphabet_;
     categorizer_ = stats.categorizer_;
     counts_      = stats.counts_;
     outgroup_    = stats.outgroup_;
+    view_        = nullptr;
+    outgroupSeq_ = nullptr;
+    categories_.clear();
+    tagIndices_  = stats.tagIndices_;
     return *this;
   }
 
@@ -529,8 +899,14 @@ public:
 public:
   std::string getShortName() const { return "SiteFrequencySpectrum"; }
   std::string getFullName() const { return "Site frequency spectrum."; }
-  void compute(const MafBlock& block);
+  std::string getConfiguration() const;
   std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return std::vector<MafSpeciesSelection>(1, getSpeciesSelection_()); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
+private:
+  void initTagIndices_();
 };
 
 
@@ -546,11 +922,15 @@ public:
  */
 class FourSpeciesPatternCountsMafStatistics :
   public AbstractMafStatistics,
-  public AbstractSpeciesSelectionMafStatistics
+  public AbstractSpeciesSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public AbstractAdditiveMafStatistics
 {
 private:
   std::shared_ptr<const DNA> alphabet_;
   std::vector<unsigned int> counts_;
+  const MafColumnView* view_;
+  unsigned int nbIgnored_;
 
 public:
   FourSpeciesPatternCountsMafStatistics(
@@ -558,8 +938,12 @@ public:
       const std::vector<std::string>& species) :
     AbstractMafStatistics(),
     AbstractSpeciesSelectionMafStatistics(species),
+    AbstractMafColumnStatistics(),
+    AbstractAdditiveMafStatistics(),
     alphabet_(alphabet),
-    counts_(6)
+    counts_(6),
+    view_(nullptr),
+    nbIgnored_(0)
   {
     if (species.size() != 4)
       throw Exception("FourSpeciesPatternCountsMafStatistics, constructor: 4 species should be provided.");
@@ -570,16 +954,22 @@ public:
   FourSpeciesPatternCountsMafStatistics(const FourSpeciesPatternCountsMafStatistics& stats) :
     AbstractMafStatistics(),
     AbstractSpeciesSelectionMafStatistics(stats),
+    AbstractMafColumnStatistics(stats),
+    AbstractAdditiveMafStatistics(stats),
     alphabet_(stats.alphabet_),
-    counts_(stats.counts_)
+    counts_(stats.counts_),
+    view_(nullptr),
+    nbIgnored_(0)
   {}
 
   FourSpeciesPatternCountsMafStatistics& operator=(const FourSpeciesPatternCountsMafStatistics& stats)
   {
     AbstractMafStatistics::operator=(stats);
     AbstractSpeciesSelectionMafStatistics::operator=(stats);
+    AbstractAdditiveMafStatistics::operator=(stats);
     alphabet_    = stats.alphabet_;
     counts_      = stats.counts_;
+    view_        = nullptr;
     return *this;
   }
 
@@ -588,8 +978,12 @@ public:
 public:
   std::string getShortName() const { return "FourSpeciesPatternCounts"; }
   std::string getFullName() const { return "FourSpecies pattern counts."; }
-  void compute(const MafBlock& block);
+  std::string getConfiguration() const { return getShortName() + "(" + getSpeciesConfiguration_() + ")"; }
   std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return std::vector<MafSpeciesSelection>(1, getSpeciesSelection_()); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
 };
 
 
@@ -607,12 +1001,28 @@ public:
  */
 class SiteMafStatistics :
   public AbstractMafStatistics,
-  public AbstractSpeciesSelectionMafStatistics
+  public AbstractSpeciesSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public AbstractAdditiveMafStatistics
 {
+private:
+  std::shared_ptr<const Alphabet> alphabet_;
+  bool isNucleic_;
+  const MafColumnView* view_;
+  MafNucleotideCounts columnCounts_;
+  std::vector<unsigned int> counts_;
+
 public:
   SiteMafStatistics(const std::vector<std::string>& species) :
     AbstractMafStatistics(),
-    AbstractSpeciesSelectionMafStatistics(species)
+    AbstractSpeciesSelectionMafStatistics(species),
+    AbstractMafColumnStatistics(),
+    AbstractAdditiveMafStatistics(),
+    alphabet_(),
+    isNucleic_(false),
+    view_(nullptr),
+    columnCounts_(),
+    counts_(7)
   {}
 
   virtual ~SiteMafStatistics() {}
@@ -620,8 +1030,12 @@ public:
 public:
   std::string getShortName() const { return "SiteStatistics"; }
   std::string getFullName() const { return "Site statistics."; }
-  void compute(const MafBlock& block);
+  std::string getConfiguration() const { return getShortName() + "(" + getSpeciesConfiguration_() + ")"; }
   std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return std::vector<MafSpeciesSelection>(1, getSpeciesSelection_()); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
 };
 
 
@@ -639,12 +1053,26 @@ public:
  */
 class PolymorphismMafStatistics :
   public AbstractMafStatistics,
-  public AbstractSpeciesMultipleSelectionMafStatistics
+  public AbstractSpeciesMultipleSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public AbstractAdditiveMafStatistics
 {
+private:
+  std::shared_ptr<const Alphabet> alphabet_;
+  const MafColumnView* view1_;
+  const MafColumnView* view2_;
+  std::vector<unsigned int> counts_;
+
 public:
   PolymorphismMafStatistics(const std::vector< std::vector<std::string>>& species) :
     AbstractMafStatistics(),
-    AbstractSpeciesMultipleSelectionMafStatistics(species)
+    AbstractSpeciesMultipleSelectionMafStatistics(species),
+    AbstractMafColumnStatistics(),
+    AbstractAdditiveMafStatistics(),
+    alphabet_(),
+    view1_(nullptr),
+    view2_(nullptr),
+    counts_(10)
   {
     if (species.size() != 2)
       throw Exception("PolymorphismStatistics: exactly two species selection should be provided.");
@@ -655,11 +1083,18 @@ public:
 public:
   std::string getShortName() const { return "PolymorphismStatistics"; }
   std::string getFullName() const { return "Polymorphism statistics."; }
-  void compute(const MafBlock& block);
+  std::string getConfiguration() const { return getShortName() + "(" + getSpeciesConfiguration_() + ")"; }
   std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return getSpeciesSelections_(); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
 
 private:
-  static std::vector<int> getPatterns_(const SiteContainerInterface& sites);
+  /**
+   * @return The state of a fixed column, -10 for a polymorphic column, and -1 for an unresolved one.
+   */
+  int getPattern_(const MafColumnView& view, size_t i) const;
 };
 
 
@@ -672,15 +1107,58 @@ private:
  * - Tajima's D
  *
  * Only fully resolved sites are analyzed (no gap, no generic character).
+ *
+ * Each sequence is encoded as one bit plane per nucleotide, and allele counts are obtained for all sites at once
+ * with bit-sliced counters (see MafBitPlane::countColumns). The number of pairwise differences at a site is then
+ * computed from allele counts, without comparing sequences. Constants depending on the number of sequences are cached.
  */
 class SequenceDiversityMafStatistics :
   public AbstractMafStatistics,
-  public AbstractSpeciesSelectionMafStatistics
+  public AbstractSpeciesSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public virtual MafStatisticsAccumulatorInterface
 {
+private:
+  /**
+   * @brief Totals for a given number of sequences: number of analyzed sites, of segregating sites, and of pairwise differences.
+   */
+  typedef std::map<size_t, std::array<double, 3>> Totals_;
+
+  /**
+   * @brief Constants used by Watterson's theta and Tajima's D, for a given number of sequences.
+   */
+  struct Constants_
+  {
+    double a1;
+    double a2;
+    double e1;
+    double e2;
+  };
+
+  std::vector<MafBitPlane> planes_;
+  std::array<std::vector<unsigned int>, 4> alleleCounts_;
+  std::map<size_t, Constants_> constants_;
+  size_t nbSequences_;
+  size_t nbTot_;
+  double nbSegregating_;
+  double nbDifferences_;
+  Totals_ totals_;
+  MafStatisticsResult accumulatedResult_;
+
 public:
   SequenceDiversityMafStatistics(const std::vector<std::string>& ingroup) :
     AbstractMafStatistics(),
-    AbstractSpeciesSelectionMafStatistics(ingroup)
+    AbstractSpeciesSelectionMafStatistics(ingroup),
+    AbstractMafColumnStatistics(),
+    planes_(),
+    alleleCounts_(),
+    constants_(),
+    nbSequences_(0),
+    nbTot_(0),
+    nbSegregating_(0),
+    nbDifferences_(0),
+    totals_(),
+    accumulatedResult_()
   {}
 
   virtual ~SequenceDiversityMafStatistics() {}
@@ -688,11 +1166,367 @@ public:
 public:
   std::string getShortName() const { return "SequenceDiversityStatistics"; }
   std::string getFullName() const { return "Sequence diversity statistics."; }
+  std::string getConfiguration() const { return getShortName() + "(" + getSpeciesConfiguration_() + ")"; }
+  std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return std::vector<MafSpeciesSelection>(1, getSpeciesSelection_()); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
+
+  /**
+   * @name The MafStatisticsAccumulatorInterface.
+   *
+   * Totals are kept separately for each number of sequences.
+   * If all blocks have the same number of sequences, genome-wide estimates are computed as for a single block.
+   * Otherwise, Watterson's theta and Tajima's pi are the sums of the per-site estimates for each number of sequences,
+   * averaged over all analyzed sites, and Tajima's D is not computed (NaN).
+   * @{
+   */
+  void accumulate();
+  void merge(const MafStatisticsAccumulatorInterface& accumulator);
+  void resetAccumulator() { totals_.clear(); }
+  void finalize();
+  void saveAccumulator(std::ostream& out) const;
+  void restoreAccumulator(std::istream& in);
+  const MafStatisticsResult& getAccumulatedResult() const { return accumulatedResult_; }
+  /** @} */
+
+private:
+  const Constants_& getConstants_(size_t n);
+
+  /**
+   * @brief Compute all estimates for a given number of sequences.
+   */
+  void computeDiversity_(size_t n, double nbTot, double nbSegregating, double nbDifferences, MafStatisticsResult& result);
+};
+
+
+/**
+ * @brief Computes the pairwise divergence between all pairs of species in a maf block.
+ *
+ * For each pair of species, the divergence is the percentage of mismatches among comparable sites,
+ * that is, sites where both species have a resolved nucleotide. Gaps and unresolved characters are ignored.
+ * One tag is provided per pair of species, named "species1-species2", in the order of the upper triangle
+ * of the matrix. The value is NaN if one of the species is missing in the block or if no site is comparable.
+ * Raw counts for the current block are also available as compact vectors, see getMismatches() and getComparableSites().
+ *
+ * Each sequence is encoded as one bit plane per nucleotide plus one plane of resolved sites. Mismatches and comparable
+ * sites for a pair are then obtained with bitwise operations and population counts, 64 sites at a time.
+ * Sites are processed by tiles, so that the planes of all species for a tile remain in cache while all pairs are compared.
+ *
+ * As an accumulator, the statistic sums mismatches and comparable sites over blocks, so that genome-wide divergences
+ * are ratios of totals rather than averages of per-block ratios.
+ */
+class DivergenceMatrixMafStatistics :
+  public AbstractMafStatistics,
+  public virtual MafStatisticsAccumulatorInterface
+{
+private:
+  std::vector<std::string> species_;
+  std::vector<uint64_t> planes_;
+  std::vector<bool> present_;
+  std::vector<unsigned int> mismatches_;
+  std::vector<unsigned int> comparable_;
+  std::vector<size_t> tagIndices_;
+  std::vector<double> totalMismatches_;
+  std::vector<double> totalComparable_;
+  MafStatisticsResult accumulatedResult_;
+
+public:
+  /**
+   * @brief Number of 64-site words processed together for all pairs.
+   */
+  static const size_t TILE_SIZE;
+
+public:
+  /**
+   * @param species The list of species to compare (at least two).
+   */
+  DivergenceMatrixMafStatistics(const std::vector<std::string>& species);
+
+  virtual ~DivergenceMatrixMafStatistics() {}
+
+public:
+  std::string getShortName() const { return "DivMatrix"; }
+  std::string getFullName() const { return "Pairwise divergence between all species."; }
+  std::string getConfiguration() const { return getShortName() + "(species=" + VectorTools::paste(species_, ",") + ")"; }
+  std::vector<std::string> getSupportedTags() const;
   void compute(const MafBlock& block);
+
+  const std::vector<std::string>& getSpecies() const { return species_; }
+
+  /**
+   * @return The index of pair (i, j) in the compact vectors, with i < j.
+   */
+  size_t getPairIndex(size_t i, size_t j) const
+  {
+    size_t n = species_.size();
+    return i * (2 * n - i - 1) / 2 + (j - i - 1);
+  }
+
+  /**
+   * @return The number of mismatches for each pair of species in the last block, see getPairIndex().
+   */
+  const std::vector<unsigned int>& getMismatches() const { return mismatches_; }
+
+  /**
+   * @return The number of comparable sites for each pair of species in the last block, see getPairIndex().
+   */
+  const std::vector<unsigned int>& getComparableSites() const { return comparable_; }
+
+  void accumulate();
+  void merge(const MafStatisticsAccumulatorInterface& accumulator);
+  void resetAccumulator();
+  void finalize();
+  void saveAccumulator(std::ostream& out) const;
+  void restoreAccumulator(std::istream& in);
+  const MafStatisticsResult& getAccumulatedResult() const { return accumulatedResult_; }
+};
+
+
+/**
+ * @brief Compute ABBA-BABA counts and Patterson's D statistic for all quartets of populations.
+ *
+ * Populations are sets of species, and an outgroup population is used to polarize sites.
+ * For each ordered triplet of ingroup populations (P1, P2, P3), with P1 before P2 in the list of populations,
+ * the statistic D(P1, P2, P3, O) = (ABBA - BABA) / (ABBA + BABA) is computed, all triplets being updated in a single
+ * pass over the columns. Allele frequencies are used instead of single sequences: at each biallelic site, with p_k the
+ * frequency of one of the two alleles in population k (computed from resolved characters only),
+ * - ABBA = (1 - p1) p2 p3 (1 - pO) + p1 (1 - p2) (1 - p3) pO,
+ * - BABA = p1 (1 - p2) p3 (1 - pO) + (1 - p1) p2 (1 - p3) pO,
+ * which does not depend on the allele chosen and reduces to the usual site pattern counts with one sequence per population.
+ * Sites with more than two states in total, or where a population has no resolved character, are ignored.
+ *
+ * For each triplet, tagged "P1-P2-P3", the following values are provided: "P1-P2-P3.ABBA", "P1-P2-P3.BABA",
+ * "P1-P2-P3.D", "P1-P2-P3.SE" and "P1-P2-P3.Z".
+ *
+ * As an accumulator, ABBA and BABA sums are collected in consecutive jackknife blocks of at least a given number
+ * of alignment columns. Genome-wide D values are ratios of totals, and their standard error is estimated by a delete-one
+ * block jackknife, from which Z-scores are computed. Standard errors and Z-scores are NaN for single blocks.
+ *
+ * Jackknife blocks are only an approximation of fixed-size genomic windows:
+ * - their size is the number of analysed alignment columns (columns excluded by a column mask are not counted),
+ *   including columns with a gap in the reference genome, so that it may differ from the number of reference positions
+ *   covered, and regions without alignment are not counted at all;
+ * - maf blocks are not split, so that a jackknife block is closed at the end of the first maf block reaching the size,
+ *   and may be much larger if maf blocks are long compared to the jackknife block size.
+ * For jackknife blocks closer to genomic windows, input blocks can be split beforehand to the desired size
+ * (see WindowSplitMafIterator).
+ */
+class AbbaBabaMafStatistics :
+  public AbstractMafStatistics,
+  public AbstractSpeciesMultipleSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public virtual MafStatisticsAccumulatorInterface
+{
+private:
+  struct Triplet_
+  {
+    size_t p1;
+    size_t p2;
+    size_t p3;
+  };
+
+  std::vector<std::string> names_;
+  size_t jackknifeBlockSize_;
+  std::vector<Triplet_> triplets_;
+  std::vector<const MafColumnView*> views_;
+  std::vector<MafNucleotideCounts> counts_;
+  std::vector<double> frequencies_;
+  std::vector<double> sums_;
+  size_t nbColumns_;
+  std::vector<size_t> tagIndices_;
+  std::vector<std::vector<double>> jackknifeSums_;
+  std::vector<double> currentJackknifeSums_;
+  size_t currentJackknifeSize_;
+  MafStatisticsResult accumulatedResult_;
+
+public:
+  /**
+   * @param names The names of the ingroup populations, used in tags.
+   * @param populations The species in each ingroup population (at least three populations).
+   * @param outgroup The species in the outgroup population.
+   * @param jackknifeBlockSize The minimum number of analysed alignment columns in each jackknife block (see class description).
+   */
+  AbbaBabaMafStatistics(
+      const std::vector<std::string>& names,
+      const std::vector<std::vector<std::string>>& populations,
+      const std::vector<std::string>& outgroup,
+      size_t jackknifeBlockSize);
+
+  virtual ~AbbaBabaMafStatistics() {}
+
+public:
+  std::string getShortName() const { return "AbbaBaba"; }
+  std::string getFullName() const { return "ABBA-BABA statistics."; }
+  std::string getConfiguration() const;
   std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return getSpeciesSelections_(); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
+
+  void accumulate();
+  void merge(const MafStatisticsAccumulatorInterface& accumulator);
+  void resetAccumulator();
+  void finalize();
+  void saveAccumulator(std::ostream& out) const;
+  void restoreAccumulator(std::istream& in);
+  const MafStatisticsResult& getAccumulatedResult() const { return accumulatedResult_; }
+
+  /**
+   * @return The number of completed jackknife blocks.
+   */
+  size_t getNumberOfJackknifeBlocks() const { return jackknifeSums_.size(); }
+
+private:
+  std::string getTripletName_(const Triplet_& triplet) const
+  {
+    return names_[triplet.p1] + "-" + names_[triplet.p2] + "-" + names_[triplet.p3];
+  }
+
+  static std::vector<std::vector<std::string>> getSelections_(
+      const std::vector<std::vector<std::string>>& populations,
+      const std::vector<std::string>& outgroup);
+};
 
+
+/**
+ * @brief Compute the joint site frequency spectrum of several populations.
+ *
+ * Populations are sets of species, each species providing one sequence. Entry (d1, d2, ...) of the spectrum is the
+ * number of sites where the derived allele is found in d1 sequences of the first population, d2 sequences of the
+ * second one, etc. Only sites with at most two states over all populations are used, and sites with gaps or unresolved
+ * characters are ignored, so that the sample size of each population is constant. Blocks where a population does not
+ * have exactly one sequence per species are ignored.
+ *
+ * If an outgroup is given, the ancestral state is the state of the outgroup, which must be resolved and identical for
+ * all outgroup sequences, and the spectrum is unfolded. Otherwise, the spectrum is folded: entries with more than half
+ * of all sequences carrying the minor allele are added to their symmetric entry, and ambiguous entries, with exactly half
+ * of the sequences, are split equally between the two.
+ *
+ * The spectrum of each block is stored sparsely, and added to a dense genome-wide spectrum by accumulate().
+ * The following values are provided: "NbSites" (number of sites in the spectrum) and "NbIgnored" (number of ignored sites).
+ * The genome-wide spectrum can be written in the dadi / moments format, see writeDadiSpectrum().
+ */
+class JointSiteFrequencySpectrumMafStatistics :
+  public AbstractMafStatistics,
+  public AbstractSpeciesMultipleSelectionMafStatistics,
+  public AbstractMafColumnStatistics,
+  public virtual MafStatisticsAccumulatorInterface
+{
 private:
-  static std::vector<int> getPatterns_(const SiteContainerInterface& sites);
+  std::vector<std::string> names_;
+  std::vector<size_t> sampleSizes_;
+  std::vector<size_t> strides_;
+  bool folded_;
+  std::vector<const MafColumnView*> views_;
+  std::vector<MafNucleotideCounts> counts_;
+  bool usableBlock_;
+  std::map<size_t, double> blockSpectrum_;
+  unsigned int nbSites_;
+  unsigned int nbIgnored_;
+  std::vector<double> spectrum_;
+  double totalSites_;
+  double totalIgnored_;
+  MafStatisticsResult accumulatedResult_;
+
+public:
+  /**
+   * @param names The names of the populations, used in the output file.
+   * @param populations The species in each population (at least two populations).
+   * @param outgroup The species used to infer ancestral states. If empty, the spectrum is folded.
+   */
+  JointSiteFrequencySpectrumMafStatistics(
+      const std::vector<std::string>& names,
+      const std::vector<std::vector<std::string>>& populations,
+      const std::vector<std::string>& outgroup = std::vector<std::string>());
+
+  virtual ~JointSiteFrequencySpectrumMafStatistics() {}
+
+public:
+  std::string getShortName() const { return "JointSFS"; }
+  std::string getFullName() const { return "Joint site frequency spectrum."; }
+  std::string getConfiguration() const;
+  std::vector<std::string> getSupportedTags() const;
+  std::vector<MafSpeciesSelection> getSpeciesSelections() const { return getSpeciesSelections_(); }
+  void beginBlock(const MafBlock& block, const std::vector<const MafColumnView*>& views);
+  void processColumn(size_t i);
+  void endBlock();
+
+  void accumulate();
+  void merge(const MafStatisticsAccumulatorInterface& accumulator);
+  void resetAccumulator();
+  void finalize();
+  void saveAccumulator(std::ostream& out) const;
+  void restoreAccumulator(std::istream& in);
+  const MafStatisticsResult& getAccumulatedResult() const { return accumulatedResult_; }
+
+  bool isFolded() const { return folded_; }
+
+  const std::vector<size_t>& getSampleSizes() const { return sampleSizes_; }
+
+  /**
+   * @return The index of an entry in the spectrum, given the number of derived alleles in each population.
+   */
+  size_t getIndex(const std::vector<size_t>& derived) const;
+
+  /**
+   * @return The spectrum of the last block, as a sparse vector, see getIndex().
+   */
+  const std::map<size_t, double>& getBlockSpectrum() const { return blockSpectrum_; }
+
+  /**
+   * @return The genome-wide spectrum, as a dense vector in row-major order, see getIndex().
+   */
+  const std::vector<double>& getSpectrum() const { return spectrum_; }
+
+  /**
+   * @brief Write the genome-wide spectrum in the dadi / moments format.
+   *
+   * The first line contains the dimensions, the folding state and the population names,
+   * the second line the entries in row-major order, and the third line the mask.
+   * Entries for monomorphic sites are masked, as well as entries set to zero by folding.
+   */
+  void writeDadiSpectrum(std::ostream& out) const;
+
+private:
+  static std::vector<std::vector<std::string>> getSelections_(
+      const std::vector<std::vector<std::string>>& populations,
+      const std::vector<std::string>& outgroup);
+};
+
+
+/**
+ * @brief Compute a series of statistics on each block.
+ *
+ * Statistics implementing MafColumnStatisticsInterface are computed together: one view is built for each distinct
+ * species selection, and all these statistics are updated in a single pass over the columns of the block.
+ * Other statistics are computed independently.
+ *
+ * Columns excluded by a column mask are skipped in place by column statistics. Other statistics, which analyse
+ * the block as a whole, are computed on a copy of the block restricted to the kept columns (see MafColumnMask::compact()).
+ */
+class MafStatisticsEngine
+{
+private:
+  std::vector<std::shared_ptr<MafStatisticsInterface>> statistics_;
+  std::vector<MafColumnStatisticsInterface*> columnStatistics_;
+  std::vector<MafSpeciesSelection> selections_;
+  std::vector<std::vector<size_t>> selectionIndices_;
+  std::vector<MafColumnView> views_;
+
+public:
+  MafStatisticsEngine(const std::vector<std::shared_ptr<MafStatisticsInterface>>& statistics);
+
+public:
+  /**
+   * @brief Compute all statistics on a block. Results are then available from each statistic.
+   *
+   * @param block The block to analyse.
+   * @param mask The columns to ignore, if any. It should have the same number of columns as the block.
+   */
+  void compute(const MafBlock& block, const MafColumnMask* mask = nullptr);
 };
 } // end of namespace bpp
 
@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "MafStatisticsResultCache.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+
+using namespace bpp;
+
+// From the STL:
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+using namespace std;
+
+const uint64_t MafStatisticsResultCache::HASH_OFFSET_ = 0xcbf29ce484222325ULL;
+
+MafStatisticsResultCache::MafStatisticsResultCache(const string& directory, const string& configuration) :
+  configuration_(configuration),
+  path_(),
+  entries_(),
+  output_(),
+  nbHits_(0),
+  nbMisses_(0)
+{
+  ostringstream name;
+  name << "bppmaf_statistics_" << hex << setw(16) << setfill('0') << hashBytes_(configuration.data(), configuration.size(), HASH_OFFSET_) << ".cache";
+  path_ = (filesystem::path(directory) / name.str()).string();
+
+  bool exists = filesystem::exists(path_);
+  if (exists && load_())
+  {
+    output_.open(path_.c_str(), ios::out | ios::binary | ios::app);
+  }
+  else
+  {
+    // New file, or file with an incomplete last entry (for instance if a previous run was interrupted), which is rewritten:
+    output_.open(path_.c_str(), ios::out | ios::binary | ios::trunc);
+    MafBlockSerializer::writeString(output_, configuration_);
+    for (const auto& entry : entries_)
+    {
+      writeEntry_(entry.first, entry.second);
+    }
+  }
+  if (!output_)
+    throw IOException("MafStatisticsResultCache (constructor). Cache file " + path_ + " cannot be written.");
+}
+
+bool MafStatisticsResultCache::load_()
+{
+  ifstream input(path_.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("MafStatisticsResultCache::load_. Cache file " + path_ + " cannot be read.");
+  string configuration;
+  try
+  {
+    configuration = MafBlockSerializer::readString(input);
+  }
+  catch (IOException&)
+  {
+    return false;
+  }
+  if (configuration != configuration_)
+    throw Exception("MafStatisticsResultCache::load_. Cache file " + path_ + " was created for another configuration.");
+  while (input.peek() != EOF)
+  {
+    try
+    {
+      uint64_t key = static_cast<uint64_t>(MafBlockSerializer::readSize(input));
+      vector<Value> values(MafBlockSerializer::readSize(input));
+      for (auto& value : values)
+      {
+        value.type = static_cast<char>(input.get());
+        value.value = MafBlockSerializer::readDouble(input);
+      }
+      entries_[key] = values;
+    }
+    catch (IOException&)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+const vector<MafStatisticsResultCache::Value>* MafStatisticsResultCache::find(uint64_t key)
+{
+  auto it = entries_.find(key);
+  if (it == entries_.end())
+  {
+    nbMisses_++;
+    return nullptr;
+  }
+  nbHits_++;
+  return &it->second;
+}
+
+void MafStatisticsResultCache::insert(uint64_t key, const vector<Value>& values)
+{
+  entries_[key] = values;
+  writeEntry_(key, values);
+  if (!output_)
+    throw IOException("MafStatisticsResultCache::insert. Error while writing to cache file " + path_ + ".");
+}
+
+void MafStatisticsResultCache::writeEntry_(uint64_t key, const vector<Value>& values)
+{
+  MafBlockSerializer::writeSize(output_, static_cast<size_t>(key));
+  MafBlockSerializer::writeSize(output_, values.size());
+  for (const auto& value : values)
+  {
+    output_.put(value.type);
+    MafBlockSerializer::writeDouble(output_, value.value);
+  }
+}
+
+uint64_t MafStatisticsResultCache::hashBytes_(const char* data, size_t size, uint64_t hash)
+{
+  // FNV-1a, applied to 64 bits words, then to the remaining bytes:
+  const uint64_t prime = 0x100000001b3ULL;
+  size_t i = 0;
+  for ( ; i + 8 <= size; i += 8)
+  {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * prime;
+  }
+  for ( ; i < size; ++i)
+  {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+  }
+  return hash;
+}
+
+uint64_t MafStatisticsResultCache::hashBlock(const MafBlock& block)
+{
+  uint64_t hash = HASH_OFFSET_;
+  auto hashNumber = [&](uint64_t x)
+  {
+    hash = hashBytes_(reinterpret_cast<const char*>(&x), sizeof(x), hash);
+  };
+  double score = block.getScore();
+  hash = hashBytes_(reinterpret_cast<const char*>(&score), sizeof(score), hash);
+  hashNumber(block.getPass());
+  hashNumber(block.getNumberOfSequences());
+  for (size_t j = 0; j < block.getNumberOfSequences(); ++j)
+  {
+    const MafSequence& seq = block.sequence(j);
+    const string& name = seq.getName();
+    hashNumber(name.size());
+    hash = hashBytes_(name.data(), name.size(), hash);
+    hashNumber(seq.hasCoordinates() ? seq.start() + 1 : 0);
+    hashNumber(static_cast<uint64_t>(seq.getStrand()));
+    hashNumber(seq.getSrcSize());
+    const vector<int>& content = seq.getContent();
+    hashNumber(content.size());
+    hash = hashBytes_(reinterpret_cast<const char*>(content.data()), content.size() * sizeof(int), hash);
+  }
+  // Blocks without a column mask keep the same hash, so that existing caches remain valid:
+  if (const MafColumnMask* mask = MafColumnMask::getColumnMask(block))
+  {
+    const vector<uint64_t>& words = mask->getBitPlane().getWords();
+    hashNumber(mask->getNumberOfColumns());
+    hash = hashBytes_(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t), hash);
+  }
+  return hash;
+}
+
+MafStatisticsResultCache::Value MafStatisticsResultCache::toValue(const BppNumberI* number)
+{
+  Value value = {0, 0.};
+  if (auto x = dynamic_cast<const BppDouble*>(number))
+    value = {'d', x->getValue()};
+  else if (auto n = dynamic_cast<const BppInteger*>(number))
+    value = {'i', static_cast<double>(n->getValue())};
+  else if (auto u = dynamic_cast<const BppUnsignedInteger*>(number))
+    value = {'u', static_cast<double>(u->getValue())};
+  return value;
+}
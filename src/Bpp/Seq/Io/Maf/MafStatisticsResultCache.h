@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MAFSTATISTICSRESULTCACHE_H_
+#define _MAFSTATISTICSRESULTCACHE_H_
+
+#include "MafBlock.h"
+
+// From bpp-core:
+#include <Bpp/Numeric/Number.h>
+
+// From the STL:
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace bpp
+{
+/**
+ * @brief On-disk cache of statistics results, indexed by the content of blocks.
+ *
+ * Results are stored for a given configuration of statistics, described by a string, which has to identify
+ * the statistics and all their parameters (for instance, the options used to create them).
+ * One file is used per configuration, in a given directory. The file is read entirely when the cache is opened,
+ * and new results are appended to it.
+ *
+ * Each entry is indexed by a 64 bits hash of the block (see hashBlock()), and contains one value per column of results,
+ * with its type so that results are replayed identically. The file uses the same compact binary encoding as
+ * MafBlockSerializer, and is meant to be reused on the same machine only.
+ */
+class MafStatisticsResultCache
+{
+public:
+  /**
+   * @brief A cached value: type is 'd', 'i' or 'u' as in MafStatisticsResult, or 0 for a missing value.
+   */
+  struct Value
+  {
+    char type;
+    double value;
+  };
+
+private:
+  std::string configuration_;
+  std::string path_;
+  std::unordered_map<uint64_t, std::vector<Value>> entries_;
+  std::ofstream output_;
+  size_t nbHits_;
+  size_t nbMisses_;
+
+public:
+  /**
+   * @param directory The directory where cache files are stored.
+   * @param configuration A description of the statistics, identifying the cache file.
+   * @throw IOException If the cache file cannot be read or written.
+   */
+  MafStatisticsResultCache(const std::string& directory, const std::string& configuration);
+
+  virtual ~MafStatisticsResultCache() {}
+
+private:
+  MafStatisticsResultCache(const MafStatisticsResultCache& cache);
+  MafStatisticsResultCache& operator=(const MafStatisticsResultCache& cache);
+
+public:
+  const std::string& getPath() const { return path_; }
+
+  size_t getNumberOfEntries() const { return entries_.size(); }
+
+  /**
+   * @return The number of successful look-ups since the cache was opened.
+   */
+  size_t getNumberOfHits() const { return nbHits_; }
+
+  /**
+   * @return The number of failed look-ups since the cache was opened.
+   */
+  size_t getNumberOfMisses() const { return nbMisses_; }
+
+  /**
+   * @return The cached values for a block, or null if the block is not in the cache.
+   * @param key The hash of the block.
+   */
+  const std::vector<Value>* find(uint64_t key);
+
+  /**
+   * @brief Add the values of a block to the cache, and to the cache file.
+   *
+   * @param key The hash of the block.
+   * @param values The results for the block.
+   */
+  void insert(uint64_t key, const std::vector<Value>& values);
+
+  /**
+   * @return A hash of everything statistics may depend on in a block: score, pass, the name, coordinates and content
+   * of each sequence, and the excluded columns if the block has a column mask (see MafColumnMask).
+   */
+  static uint64_t hashBlock(const MafBlock& block);
+
+  /**
+   * @return The cached value corresponding to a number, which can be null.
+   */
+  static Value toValue(const BppNumberI* number);
+
+private:
+  static const uint64_t HASH_OFFSET_;
+
+  static uint64_t hashBytes_(const char* data, size_t size, uint64_t hash);
+
+  /**
+   * @return False if the file ends with an incomplete entry.
+   */
+  bool load_();
+
+  void writeEntry_(uint64_t key, const std::vector<Value>& values);
+};
+} // end of namespace bpp.
+
+#endif // _MAFSTATISTICSRESULTCACHE_H_
@@ -5,12 +5,12 @@
 #ifndef _MASKFILTERMAFITERATOR_H_
 #define _MASKFILTERMAFITERATOR_H_
 
-#include "AbstractMafIterator.h"
+#include "AbstractWindowFilterMafIterator.h"
 
 // From the STL:
 #include <iostream>
 #include <string>
-#include <deque>
+#include <vector>
 
 namespace bpp
 {
@@ -21,18 +21,11 @@ namespace bpp
  * and blocks adjusted accordingly.
  */
 class MaskFilterMafIterator :
-  public AbstractFilterMafIterator,
-  public virtual MafTrashIteratorInterface
+  public AbstractWindowFilterMafIterator
 {
 private:
   std::vector<std::string> species_;
-  unsigned int windowSize_;
-  unsigned int step_;
   unsigned int maxMasked_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
-  std::deque<std::unique_ptr<MafBlock>> trashBuffer_;
-  std::deque<std::vector<bool>> window_;
-  bool keepTrashedBlocks_;
 
 public:
   MaskFilterMafIterator(
@@ -42,28 +35,21 @@ public:
       unsigned int step,
       unsigned int maxMasked,
       bool keepTrashedBlocks) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "MASK CLEANER", "Sliding window for mask filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
-    maxMasked_(maxMasked),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks)
+    maxMasked_(maxMasked)
   {}
 
-public:
-  std::unique_ptr<MafBlock> nextRemovedBlock()
+protected:
+  /**
+   * @brief Count the number of masked sequences in each column.
+   */
+  bool computeColumnScores_(const MafBlock& block, std::vector<std::vector<double>>& scores);
+
+  bool isWindowRemoved_(const std::vector<double>& sums, size_t begin, size_t end) const
   {
-    if (trashBuffer_.size() == 0) return nullptr;
-    auto block = std::move(trashBuffer_.front());
-    trashBuffer_.pop_front();
-    return block;
+    return sums[0] > maxMasked_;
   }
-
-private:
-  std::unique_ptr<MafBlock> analyseCurrentBlock_();
 };
 } // end of namespace bpp.
 
@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "MsmcOutputMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/SequenceWithAnnotationTools.h>
@@ -61,12 +63,16 @@ void MsmcOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block
   SequenceWalker walker(refSeq);
   size_t offset = refSeq.start();
   int gap = refSeq.getAlphabet()->getGapCharacterCode();
+  // Columns excluded by a cleaning filter in annotate-only mode are skipped:
+  const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
 
   // Now we shall scan all sites for SNPs:
   for (size_t i = 0; i < sites.getNumberOfSites(); i++)
   {
     if (refSeq[i] == gap)
       continue;
+    if (mask && mask->isExcluded(i))
+      continue;
 
     // We call SNPs only at position without gap or unresolved characters:
     if (SiteTools::isComplete(sites.site(i)))
@@ -87,3 +93,19 @@ void MsmcOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block
     }
   }
 }
+
+void MsmcOutputMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+  MafBlockSerializer::writeString(out, currentChr_);
+  MafBlockSerializer::writeSize(out, lastPosition_);
+  MafBlockSerializer::writeSize(out, nbOfCalledSites_);
+}
+
+void MsmcOutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+  currentChr_      = MafBlockSerializer::readString(in);
+  lastPosition_    = MafBlockSerializer::readSize(in);
+  nbOfCalledSites_ = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+}
@@ -85,6 +85,10 @@ public:
 
 private:
   void writeBlock_(std::ostream& out, const MafBlock& block);
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
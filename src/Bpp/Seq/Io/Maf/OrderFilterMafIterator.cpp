@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "OrderFilterMafIterator.h"
+#include "MafBlockSerializer.h"
 
 // From bpp-seq:
 // #include <Bpp/Seq/SequenceWithAnnotationTools.h>
@@ -71,3 +72,17 @@ bool OrderFilterMafIterator::parseBlock_(const MafBlock& block)
   }
   return true;
 }
+
+void OrderFilterMafIterator::saveState_(ostream& out)
+{
+  MafBlockSerializer::writeString(out, currentChr_);
+  MafBlockSerializer::writeSize(out, previousBlockStart_);
+  MafBlockSerializer::writeSize(out, previousBlockStop_);
+}
+
+void OrderFilterMafIterator::restoreState_(istream& in)
+{
+  currentChr_         = MafBlockSerializer::readString(in);
+  previousBlockStart_ = MafBlockSerializer::readSize(in);
+  previousBlockStop_  = MafBlockSerializer::readSize(in);
+}
@@ -106,6 +106,10 @@ public:
 private:
   // Returns true if block is ordered with previous one
   bool parseBlock_(const MafBlock& block);
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
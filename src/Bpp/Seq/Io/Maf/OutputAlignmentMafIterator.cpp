@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "OutputAlignmentMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/Container/SequenceContainerTools.h>
@@ -20,31 +22,35 @@ unique_ptr<MafBlock> OutputAlignmentMafIterator::analyseCurrentBlock_()
   auto block = iterator_->nextBlock();
   if (block)
   {
-    if (output_)
+    // Masked columns are not written, each kept region being output as a separate alignment:
+    MafColumnMask::forEachKeptRegion(*block, [&](const MafBlock& region)
     {
-      writeBlock(*output_, *block);
-    }
-    else
-    {
-      string chr   = "ChrNA";
-      string start = "StartNA";
-      string stop  = "StopNA";
-      if (block->hasSequenceForSpecies(refSpecies_))
+      if (output_)
       {
-        const auto& refseq = block->sequenceForSpecies(refSpecies_);
-        chr   = refseq.getChromosome();
-        start = TextTools::toString(refseq.start());
-        stop  = TextTools::toString(refseq.stop());
+        writeBlock(*output_, region);
       }
-      string file = file_;
-      TextTools::replaceAll(file, "%i", TextTools::toString(++currentBlockIndex_));
-      TextTools::replaceAll(file, "%c", chr);
-      TextTools::replaceAll(file, "%b", start);
-      TextTools::replaceAll(file, "%e", stop);
-      std::ofstream output(file.c_str(), ios::out);
+      else
+      {
+        string chr   = "ChrNA";
+        string start = "StartNA";
+        string stop  = "StopNA";
+        if (region.hasSequenceForSpecies(refSpecies_))
+        {
+          const auto& refseq = region.sequenceForSpecies(refSpecies_);
+          chr   = refseq.getChromosome();
+          start = TextTools::toString(refseq.start());
+          stop  = TextTools::toString(refseq.stop());
+        }
+        string file = file_;
+        TextTools::replaceAll(file, "%i", TextTools::toString(++currentBlockIndex_));
+        TextTools::replaceAll(file, "%c", chr);
+        TextTools::replaceAll(file, "%b", start);
+        TextTools::replaceAll(file, "%e", stop);
+        std::ofstream output(file.c_str(), ios::out);
 
-      writeBlock(output, *block);
-    }
+        writeBlock(output, region);
+      }
+    });
   }
   return block;
 }
@@ -68,3 +74,15 @@ void OutputAlignmentMafIterator::writeBlock(std::ostream& out, const MafBlock& b
     out << aln->getNumberOfSequences() << " " << aln->getNumberOfSites() << " 1" << endl; // We here assume sequences are haploid.
   writer_->writeAlignment(out, *aln);
 }
+
+void OutputAlignmentMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+  MafBlockSerializer::writeSize(out, currentBlockIndex_);
+}
+
+void OutputAlignmentMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+  currentBlockIndex_ = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+}
@@ -142,6 +142,10 @@ private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
 
   void writeBlock(std::ostream& out, const MafBlock& block) const;
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
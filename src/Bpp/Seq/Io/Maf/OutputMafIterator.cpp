@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "OutputMafIterator.h"
+#include "MafBlockSerializer.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/SequenceWithAnnotationTools.h>
@@ -112,3 +113,13 @@ void OutputMafIterator::writeBlock(std::ostream& out, const MafBlock& block) con
   }
   out << endl;
 }
+
+void OutputMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+}
+
+void OutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+}
@@ -6,6 +6,7 @@
 #define _OUTPUTMAFITERATOR_H_
 
 #include "AbstractMafIterator.h"
+#include "MafColumnMask.h"
 
 // From the STL:
 #include <iostream>
@@ -56,13 +57,22 @@ public:
   {
     currentBlock_ = iterator_->nextBlock();
     if (output_ && currentBlock_)
-      writeBlock(*output_, *currentBlock_);
+    {
+      MafColumnMask::forEachKeptRegion(*currentBlock_, [&](const MafBlock& block)
+      {
+        writeBlock(*output_, block);
+      });
+    }
     return std::move(currentBlock_);
   }
 
 private:
   void writeHeader(std::ostream& out) const;
   void writeBlock(std::ostream& out, const MafBlock& block) const;
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "PlinkOutputMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/SequenceWithAnnotationTools.h>
@@ -85,12 +87,16 @@ void PlinkOutputMafIterator::parseBlock_(std::ostream& out, const MafBlock& bloc
   SequenceWalker walker(refSeq);
   size_t offset = refSeq.start();
   int gap = refSeq.getAlphabet()->getGapCharacterCode();
+  // Columns excluded by a cleaning filter in annotate-only mode are skipped:
+  const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
 
   // Now we shall scan all sites for SNPs:
   for (size_t i = 0; i < sites.getNumberOfSites(); i++)
   {
     if (refSeq[i] == gap)
       continue;
+    if (mask && mask->isExcluded(i))
+      continue;
 
     // We call SNPs only at position without gap or unresolved characters, and for biallelic sites:
     if (SiteTools::isComplete(sites.site(i)) && SiteTools::getNumberOfDistinctCharacters(sites.site(i)) == 2)
@@ -131,3 +137,43 @@ void PlinkOutputMafIterator::writePedToFile_(ostream& out)
     out << ped << endl;
   }
 }
+
+void PlinkOutputMafIterator::saveState_(ostream& out)
+{
+  // The ped file is only written at the end, but the genotypes collected so far are kept:
+  saveOutputPosition_(out, outputMap_.get());
+  MafBlockSerializer::writeSize(out, ped_.size());
+  for (const auto& line : ped_)
+  {
+    MafBlockSerializer::writeString(out, line);
+  }
+  MafBlockSerializer::writeString(out, currentChr_);
+  MafBlockSerializer::writeSize(out, lastPosition_);
+  MafBlockSerializer::writeSize(out, chrCodes_.size());
+  for (const auto& it : chrCodes_)
+  {
+    MafBlockSerializer::writeString(out, it.first);
+    MafBlockSerializer::writeSize(out, it.second);
+  }
+  MafBlockSerializer::writeSize(out, currentCode_);
+}
+
+void PlinkOutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, outputMap_.get());
+  ped_.resize(MafBlockSerializer::readSize(in));
+  for (auto& line : ped_)
+  {
+    line = MafBlockSerializer::readString(in);
+  }
+  currentChr_   = MafBlockSerializer::readString(in);
+  lastPosition_ = MafBlockSerializer::readSize(in);
+  chrCodes_.clear();
+  size_t n = MafBlockSerializer::readSize(in);
+  for (size_t i = 0; i < n; ++i)
+  {
+    string chr = MafBlockSerializer::readString(in);
+    chrCodes_[chr] = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+  }
+  currentCode_ = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+}
@@ -145,6 +145,10 @@ private:
   void init_();
   void parseBlock_(std::ostream& out, const MafBlock& block);
   void writePedToFile_(std::ostream& out);
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
@@ -5,12 +5,12 @@
 #ifndef _QUALITYFILTERMAFITERATOR_H_
 #define _QUALITYFILTERMAFITERATOR_H_
 
-#include "AbstractMafIterator.h"
+#include "AbstractWindowFilterMafIterator.h"
 
 // From the STL:
 #include <iostream>
 #include <string>
-#include <deque>
+#include <vector>
 
 namespace bpp
 {
@@ -21,45 +21,34 @@ namespace bpp
  * and blocks adjusted accordingly.
  */
 class QualityFilterMafIterator :
-  public AbstractFilterMafIterator,
-  public virtual MafTrashIteratorInterface
+  public AbstractWindowFilterMafIterator
 {
 private:
   std::vector<std::string> species_;
-  unsigned int windowSize_;
-  unsigned int step_;
   unsigned int minQual_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
-  std::deque<std::unique_ptr<MafBlock>> trashBuffer_;
-  std::deque<std::vector<int>> window_;
-  bool keepTrashedBlocks_;
 
 public:
   QualityFilterMafIterator(
       std::shared_ptr<MafIteratorInterface> iterator,
       const std::vector<std::string>& species, unsigned int windowSize, unsigned int step, unsigned int minQual, bool keepTrashedBlocks) :
-    AbstractFilterMafIterator(iterator),
+    AbstractWindowFilterMafIterator(iterator, windowSize, step, keepTrashedBlocks, "QUAL CLEANER", "Sliding window for quality filter"),
     species_(species),
-    windowSize_(windowSize),
-    step_(step),
-    minQual_(minQual),
-    blockBuffer_(),
-    trashBuffer_(),
-    window_(species.size()),
-    keepTrashedBlocks_(keepTrashedBlocks)
+    minQual_(minQual)
   {}
 
-public:
-  std::unique_ptr<MafBlock> nextRemovedBlock()
+protected:
+  /**
+   * @brief Compute the sum of positive scores (first score) and the number of missing scores (second score) in each column.
+   *
+   * Blocks where at least one species has no quality score are not filtered.
+   */
+  bool computeColumnScores_(const MafBlock& block, std::vector<std::vector<double>>& scores);
+
+  bool isWindowRemoved_(const std::vector<double>& sums, size_t begin, size_t end) const
   {
-    if (trashBuffer_.size() == 0) return nullptr;
-    auto block = std::move(trashBuffer_.front());
-    trashBuffer_.pop_front();
-    return block;
+    double n = static_cast<double>(species_.size() * windowSize_) - sums[1];
+    return n > 0 && (sums[0] / n) < minQual_;
   }
-
-private:
-  std::unique_ptr<MafBlock> analyseCurrentBlock_();
 };
 } // end of namespace bpp.
 
@@ -3,11 +3,13 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "SequenceLDhotOutputMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+#include "MafColumnView.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/Container/SequenceContainerTools.h>
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
-#include <Bpp/Seq/SiteTools.h>
 
 using namespace bpp;
 
@@ -22,77 +24,56 @@ unique_ptr<MafBlock> SequenceLDhotOutputMafIterator::analyseCurrentBlock_()
   auto block = iterator_->nextBlock();
   if (block)
   {
-    string chr   = "ChrNA";
-    string start = "StartNA";
-    string stop  = "StopNA";
-    if (block->hasSequenceForSpecies(refSpecies_))
+    // Masked columns are not written, each kept region being output in a separate file:
+    MafColumnMask::forEachKeptRegion(*block, [&](const MafBlock& region)
     {
-      const MafSequence& refseq = block->sequenceForSpecies(refSpecies_);
-      chr   = refseq.getChromosome();
-      start = TextTools::toString(refseq.start());
-      stop  = TextTools::toString(refseq.stop());
-    }
-    string file = file_;
-    TextTools::replaceAll(file, "%i", TextTools::toString(++currentBlockIndex_));
-    TextTools::replaceAll(file, "%c", chr);
-    TextTools::replaceAll(file, "%b", start);
-    TextTools::replaceAll(file, "%e", stop);
-    std::ofstream output(file.c_str(), ios::out);
-    writeBlock(output, *block);
+      string chr   = "ChrNA";
+      string start = "StartNA";
+      string stop  = "StopNA";
+      if (region.hasSequenceForSpecies(refSpecies_))
+      {
+        const MafSequence& refseq = region.sequenceForSpecies(refSpecies_);
+        chr   = refseq.getChromosome();
+        start = TextTools::toString(refseq.start());
+        stop  = TextTools::toString(refseq.stop());
+      }
+      string file = file_;
+      TextTools::replaceAll(file, "%i", TextTools::toString(++currentBlockIndex_));
+      TextTools::replaceAll(file, "%c", chr);
+      TextTools::replaceAll(file, "%b", start);
+      TextTools::replaceAll(file, "%e", stop);
+      std::ofstream output(file.c_str(), ios::out);
+      writeBlock(output, region);
+    });
   }
   return block;
 }
 
 void SequenceLDhotOutputMafIterator::writeBlock(std::ostream& out, const MafBlock& block) const
 {
-  // First get alignment:
-  unique_ptr<VectorSiteContainer> variableSites = make_unique<VectorSiteContainer>(block.getSequenceNames(), AlphabetTools::DNA_ALPHABET);
-
   // We first preparse the data:
   // We assume all sequences are distinct:
   size_t nbDistinct = block.getNumberOfSequences();
   size_t nbGenes = block.getNumberOfSequences();
   size_t nbLoci = 0;
 
+  // Columns are read in place, and only the indices of variable sites are recorded:
+  MafColumnCursor cursor(block);
+  vector<size_t> variableSites;
   string positions = "";
   for (size_t i = 0; i < block.getNumberOfSites(); ++i)
   {
-    const Site& s = block.site(i);
-    if (completeOnly_ && !SiteTools::isComplete(s))
+    cursor.moveTo(i);
+    if (completeOnly_ && !cursor.isComplete())
     {
       continue;
     }
-    unsigned int count = 0;
-    int x = -1;
-    for (size_t j = 0; j < s.size() && count < 2; ++j)
-    {
-      if (!AlphabetTools::DNA_ALPHABET->isGap(s[j]) && !AlphabetTools::DNA_ALPHABET->isUnresolved(s[j]))
-      {
-        if (count == 0)
-        {
-          // First state found
-          count++;
-          // We record the state
-          x = s[j];
-        }
-        else
-        {
-          if (s[j] != x)
-          {
-            // New state found
-            count++;
-          }
-          // Otherwise, same state as before.
-        }
-      }
-    }
-    if (count == 2)
+    if (cursor.getCounts().getNumberOfAlleles() >= 2)
     {
       // At least two alleles (non-gap, non-unresolved) found in this position, so we record it
       positions += " " + TextTools::toString(i + 1);
       nbLoci++;
-      auto tmpSite = make_unique<Site>(block.site(i));
-      variableSites->addSite(tmpSite);
+      variableSites.push_back(i);
     }
   }
 
@@ -109,8 +90,23 @@ void SequenceLDhotOutputMafIterator::writeBlock(std::ostream& out, const MafBloc
 
   for (size_t i = 0; i < block.getNumberOfSequences(); ++i)
   {
-    out << variableSites->sequence(i).toString() << " 1" << endl;
+    const MafSequence& seq = block.sequence(i);
+    for (size_t site : variableSites)
+    {
+      out << AlphabetTools::DNA_ALPHABET->intToChar(seq[site]);
+    }
+    out << " 1" << endl;
   }
 
   out << "#" << endl;
 }
+
+void SequenceLDhotOutputMafIterator::saveState_(ostream& out)
+{
+  MafBlockSerializer::writeSize(out, currentBlockIndex_);
+}
+
+void SequenceLDhotOutputMafIterator::restoreState_(istream& in)
+{
+  currentBlockIndex_ = static_cast<unsigned int>(MafBlockSerializer::readSize(in));
+}
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "SequenceStatisticsMafIterator.h"
+#include "MafColumnMask.h"
 
 using namespace bpp;
 
@@ -18,13 +19,23 @@ SequenceStatisticsMafIterator::SequenceStatisticsMafIterator(
   AbstractFilterMafIterator(iterator),
   statistics_(statistics),
   results_(),
-  names_()
+  names_(),
+  tagIndices_(),
+  engine_(statistics),
+  cache_(),
+  cachedResult_(),
+  resultFromCache_(false)
 {
   string name;
   for (size_t i = 0; i < statistics_.size(); ++i)
   {
     name = statistics_[i]->getShortName();
     vector<string> tags = statistics_[i]->getSupportedTags();
+    for (size_t j = 0; j < tags.size(); ++j)
+    {
+      const MafStatisticsResult& result = statistics_[i]->getResult();
+      tagIndices_.push_back(make_pair(&result, result.getTagIndex(tags[j])));
+    }
     if (tags.size() > 1)
     {
       for (size_t j = 0; j < tags.size(); ++j)
@@ -42,29 +53,71 @@ SequenceStatisticsMafIterator::SequenceStatisticsMafIterator(
 
 unique_ptr<MafBlock> SequenceStatisticsMafIterator::analyseCurrentBlock_()
 {
-  vector<string> tags;
   currentBlock_ = iterator_->nextBlock();
   if (currentBlock_)
   {
-    size_t k = 0;
-    for (size_t i = 0; i < statistics_.size(); ++i)
+    // Masked columns are skipped by the statistics engine, without copying the block:
+    const MafColumnMask* mask = MafColumnMask::getColumnMask(*currentBlock_);
+    uint64_t key = 0;
+    resultFromCache_ = false;
+    if (cache_)
     {
-      statistics_[i]->compute(*currentBlock_);
-      const MafStatisticsResult& result = statistics_[i]->getResult();
-      tags = statistics_[i]->getSupportedTags();
-      for (size_t j = 0; j < tags.size(); ++j)
+      key = MafStatisticsResultCache::hashBlock(*currentBlock_);
+      const vector<MafStatisticsResultCache::Value>* values = cache_->find(key);
+      if (values && values->size() == results_.size())
       {
-        if (result.hasValue(tags[j]))
+        // Results are replayed from the cache, in column order:
+        for (size_t k = 0; k < results_.size(); ++k)
         {
-          results_[k].reset(result.getValue(tags[j]).clone());
+          const MafStatisticsResultCache::Value& value = (*values)[k];
+          switch (value.type)
+          {
+          case 'd': cachedResult_.setValueAt(k, value.value); break;
+          case 'i': cachedResult_.setValueAt(k, static_cast<int>(value.value)); break;
+          case 'u': cachedResult_.setValueAt(k, static_cast<unsigned int>(value.value)); break;
+          }
+          results_[k] = value.type != 0 ? &cachedResult_.getValueAt(k) : nullptr;
         }
-        else
-        {
-          results_[k] = 0;
-        }
-        k++;
+        resultFromCache_ = true;
+        return std::move(currentBlock_);
+      }
+    }
+    engine_.compute(*currentBlock_, mask);
+    for (size_t k = 0; k < tagIndices_.size(); ++k)
+    {
+      const MafStatisticsResult& result = *tagIndices_[k].first;
+      size_t index = tagIndices_[k].second;
+      results_[k] = result.hasValueAt(index) ? &result.getValueAt(index) : nullptr;
+    }
+    if (cache_)
+    {
+      vector<MafStatisticsResultCache::Value> values(results_.size());
+      for (size_t k = 0; k < results_.size(); ++k)
+      {
+        values[k] = MafStatisticsResultCache::toValue(results_[k]);
       }
+      cache_->insert(key, values);
     }
   }
   return std::move(currentBlock_);
 }
+
+void SequenceStatisticsMafIterator::setResultCache(const string& directory)
+{
+  string description;
+  for (const auto& statistic : statistics_)
+  {
+    description += statistic->getConfiguration() + "\n";
+  }
+  for (const auto& name : names_)
+  {
+    description += "\t" + name;
+  }
+  cache_ = make_shared<MafStatisticsResultCache>(directory, description);
+  // Cached values are stored with one tag per column, the index of the column (names may not be unique):
+  cachedResult_ = MafStatisticsResult();
+  for (size_t k = 0; k < names_.size(); ++k)
+  {
+    cachedResult_.getTagIndex(TextTools::toString(k));
+  }
+}
@@ -7,6 +7,7 @@
 
 #include "AbstractMafIterator.h"
 #include "MafStatistics.h"
+#include "MafStatisticsResultCache.h"
 
 // From the STL:
 #include <iostream>
@@ -20,20 +21,33 @@ namespace bpp
  *
  * Computed statistics are stored into a vector of double, which can be retrieved as well as statistics names.
  * Listeners can be set up to automatically analyse or write the output after iterations are over.
+ * Columns excluded by the MafColumnMask of a block, if any, are ignored.
+ * Statistics are computed with a MafStatisticsEngine, so that all column-wise statistics are updated in a single pass over each block.
  *
  * The current implementation focuses on speed and memory efificiency, as it only stores in memory the current results of the statistics.
+ * Results are not copied: tags are resolved to indices once at construction, and values are read in place from each statistic.
  * The only drawback of this, is that disk access might be high when writing the results,
  * although appropriate buffering should most likely circumvent the issue.
  * The code is easily extensible, however, to enable storage of all results into a matrix,
  * with writing only once at the end of iterations.
+ *
+ * Optionally, results can be stored in an on-disk cache indexed by the content of blocks (see setResultCache()),
+ * so that statistics are not computed again for blocks already analysed in a previous run with the same configuration.
+ * Cached results are replayed as such, statistics being left untouched. As a consequence, they cannot be accumulated
+ * over blocks read from the cache, see isResultFromCache().
  */
 class SequenceStatisticsMafIterator :
   public AbstractFilterMafIterator
 {
 private:
   std::vector<std::shared_ptr<MafStatisticsInterface>> statistics_;
-  std::vector<std::unique_ptr<BppNumberI>> results_;
+  std::vector<const BppNumberI*> results_;
   std::vector<std::string> names_;
+  std::vector<std::pair<const MafStatisticsResult*, size_t>> tagIndices_; // Result and tag index for each column.
+  MafStatisticsEngine engine_;
+  std::shared_ptr<MafStatisticsResultCache> cache_;
+  MafStatisticsResult cachedResult_;
+  bool resultFromCache_;
 
 public:
   /**
@@ -49,7 +63,12 @@ private:
     AbstractFilterMafIterator(0),
     statistics_(iterator.statistics_),
     results_(),
-    names_(iterator.names_)
+    names_(iterator.names_),
+    tagIndices_(iterator.tagIndices_),
+    engine_(iterator.engine_),
+    cache_(iterator.cache_),
+    cachedResult_(iterator.cachedResult_),
+    resultFromCache_(false)
   {}
 
   SequenceStatisticsMafIterator& operator=(const SequenceStatisticsMafIterator& iterator)
@@ -57,13 +76,42 @@ private:
     statistics_ = iterator.statistics_;
     results_.clear();
     names_ = iterator.names_;
+    tagIndices_ = iterator.tagIndices_;
+    engine_ = iterator.engine_;
+    cache_ = iterator.cache_;
+    cachedResult_ = iterator.cachedResult_;
+    resultFromCache_ = false;
     return *this;
   }
 
 public:
-  const std::vector<std::unique_ptr<BppNumberI>>& getResults() const { return results_; }
+  /**
+   * @return The results for the current block, in the order of the column names.
+   * Values are owned by the statistics and are only valid until the next block is analysed.
+   * Missing values are null pointers.
+   */
+  const std::vector<const BppNumberI*>& getResults() const { return results_; }
   const std::vector<std::string>& getResultsColumnNames() const { return names_; }
 
+  const std::vector<std::shared_ptr<MafStatisticsInterface>>& getStatistics() const { return statistics_; }
+
+  /**
+   * @brief Enable the result cache.
+   *
+   * The cache file is identified by the configuration of each statistic (see MafStatisticsInterface::getConfiguration())
+   * and by the names of the result columns, so that results of distinct statistics are never mixed.
+   *
+   * @param directory The directory where cache files are stored.
+   */
+  void setResultCache(const std::string& directory);
+
+  std::shared_ptr<const MafStatisticsResultCache> getResultCache() const { return cache_; }
+
+  /**
+   * @return True if the results of the current block were read from the cache, in which case statistics were not computed.
+   */
+  bool isResultFromCache() const { return resultFromCache_; }
+
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
 };
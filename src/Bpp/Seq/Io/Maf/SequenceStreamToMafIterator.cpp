@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "SequenceStreamToMafIterator.h"
+#include "MafBlockSerializer.h"
 #include <Bpp/Text/TextTools.h>
 #include <Bpp/Text/StringTokenizer.h>
 
@@ -40,5 +41,32 @@ unique_ptr<MafBlock> SequenceStreamToMafIterator::analyseCurrentBlock_()
   }
   block->addSequence(mafSeq);
 
+  if (progress_)
+  {
+    progress_->addBlocks();
+    streamoff pos = stream_->tellg();
+    if (pos >= 0)
+      progress_->setBytes(static_cast<size_t>(pos));
+  }
+
   return block;
 }
+
+void SequenceStreamToMafIterator::saveState_(ostream& out)
+{
+  streamoff pos = stream_->tellg();
+  if (pos < 0)
+    throw Exception("SequenceStreamToMafIterator::saveState_. Input stream does not support positioning, checkpoints are not available.");
+  MafBlockSerializer::writeSize(out, static_cast<size_t>(pos));
+  MafBlockSerializer::writeSize(out, firstBlock_ ? 1 : 0);
+}
+
+void SequenceStreamToMafIterator::restoreState_(istream& in)
+{
+  size_t pos = MafBlockSerializer::readSize(in);
+  firstBlock_ = MafBlockSerializer::readSize(in) == 1;
+  stream_->clear();
+  stream_->seekg(static_cast<streamoff>(pos));
+  if (!*stream_)
+    throw IOException("SequenceStreamToMafIterator::restoreState_. Could not reposition input stream.");
+}
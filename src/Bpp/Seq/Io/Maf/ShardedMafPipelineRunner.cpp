@@ -0,0 +1,381 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "ShardedMafPipelineRunner.h"
+
+#include <Bpp/App/ApplicationTools.h>
+#include <Bpp/Text/TextTools.h>
+#include <Bpp/Text/StringTokenizer.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+/**
+ * @brief Read the blocks located in a set of byte ranges of a maf file.
+ */
+class MafRangeIterator :
+  public AbstractMafIterator
+{
+private:
+  shared_ptr<istream> stream_;
+  unique_ptr<MafParser> parser_;
+  vector<pair<streamoff, streamoff>> ranges_;
+  size_t currentRange_;
+  bool inRange_;
+
+public:
+  MafRangeIterator(
+      shared_ptr<istream> stream,
+      unique_ptr<MafParser> parser,
+      const vector<pair<streamoff, streamoff>>& ranges) :
+    stream_(stream),
+    parser_(std::move(parser)),
+    ranges_(ranges),
+    currentRange_(0),
+    inRange_(false)
+  {}
+
+private:
+  unique_ptr<MafBlock> analyseCurrentBlock_()
+  {
+    while (currentRange_ < ranges_.size())
+    {
+      if (!inRange_)
+      {
+        stream_->clear();
+        stream_->seekg(ranges_[currentRange_].first);
+        inRange_ = true;
+      }
+      // Blank and comment lines after the last block of a range are part of that range,
+      // the position is therefore tested at the beginning of the next block:
+      skipToNextBlock_();
+      streamoff pos = stream_->tellg();
+      if (pos >= 0 && pos < ranges_[currentRange_].second)
+      {
+        auto block = parser_->nextBlock();
+        if (block)
+          return block;
+      }
+      currentRange_++;
+      inRange_ = false;
+    }
+    return nullptr;
+  }
+
+  void skipToNextBlock_()
+  {
+    int c = stream_->peek();
+    while (c != EOF && (c == '#' || isspace(c)))
+    {
+      if (c == '#')
+        stream_->ignore(numeric_limits<streamsize>::max(), '\n');
+      else
+        stream_->get();
+      c = stream_->peek();
+    }
+  }
+};
+}
+
+void ShardedMafPipelineRunner::addShard(const string& name, const string& mafFile)
+{
+  Shard_ shard;
+  shard.name = name;
+  shard.file = mafFile;
+  shards_.push_back(shard);
+}
+
+void ShardedMafPipelineRunner::addShardsFromIndexedFile(const string& mafFile, const string& refSpecies)
+{
+  ifstream input(mafFile.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("ShardedMafPipelineRunner::addShardsFromIndexedFile. Could not open file " + mafFile + ".");
+
+  map<string, size_t> shardIndex;
+  // Consecutive blocks on the same chromosome form a single range:
+  auto addRange = [&](const string& chr, streamoff begin, streamoff end)
+  {
+    if (chr.empty() || end <= begin)
+      return;
+    if (shardIndex.find(chr) == shardIndex.end())
+    {
+      shardIndex[chr] = shards_.size();
+      addShard(chr, mafFile);
+    }
+    shards_[shardIndex[chr]].ranges.push_back(make_pair(begin, end));
+  };
+
+  string line;
+  streamoff offset = 0;
+  streamoff runStart = 0;
+  string runChr;
+  string blockChr;
+  streamoff blockStart = -1;
+  while (getline(input, line))
+  {
+    if (line.size() > 0 && line[0] == 'a')
+    {
+      if (blockStart >= 0 && blockChr != runChr)
+      {
+        addRange(runChr, runStart, blockStart);
+        runChr = blockChr;
+        runStart = blockStart;
+      }
+      blockStart = offset;
+      blockChr = "";
+    }
+    else if (line.size() > 0 && line[0] == 's' && blockStart >= 0 && blockChr.empty())
+    {
+      StringTokenizer st(line);
+      st.nextToken(); // The 's' tag
+      if (st.hasMoreToken())
+      {
+        string src = st.nextToken();
+        size_t pos = src.find(".");
+        if (pos != string::npos && src.substr(0, pos) == refSpecies)
+          blockChr = src.substr(pos + 1);
+      }
+    }
+    offset += static_cast<streamoff>(line.size()) + 1;
+  }
+  if (blockStart >= 0)
+  {
+    if (blockChr != runChr)
+    {
+      addRange(runChr, runStart, blockStart);
+      runChr = blockChr;
+      runStart = blockStart;
+    }
+    addRange(runChr, runStart, offset);
+  }
+}
+
+void ShardedMafPipelineRunner::sortShards()
+{
+  stable_sort(shards_.begin(), shards_.end(), [](const Shard_& a, const Shard_& b) {
+    return compareChromosomeNames(a.name, b.name);
+  });
+}
+
+vector<string> ShardedMafPipelineRunner::getShardNames() const
+{
+  vector<string> names;
+  for (const auto& shard : shards_)
+  {
+    names.push_back(shard.name);
+  }
+  return names;
+}
+
+void ShardedMafPipelineRunner::addOutput(
+    const string& name,
+    shared_ptr<ostream> destination,
+    size_t nbHeaderLines,
+    const string& headerPrefix)
+{
+  if (!destination)
+    throw Exception("ShardedMafPipelineRunner::addOutput. Null destination stream for output " + name + ".");
+  Output_ output;
+  output.destination = destination;
+  output.nbHeaderLines = nbHeaderLines;
+  output.headerPrefix = headerPrefix;
+  outputs_[name] = output;
+}
+
+void ShardedMafPipelineRunner::run(unsigned int nbThreads, bool sorted)
+{
+  if (nbThreads == 0)
+    nbThreads = max(1u, thread::hardware_concurrency());
+  if (sorted)
+    sortShards();
+  size_t nbShards = shards_.size();
+
+  // Temporary files, per shard and output:
+  filesystem::path dir = tmpDirectory_.empty() ? filesystem::temp_directory_path() : filesystem::path(tmpDirectory_);
+  string runId = TextTools::toString(random_device()());
+  vector<map<string, string>> files(nbShards);
+  for (size_t i = 0; i < nbShards; ++i)
+  {
+    for (const auto& output : outputs_)
+    {
+      files[i][output.first] = (dir / ("bppmaf_shard_" + runId + "_" + TextTools::toString(i) + "_" + output.first + ".tmp")).string();
+    }
+  }
+  auto removeFiles = [&]()
+  {
+    for (const auto& shardFiles : files)
+    {
+      for (const auto& file : shardFiles)
+      {
+        std::remove(file.second.c_str());
+      }
+    }
+  };
+
+  if (verbose_)
+    ApplicationTools::displayTask("Running pipeline on " + TextTools::toString(nbShards) + " shards", true);
+  vector<exception_ptr> errors(nbShards);
+  atomic<size_t> nextShard(0);
+  size_t nbDone = 0;
+  mutex displayMutex;
+  auto worker = [&]()
+  {
+    for (size_t i = nextShard++; i < nbShards; i = nextShard++)
+    {
+      try
+      {
+        runShard_(shards_[i], files[i]);
+      }
+      catch (...)
+      {
+        errors[i] = current_exception();
+      }
+      if (verbose_)
+      {
+        lock_guard<mutex> lock(displayMutex);
+        ApplicationTools::displayGauge(nbDone++, nbShards - 1, '>');
+      }
+    }
+  };
+  vector<thread> pool;
+  for (unsigned int t = 1; t < nbThreads && t < nbShards; ++t)
+  {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : pool)
+  {
+    t.join();
+  }
+  if (verbose_)
+    ApplicationTools::displayTaskDone();
+
+  for (auto& error : errors)
+  {
+    if (error)
+    {
+      removeFiles();
+      rethrow_exception(error);
+    }
+  }
+
+  // Concatenate outputs in shard order:
+  for (const auto& output : outputs_)
+  {
+    vector<string> outputFiles;
+    for (size_t i = 0; i < nbShards; ++i)
+    {
+      outputFiles.push_back(files[i][output.first]);
+    }
+    mergeOutput_(output.second, outputFiles);
+  }
+  removeFiles();
+}
+
+void ShardedMafPipelineRunner::runShard_(const Shard_& shard, const map<string, string>& outputFiles)
+{
+  auto stream = make_shared<ifstream>(shard.file.c_str(), ios::in | ios::binary);
+  if (!*stream)
+    throw IOException("ShardedMafPipelineRunner::runShard_. Could not open file " + shard.file + ".");
+  auto parser = make_unique<MafParser>(stream, parseMask_, checkSequenceSize_, dotOption_);
+  parser->setVerbose(false);
+  shared_ptr<MafIteratorInterface> input;
+  if (shard.ranges.empty())
+    input = std::move(parser);
+  else
+    input = make_shared<MafRangeIterator>(stream, std::move(parser), shard.ranges);
+  input->setVerbose(false);
+
+  auto pipeline = factory_(input, shard.name, outputFiles);
+  if (!pipeline)
+    throw Exception("ShardedMafPipelineRunner::runShard_. Factory returned no pipeline for shard " + shard.name + ".");
+  pipeline->setVerbose(false);
+  while (pipeline->nextBlock())
+  {}
+  // Output files are closed when the pipeline is destroyed.
+}
+
+void ShardedMafPipelineRunner::mergeOutput_(const Output_& output, const vector<string>& files)
+{
+  ostream& out = *output.destination;
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    ifstream in(files[i].c_str(), ios::in | ios::binary);
+    if (!in)
+      continue; // This shard did not write anything for this output.
+    if (i > 0)
+    {
+      // Skip header lines:
+      string line;
+      for (size_t j = 0; j < output.nbHeaderLines && in.peek() != EOF; ++j)
+      {
+        getline(in, line);
+      }
+      if (!output.headerPrefix.empty())
+      {
+        streampos pos = in.tellg();
+        while (getline(in, line) && line.compare(0, output.headerPrefix.size(), output.headerPrefix) == 0)
+        {
+          pos = in.tellg();
+        }
+        in.clear();
+        in.seekg(pos);
+      }
+    }
+    if (in.peek() != EOF)
+      out << in.rdbuf();
+  }
+  out.flush();
+  if (!out)
+    throw IOException("ShardedMafPipelineRunner::mergeOutput_. Error while writing output.");
+}
+
+bool ShardedMafPipelineRunner::compareChromosomeNames(const string& a, const string& b)
+{
+  size_t i = 0, j = 0;
+  while (i < a.size() && j < b.size())
+  {
+    if (isdigit(a[i]) && isdigit(b[j]))
+    {
+      // Compare numbers by value, ignoring leading zeros:
+      size_t i2 = i, j2 = j;
+      while (i2 < a.size() && isdigit(a[i2])) ++i2;
+      while (j2 < b.size() && isdigit(b[j2])) ++j2;
+      size_t i0 = i, j0 = j;
+      while (i0 < i2 - 1 && a[i0] == '0') ++i0;
+      while (j0 < j2 - 1 && b[j0] == '0') ++j0;
+      if (i2 - i0 != j2 - j0)
+        return i2 - i0 < j2 - j0;
+      int c = a.compare(i0, i2 - i0, b, j0, j2 - j0);
+      if (c != 0)
+        return c < 0;
+      i = i2;
+      j = j2;
+    }
+    else
+    {
+      if (a[i] != b[j])
+        return a[i] < b[j];
+      ++i;
+      ++j;
+    }
+  }
+  return a.size() - i < b.size() - j;
+}
@@ -0,0 +1,181 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _SHARDEDMAFPIPELINERUNNER_H_
+#define _SHARDEDMAFPIPELINERUNNER_H_
+
+#include "MafParser.h"
+
+// From the STL:
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+
+namespace bpp
+{
+/**
+ * @brief Run independent copies of a maf pipeline on each chromosome of a reference species, in parallel.
+ *
+ * Many analyses can be performed independently on each reference chromosome. This class takes a pipeline factory,
+ * which builds a chain of iterators on top of a given input iterator, and runs one instance of the pipeline per chromosome
+ * ("shard") on a pool of threads.
+ *
+ * Shards are either given as separate files (pre-split input), or computed from a single maf file sorted by reference chromosome
+ * (see addShardsFromIndexedFile()).
+ *
+ * Each output of the pipeline (maf, vcf, table or statistics files for instance) is declared with addOutput(). For each shard,
+ * the factory receives the names of temporary files where to write the corresponding output. Once all shards are processed,
+ * temporary files are concatenated into the final destination in shard order, and removed. By default, shards are sorted
+ * by chromosome name before running, so that outputs do not depend on the order in which shards were added (see run()). Header lines written by the
+ * pipeline at the beginning of each file are only kept for the first shard.
+ *
+ * The factory is called from within the worker threads, and the iterators it creates should not share any mutable state.
+ * In particular, verbosity and log streams should be turned off, as ApplicationTools::message is not thread-safe.
+ * The last iterator returned by the factory is set to non-verbose by the runner.
+ */
+class ShardedMafPipelineRunner
+{
+public:
+  /**
+   * @brief Function building a pipeline.
+   *
+   * Arguments are the input iterator for the shard, the name of the shard (typically a chromosome name),
+   * and the temporary files to be used for each declared output, indexed by output name.
+   * The function returns the last iterator of the pipeline, which will be looped over until no more block is available.
+   */
+  typedef std::function<std::shared_ptr<MafIteratorInterface>(
+        std::shared_ptr<MafIteratorInterface> input,
+        const std::string& shardName,
+        const std::map<std::string, std::string>& outputFiles)> PipelineFactory;
+
+private:
+  struct Shard_
+  {
+    std::string name;
+    std::string file;
+    // Byte ranges to read from the file, the whole file is read if empty.
+    std::vector<std::pair<std::streamoff, std::streamoff>> ranges;
+  };
+
+  struct Output_
+  {
+    std::shared_ptr<std::ostream> destination;
+    size_t nbHeaderLines;
+    std::string headerPrefix;
+  };
+
+  PipelineFactory factory_;
+  std::vector<Shard_> shards_;
+  std::map<std::string, Output_> outputs_;
+  std::string tmpDirectory_;
+  bool parseMask_;
+  bool checkSequenceSize_;
+  short dotOption_;
+  bool verbose_;
+
+public:
+  /**
+   * @param factory The function building one pipeline instance.
+   * @param parseMask Parser option, see MafParser.
+   * @param checkSize Parser option, see MafParser.
+   * @param dotOption Parser option, see MafParser.
+   */
+  ShardedMafPipelineRunner(
+      PipelineFactory factory,
+      bool parseMask = false,
+      bool checkSize = true,
+      short dotOption = MafParser::DOT_ERROR) :
+    factory_(factory),
+    shards_(),
+    outputs_(),
+    tmpDirectory_(),
+    parseMask_(parseMask),
+    checkSequenceSize_(checkSize),
+    dotOption_(dotOption),
+    verbose_(true)
+  {}
+
+  virtual ~ShardedMafPipelineRunner() {}
+
+public:
+  /**
+   * @brief Add a shard made of a complete maf file.
+   *
+   * @param name The name of the shard, typically the reference chromosome.
+   * @param mafFile Path toward the (uncompressed) maf file.
+   */
+  void addShard(const std::string& name, const std::string& mafFile);
+
+  /**
+   * @brief Create one shard per reference chromosome found in a maf file.
+   *
+   * The file is scanned once in order to record the byte ranges of the blocks corresponding to each chromosome of the reference species.
+   * Each shard only parses its own ranges, so the file is best sorted by reference chromosome, although this is not mandatory.
+   * Blocks without a reference sequence are not assigned to any shard. Shards are created in order of first appearance in the file.
+   *
+   * @param mafFile Path toward the (uncompressed) maf file.
+   * @param refSpecies The reference species.
+   */
+  void addShardsFromIndexedFile(const std::string& mafFile, const std::string& refSpecies);
+
+  /**
+   * @brief Sort shards according to their names, using compareChromosomeNames().
+   */
+  void sortShards();
+
+  size_t getNumberOfShards() const { return shards_.size(); }
+
+  std::vector<std::string> getShardNames() const;
+
+  /**
+   * @brief Declare a new output.
+   *
+   * @param name The name of the output, used as a key for the factory.
+   * @param destination The stream where all shards will be concatenated.
+   * @param nbHeaderLines The number of header lines written at the beginning of each shard. These lines are only kept for the first shard.
+   * @param headerPrefix If not empty, leading lines starting with this prefix (after the nbHeaderLines first ones) are also considered as header lines.
+   */
+  void addOutput(
+      const std::string& name,
+      std::shared_ptr<std::ostream> destination,
+      size_t nbHeaderLines = 0,
+      const std::string& headerPrefix = "");
+
+  /**
+   * @param dir Directory where temporary files are created. The system temporary directory is used if empty.
+   */
+  void setTemporaryDirectory(const std::string& dir) { tmpDirectory_ = dir; }
+
+  bool isVerbose() const { return verbose_; }
+  void setVerbose(bool yn) { verbose_ = yn; }
+
+  /**
+   * @brief Run the pipeline on all shards, then merge the outputs.
+   *
+   * @param nbThreads Number of threads to use. If 0, the number of hardware threads is used.
+   * @param sorted If true, shards are first sorted by name (see sortShards()), so that outputs are concatenated
+   * in the natural order of chromosomes. Otherwise, outputs are concatenated in the order shards were added.
+   * @throw Exception The first error that occurred in any of the shards. Outputs are not merged in this case.
+   */
+  void run(unsigned int nbThreads = 0, bool sorted = true);
+
+  /**
+   * @brief Natural ordering of chromosome names.
+   *
+   * Numeric parts are compared by value, so that chr2 comes before chr10.
+   *
+   * @return True if a comes before b.
+   */
+  static bool compareChromosomeNames(const std::string& a, const std::string& b);
+
+private:
+  void runShard_(const Shard_& shard, const std::map<std::string, std::string>& outputFiles);
+  void mergeOutput_(const Output_& output, const std::vector<std::string>& files);
+};
+} // end of namespace bpp.
+
+#endif // _SHARDEDMAFPIPELINERUNNER_H_
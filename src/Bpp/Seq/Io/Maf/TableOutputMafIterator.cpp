@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "TableOutputMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
 
 // From bpp-core:
 #include <Bpp/Text/TextTools.h>
@@ -41,9 +43,13 @@ void TableOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& bloc
         seqs.push_back("");
       }
     }
+    // Columns excluded by a cleaning filter in annotate-only mode are skipped:
+    const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
     // Loop over all alignment columns:
     for (size_t i = 0; i < block.getNumberOfSites(); ++i)
     {
+      if (mask && mask->isExcluded(i))
+        continue;
       string pos = TextTools::toString(walker->getSequencePosition(i));
       *output_ << chr << "\t" << pos;
       for (const string& seq : seqs)
@@ -66,3 +72,13 @@ void TableOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& bloc
      }
   }
 }
+
+void TableOutputMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+}
+
+void TableOutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+}
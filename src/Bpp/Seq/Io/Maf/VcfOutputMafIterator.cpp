@@ -3,12 +3,14 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "VcfOutputMafIterator.h"
+#include "MafBlockSerializer.h"
+#include "MafColumnMask.h"
+#include "MafColumnView.h"
 
 // From bpp-seq:
 #include <Bpp/Seq/SequenceWithAnnotationTools.h>
 #include <Bpp/Seq/SequenceWithQuality.h>
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
-#include <Bpp/Seq/SiteTools.h>
 #include <Bpp/Seq/SequenceWalker.h>
 
 using namespace bpp;
@@ -16,6 +18,7 @@ using namespace bpp;
 // From the STL:
 #include <string>
 #include <numeric>
+#include <algorithm>
 #include <ctime>
 
 using namespace std;
@@ -72,17 +75,24 @@ void VcfOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block)
     }
     // Where to store genotype information, if any:
     vector<int> gt(genotypes_.size());
+    // Columns are read in place, without building Site objects:
+    MafColumnCursor cursor(block);
+    // Columns excluded by a cleaning filter in annotate-only mode are skipped:
+    const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
     // Now we look all sites for SNPs:
     for (size_t i = 0; i < block.getNumberOfSites(); ++i)
     {
       if (refSeq[i] == gap) // TODO: call indels
         continue;
+      if (mask && mask->isExcluded(i))
+        continue;
+      cursor.moveTo(i);
       string filter = "";
-      if (!gapAsDeletion_ && SiteTools::hasGap(block.site(i)))
+      if (!gapAsDeletion_ && cursor.hasGap())
       {
         filter = "gap";
       }
-      if (SymbolListTools::hasUnresolved(block.site(i)))
+      if (cursor.hasUnresolved())
       {
         if (filter != "")
           filter += ";";
@@ -91,8 +101,7 @@ void VcfOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block)
       if (filter == "")
         filter = "PASS";
 
-      map<int, size_t> counts;
-      SiteTools::getCounts(block.site(i), counts);
+      const MafNucleotideCounts& counts = cursor.getCounts();
       int ref = refSeq[i];
       string alt = "";
       string ac = "";
@@ -103,7 +112,7 @@ void VcfOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block)
       {
         if (x != ref)
         { 
-          size_t f = counts[x];
+          size_t f = (x == -1 ? counts.getNumberOfGaps() : counts.getCount(static_cast<size_t>(x)));
           if (f > 0)
           {
             if (alt != "")
@@ -123,7 +132,11 @@ void VcfOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block)
       }
       if (ac == "" && outputAll_)
       {
-        ac = TextTools::toString(counts[ref]);
+        // Unresolved states are not counted separately by the cursor:
+        size_t f = ref < 4 ?
+                   counts.getCount(static_cast<size_t>(ref)) :
+                   static_cast<size_t>(count(cursor.column(), cursor.column() + cursor.getNumberOfRows(), ref));
+        ac = TextTools::toString(f);
       }
       if (ac != "")
       {
@@ -172,3 +185,13 @@ void VcfOutputMafIterator::writeBlock_(std::ostream& out, const MafBlock& block)
     }
   }
 }
+
+void VcfOutputMafIterator::saveState_(ostream& out)
+{
+  saveOutputPosition_(out, output_.get());
+}
+
+void VcfOutputMafIterator::restoreState_(istream& in)
+{
+  restoreOutputPosition_(in, output_.get());
+}
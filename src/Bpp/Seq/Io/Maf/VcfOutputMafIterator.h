@@ -114,6 +114,10 @@ public:
 private:
   void writeHeader_(std::ostream& out) const;
   void writeBlock_(std::ostream& out, const MafBlock& block) const;
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
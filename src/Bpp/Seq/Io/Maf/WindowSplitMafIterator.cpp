@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "WindowSplitMafIterator.h"
+#include "MafBlockSerializer.h"
 
 using namespace bpp;
 
@@ -19,62 +20,110 @@ const short WindowSplitMafIterator::ADJUST = 3;
 
 unique_ptr<MafBlock> WindowSplitMafIterator::analyseCurrentBlock_()
 {
-  // Note 02/08/21: For now overlapping windows are only supported with the RAGGED_LEFT option. It could be easily generalized for cases where the window size is a multiple of the step value. More general cases are more tricky to implement, in particular for the ADJUST case.
-  while (blockBuffer_.size() == 0)
+  while (currentWindow_ >= nbWindows_)
   {
     // Build a new series of windows:
-    auto block = iterator_->nextBlock();
-    if (!block)
-      return 0; // No more block.
+    block_ = iterator_->nextBlock();
+    if (!block_)
+      return nullptr; // No more block.
+    computeWindows_();
+    if (nbWindows_ == 0 && align_ == ADJUST && keepSmallBlocks_)
+      return std::move(block_);
+  }
+  return extractWindow_();
+}
 
-    size_t pos = 0;
-    size_t size = windowSize_;
-    size_t bSize = block->getNumberOfSites();
+void WindowSplitMafIterator::computeWindows_()
+{
+  size_t bSize = block_->getNumberOfSites();
+  currentWindow_ = 0;
+  firstPos_ = 0;
+  size_ = windowSize_;
+  step_ = windowStep_;
+  nbWindows_ = bSize < windowSize_ ? 0 : (bSize - windowSize_) / windowStep_ + 1;
+  if (nbWindows_ == 0)
+    return;
+  // Number of columns covered by the windows:
+  size_t span = (nbWindows_ - 1) * windowStep_ + windowSize_;
+  switch (align_)
+  {
+  case (RAGGED_RIGHT): { firstPos_ = bSize - span; break; }
+  case (CENTER): { firstPos_ = (bSize - span) / 2; break; }
+  case (ADJUST): {
+    // Windows are enlarged proportionally, the last one being further adjusted because of rounding:
+    size_ = windowSize_ * bSize / span;
+    step_ = windowStep_ * bSize / span;
+    break;
+  }
+  default: { }
+  }
 
-    switch (align_)
-    {
-    case (RAGGED_RIGHT): { pos = bSize % windowSize_; windowStep_ = size; break; }
-    case (CENTER): { pos = (bSize % windowSize_) / 2; windowStep_ = size; break; }
-    case (ADJUST): {
-      size_t x = bSize / windowSize_;
-      if (x > 0)
-        size = bSize / x;
-      windowStep_ = size;
-      break;
-    }
-    default: { }
-    }
-    // cout << "Effective size: " << size << endl;
-    for (size_t i = pos; i + size <= bSize; i += windowStep_)
+  // Genomic positions are updated incrementally from one window to the next:
+  offsetPos_ = 0;
+  offsets_.resize(block_->getNumberOfSequences());
+  for (size_t j = 0; j < offsets_.size(); ++j)
+  {
+    const MafSequence& seq = block_->sequence(j);
+    offsets_[j] = seq.hasCoordinates() ? seq.start() : 0;
+  }
+}
+
+unique_ptr<MafBlock> WindowSplitMafIterator::extractWindow_()
+{
+  size_t bSize = block_->getNumberOfSites();
+  size_t pos = firstPos_ + currentWindow_ * step_;
+  size_t size = size_;
+  if (align_ == ADJUST && currentWindow_ + 1 == nbWindows_)
+    size = bSize - pos;
+
+  auto newBlock = make_unique<MafBlock>();
+  newBlock->setScore(block_->getScore());
+  newBlock->setPass(block_->getPass());
+  for (size_t j = 0; j < block_->getNumberOfSequences(); ++j)
+  {
+    const MafSequence& seq = block_->sequence(j);
+    if (seq.hasCoordinates())
     {
-      auto newBlock = make_unique<MafBlock>();
-      newBlock->setScore(block->getScore());
-      newBlock->setPass(block->getPass());
-      if (align_ == ADJUST)
-      {
-        if (bSize - (i + size) > 0 && bSize - (i + size) < size)
-        {
-          // cout << "Old size: " << size;
-          size = bSize - i; // Adjust for last block because of rounding.
-                            // this should not increase size by more than 1!
-          // cout << " => new size: " << size << endl;
-        }
-      }
-      for (size_t j = 0; j < block->getNumberOfSequences(); ++j)
+      const vector<int>& content = seq.getContent();
+      for (size_t i = offsetPos_; i < pos; ++i)
       {
-        auto subseq = block->sequence(j).subSequence(i, size);
-        newBlock->addSequence(subseq);
+        if (!seq.getAlphabet()->isGap(content[i]))
+          offsets_[j]++;
       }
-      blockBuffer_.push_back(std::move(newBlock));
     }
+    auto subseq = seq.subSequence(pos, size, offsets_[j]);
+    newBlock->addSequence(subseq);
+  }
+  offsetPos_ = pos;
+  MafColumnMask::setSubMask(*newBlock, *block_, pos, pos + size);
 
-    if (align_ == ADJUST && keepSmallBlocks_ && bSize < windowSize_)
-    {
-      blockBuffer_.push_back(std::move(block));
-    }
+  if (++currentWindow_ == nbWindows_)
+    block_.reset(); // All windows were extracted.
+  return newBlock;
+}
+
+void WindowSplitMafIterator::saveState_(ostream& out)
+{
+  MafBlockSerializer::writeSize(out, block_ ? 1 : 0);
+  if (block_)
+  {
+    MafBlockSerializer::write(out, *block_);
+    MafBlockSerializer::writeSize(out, currentWindow_);
   }
+}
 
-  auto nxtBlock = std::move(blockBuffer_.front());
-  blockBuffer_.pop_front();
-  return nxtBlock;
+void WindowSplitMafIterator::restoreState_(istream& in)
+{
+  block_.reset();
+  nbWindows_ = 0;
+  currentWindow_ = 0;
+  if (MafBlockSerializer::readSize(in) == 1)
+  {
+    block_ = MafBlockSerializer::read(in);
+    computeWindows_();
+    size_t current = MafBlockSerializer::readSize(in);
+    if (current >= nbWindows_)
+      throw IOException("WindowSplitMafIterator::restoreState_. Invalid window index in checkpoint.");
+    currentWindow_ = current;
+  }
 }
@@ -6,16 +6,29 @@
 #define _WINDOWSPLITMAFITERATOR_H_
 
 #include "AbstractMafIterator.h"
+#include "MafColumnMask.h"
 
 // From the STL:
 #include <iostream>
 #include <string>
-#include <deque>
+#include <vector>
+#include <memory>
 
 namespace bpp
 {
 /**
  * @brief Splits block into windows of given sizes.
+ *
+ * Windows of windowSize columns are taken every windowStep columns, windows overlapping when the step is smaller than the size.
+ * The option specifies how the windows are positioned when they do not cover the block exactly:
+ * - RAGGED_LEFT: windows start at the beginning of the block, and the remaining columns at the end are discarded,
+ * - RAGGED_RIGHT: windows end at the end of the block, and the remaining columns at the beginning are discarded,
+ * - CENTER: remaining columns are discarded equally on both sides,
+ * - ADJUST: window size and step are enlarged so that windows cover the whole block, the last window absorbing rounding errors.
+ *   Blocks smaller than the window size are discarded, unless keepSmallBlocks is set to true.
+ *
+ * Windows are extracted one at a time from the block being split, only when requested,
+ * so that memory usage does not depend on the number of windows, even for heavily overlapping windows.
  */
 class WindowSplitMafIterator :
   public AbstractFilterMafIterator
@@ -24,8 +37,15 @@ private:
   size_t windowSize_;
   size_t windowStep_;
   short align_;
-  std::deque<std::unique_ptr<MafBlock>> blockBuffer_;
   bool keepSmallBlocks_;
+  std::unique_ptr<MafBlock> block_;
+  size_t nbWindows_;
+  size_t currentWindow_;
+  size_t firstPos_;
+  size_t size_;
+  size_t step_;
+  size_t offsetPos_;
+  std::vector<size_t> offsets_;
 
 public:
   static const short RAGGED_LEFT;
@@ -44,18 +64,41 @@ public:
     windowSize_(windowSize),
     windowStep_(windowStep),
     align_(splitOption),
-    blockBuffer_(),
-    keepSmallBlocks_(keepSmallBlocks)
+    keepSmallBlocks_(keepSmallBlocks),
+    block_(),
+    nbWindows_(0),
+    currentWindow_(0),
+    firstPos_(0),
+    size_(0),
+    step_(0),
+    offsetPos_(0),
+    offsets_()
   {
     if (splitOption != RAGGED_LEFT && splitOption != RAGGED_RIGHT
         && splitOption != CENTER && splitOption != ADJUST)
       throw Exception("WindowSplitMafIterator: invalid split option: " + TextTools::toString(splitOption));
-    if (splitOption != RAGGED_LEFT && windowStep != windowSize)
-      throw Exception("WindowSplitMafIterator: overlapping windows are only supported together with the RAGGED_LEFT option.");
+    if (windowSize == 0)
+      throw Exception("WindowSplitMafIterator: window size should be at least 1.");
+    if (windowStep == 0)
+      throw Exception("WindowSplitMafIterator: window step should be at least 1.");
   }
 
 private:
   std::unique_ptr<MafBlock> analyseCurrentBlock_();
+
+  /**
+   * @brief Compute the position and size of the windows for the current block.
+   */
+  void computeWindows_();
+
+  /**
+   * @return The next window of the current block.
+   */
+  std::unique_ptr<MafBlock> extractWindow_();
+
+protected:
+  void saveState_(std::ostream& out);
+  void restoreState_(std::istream& in);
 };
 } // end of namespace bpp.
 
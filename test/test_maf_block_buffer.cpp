@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Io/Maf/MafBlockBuffer.h>
+
+#include <iostream>
+#include <memory>
+
+using namespace bpp;
+using namespace std;
+
+/**
+ * @brief A block property that cannot be serialized, so that blocks carrying it are never written to disk.
+ */
+class UnknownProperty :
+  public virtual Clonable
+{
+public:
+  UnknownProperty* clone() const { return new UnknownProperty(*this); }
+};
+
+static unique_ptr<MafBlock> makeBlock(unsigned int index, bool pinned)
+{
+  auto block = make_unique<MafBlock>();
+  block->setPass(index);
+  auto seq1 = make_unique<MafSequence>("hg.chr1", "ACGTACGTAC", 10 * index, '+', 1000);
+  auto seq2 = make_unique<MafSequence>("mm.chr1", "ACGTTCGTAC", 10 * index, '+', 1000);
+  block->addSequence(seq1);
+  block->addSequence(seq2);
+  if (pinned)
+    block->setProperty("Unknown", make_unique<UnknownProperty>());
+  return block;
+}
+
+int main()
+{
+  try
+  {
+    // Room for two blocks in memory, further blocks are written to disk unless they cannot be serialized:
+    size_t blockSize = MafBlockBuffer::estimateMemoryUsage(*makeBlock(0, false));
+    MafBlockBuffer buffer(2 * blockSize);
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+      buffer.push_back(makeBlock(i, i == 1 || i == 3 || i == 5));
+    }
+    if (buffer.size() != 8 || buffer.getNumberOfSpilledBlocks() != 4)
+    {
+      cerr << "Expected 8 blocks with 4 on disk, found " << buffer.size() << " with " << buffer.getNumberOfSpilledBlocks() << " on disk." << endl;
+      return 1;
+    }
+
+    // Blocks come back in insertion order, including pinned ones, while new blocks are added:
+    unsigned int expected = 0;
+    while (!buffer.empty())
+    {
+      auto block = std::move(buffer.front());
+      buffer.pop_front();
+      bool pinned = (expected == 1 || expected == 3 || expected == 5 || expected == 9);
+      if (block->getPass() != expected || block->hasProperty("Unknown") != pinned)
+      {
+        cerr << "Expected block " << expected << (pinned ? " (pinned)" : "") << ", found block " << block->getPass() << "." << endl;
+        return 1;
+      }
+      if (block->sequence(1).toString() != "ACGTTCGTAC" || block->sequence(1).start() != 10 * expected)
+      {
+        cerr << "Block " << expected << " was not reloaded identically." << endl;
+        return 1;
+      }
+      if (expected == 2)
+      {
+        buffer.push_back(makeBlock(8, false));
+        buffer.push_back(makeBlock(9, true));
+      }
+      expected++;
+    }
+    if (expected != 10)
+    {
+      cerr << "Expected 10 blocks, found " << expected << "." << endl;
+      return 1;
+    }
+    return 0;
+  }
+  catch (exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
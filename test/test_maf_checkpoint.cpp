@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Io/Maf/MafParser.h>
+#include <Bpp/Seq/Io/Maf/WindowSplitMafIterator.h>
+#include <Bpp/Seq/Io/Maf/OutputMafIterator.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+using namespace bpp;
+using namespace std;
+
+/**
+ * @brief Build a parser + window splitter + writer pipeline.
+ */
+static shared_ptr<MafIteratorInterface> makePipeline(const string& mafFile, shared_ptr<ostream> output)
+{
+  auto input = make_shared<ifstream>(mafFile.c_str(), ios::in | ios::binary);
+  auto parser = make_shared<MafParser>(input);
+  auto splitter = make_shared<WindowSplitMafIterator>(parser, 4, 4, WindowSplitMafIterator::RAGGED_LEFT);
+  auto pipeline = make_shared<OutputMafIterator>(splitter, output);
+  parser->setVerbose(false);
+  splitter->setVerbose(false);
+  pipeline->setVerbose(false);
+  return pipeline;
+}
+
+static string readFile(const string& path)
+{
+  ifstream in(path.c_str(), ios::in | ios::binary);
+  stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+int main()
+{
+  try
+  {
+    filesystem::path dir = filesystem::temp_directory_path();
+    string mafFile = (dir / "test_maf_checkpoint.maf").string();
+    string refFile = (dir / "test_maf_checkpoint_ref.maf").string();
+    string outFile = (dir / "test_maf_checkpoint_out.maf").string();
+    {
+      ofstream maf(mafFile.c_str(), ios::out);
+      maf << "##maf version=1" << endl << endl;
+      for (unsigned int i = 0; i < 5; ++i)
+      {
+        maf << "a score=" << i << endl;
+        maf << "s hg.chr1 " << 100 * i << " 10 + 1000 ACGTACGTAC" << endl;
+        maf << "s mm.chr1 " << 100 * i << " 9 + 1000 ACGTTCG-AC" << endl << endl;
+      }
+    }
+
+    // Uninterrupted run:
+    {
+      auto output = make_shared<ofstream>(refFile.c_str(), ios::out | ios::binary);
+      auto pipeline = makePipeline(mafFile, output);
+      while (pipeline->nextBlock())
+      {}
+    }
+
+    // Interrupted run: the checkpoint is taken in the middle of a block being split,
+    // and more blocks are written before the interruption:
+    stringstream checkpoint;
+    {
+      auto output = make_shared<ofstream>(outFile.c_str(), ios::out | ios::binary);
+      auto pipeline = makePipeline(mafFile, output);
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        pipeline->nextBlock();
+      }
+      pipeline->saveCheckpoint(checkpoint);
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        pipeline->nextBlock();
+      }
+    }
+
+    // Resumed run, the output file being opened for update:
+    {
+      auto output = make_shared<fstream>(outFile.c_str(), ios::in | ios::out | ios::binary);
+      auto pipeline = makePipeline(mafFile, output);
+      pipeline->restoreCheckpoint(checkpoint);
+      unsigned int nbBlocks = 0;
+      while (pipeline->nextBlock())
+      {
+        nbBlocks++;
+      }
+      // Each input block is split into two windows, three of which were output before the checkpoint:
+      if (nbBlocks != 7)
+      {
+        cerr << "Resumed run output " << nbBlocks << " blocks, 7 were expected." << endl;
+        return 1;
+      }
+    }
+
+    string reference = readFile(refFile);
+    string resumed = readFile(outFile);
+    filesystem::remove(mafFile);
+    filesystem::remove(refFile);
+    filesystem::remove(outFile);
+    if (reference.find("s hg.chr1 404 ") == string::npos)
+    {
+      cerr << "Unexpected output:" << endl << reference << endl;
+      return 1;
+    }
+    if (resumed != reference)
+    {
+      cerr << "Resumed output differs from uninterrupted output:" << endl << reference << endl << "---" << endl << resumed << endl;
+      return 1;
+    }
+    return 0;
+  }
+  catch (exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Io/Maf/MafColumnMask.h>
+#include <Bpp/Seq/Io/Maf/ConcatenateMafIterator.h>
+#include <Bpp/Seq/Io/Maf/FullGapFilterMafIterator.h>
+
+#include <iostream>
+#include <deque>
+#include <memory>
+
+using namespace bpp;
+using namespace std;
+
+/**
+ * @brief Iterate over blocks held in memory.
+ */
+class BlockListMafIterator :
+  public AbstractMafIterator
+{
+private:
+  std::deque<std::unique_ptr<MafBlock>> blocks_;
+
+public:
+  BlockListMafIterator() : blocks_() {}
+
+  void addBlock(std::unique_ptr<MafBlock> block) { blocks_.push_back(std::move(block)); }
+
+private:
+  std::unique_ptr<MafBlock> analyseCurrentBlock_()
+  {
+    if (blocks_.empty())
+      return nullptr;
+    auto block = std::move(blocks_.front());
+    blocks_.pop_front();
+    return block;
+  }
+};
+
+static unique_ptr<MafBlock> makeBlock(const string& content1, const string& content2, size_t start, const vector<size_t>& excluded)
+{
+  auto block = make_unique<MafBlock>();
+  auto seq1 = make_unique<MafSequence>("hg.chr1", content1, start, '+', 1000);
+  auto seq2 = make_unique<MafSequence>("mm.chr1", content2, start, '+', 1000);
+  block->addSequence(seq1);
+  block->addSequence(seq2);
+  if (!excluded.empty())
+    MafColumnMask::excludeRegions(*block, excluded);
+  return block;
+}
+
+static bool checkMask(const MafBlock& block, const string& expected, const string& test)
+{
+  const MafColumnMask* mask = MafColumnMask::getColumnMask(block);
+  string observed;
+  for (size_t i = 0; i < static_cast<size_t>(block.getNumberOfSites()); ++i)
+  {
+    observed += (mask && mask->isExcluded(i)) ? 'x' : '.';
+  }
+  if (observed != expected)
+  {
+    cerr << test << ": expected mask " << expected << ", found " << observed << "." << endl;
+    return false;
+  }
+  return true;
+}
+
+int main()
+{
+  try
+  {
+    // Concatenated blocks keep their excluded columns, blocks without mask having all columns kept:
+    auto input = make_shared<BlockListMafIterator>();
+    input->addBlock(makeBlock("ACGTACGTAC", "ACGTACGTAC", 0, {1, 3}));
+    input->addBlock(makeBlock("TTTTTT", "TTTTTT", 10, {0, 1}));
+    input->addBlock(makeBlock("GGGG", "GGGG", 16, {}));
+    ConcatenateMafIterator concatenate(input, 100);
+    auto block = concatenate.nextBlock();
+    if (!checkMask(*block, ".xx.......x.........", "Concatenate"))
+      return 1;
+
+    // Removed columns are removed from the mask too:
+    input = make_shared<BlockListMafIterator>();
+    input->addBlock(makeBlock("AC--GTAC", "AC--GTAC", 0, {5, 7}));
+    FullGapFilterMafIterator fullGapFilter(input, {"hg", "mm"});
+    fullGapFilter.setVerbose(false);
+    block = fullGapFilter.nextBlock();
+    if (!checkMask(*block, "...xx.", "FullGapFilter"))
+      return 1;
+
+    // Regions keep the corresponding part of the mask:
+    auto region = make_unique<MafBlock>();
+    for (size_t j = 0; j < block->getNumberOfSequences(); ++j)
+    {
+      auto subseq = block->sequence(j).subSequence(2, 3);
+      region->addSequence(subseq);
+    }
+    MafColumnMask::setSubMask(*region, *block, 2, 5);
+    if (!checkMask(*region, ".xx", "setSubMask"))
+      return 1;
+
+    // Columns removed without updating the mask are detected:
+    block->deleteSites(0, 1);
+    try
+    {
+      MafColumnMask::getColumnMask(*block);
+      cerr << "A column mask not matching the size of the block was not detected." << endl;
+      return 1;
+    }
+    catch (Exception& ex) {}
+    return 0;
+  }
+  catch (exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Io/Maf/MafBlockSerializer.h>
+#include <Bpp/Seq/Io/Maf/MafColumnMask.h>
+
+#include <iostream>
+#include <sstream>
+#include <memory>
+
+using namespace bpp;
+using namespace std;
+
+static unique_ptr<MafBlock> makeBlock(size_t nbSites)
+{
+  auto block = make_unique<MafBlock>();
+  block->setScore(12.5);
+  block->setPass(2);
+  string content1, content2;
+  for (size_t i = 0; i < nbSites; ++i)
+  {
+    content1 += "ACGT"[i % 4];
+    content2 += (i % 7 == 0 ? '-' : "TGCA"[i % 4]);
+  }
+  auto seq1 = make_unique<MafSequence>("hg.chr1", content1, 100, '+', 1000);
+  auto seq2 = make_unique<MafSequence>("mm.chr7", content2, 200, '-', 2000);
+  block->addSequence(seq1);
+  block->addSequence(seq2);
+  return block;
+}
+
+static bool sameBlocks(const MafBlock& block1, const MafBlock& block2)
+{
+  if (block1.getScore() != block2.getScore() || block1.getPass() != block2.getPass())
+    return false;
+  if (block1.getNumberOfSequences() != block2.getNumberOfSequences())
+    return false;
+  for (size_t i = 0; i < block1.getNumberOfSequences(); ++i)
+  {
+    const MafSequence& seq1 = block1.sequence(i);
+    const MafSequence& seq2 = block2.sequence(i);
+    if (seq1.getName() != seq2.getName() || seq1.toString() != seq2.toString()
+        || seq1.start() != seq2.start() || seq1.getStrand() != seq2.getStrand() || seq1.getSrcSize() != seq2.getSrcSize())
+      return false;
+  }
+  const MafColumnMask* mask1 = MafColumnMask::getColumnMask(block1);
+  const MafColumnMask* mask2 = MafColumnMask::getColumnMask(block2);
+  if (!mask1 || !mask2)
+    return !mask1 && !mask2;
+  if (mask1->getNumberOfColumns() != mask2->getNumberOfColumns())
+    return false;
+  for (size_t i = 0; i < mask1->getNumberOfColumns(); ++i)
+  {
+    if (mask1->isExcluded(i) != mask2->isExcluded(i))
+      return false;
+  }
+  return true;
+}
+
+int main()
+{
+  try
+  {
+    // A block without column mask, and blocks annotated by a filter, with masks spanning several words:
+    vector<unique_ptr<MafBlock>> blocks;
+    blocks.push_back(makeBlock(10));
+    blocks.push_back(makeBlock(70));
+    MafColumnMask::excludeRegions(*blocks.back(), {0, 3, 60, 66});
+    blocks.push_back(makeBlock(128));
+    MafColumnMask::excludeRegions(*blocks.back(), {63, 65, 127, 128});
+
+    stringstream buffer;
+    for (const auto& block : blocks)
+    {
+      if (!MafBlockSerializer::isSerializable(*block))
+      {
+        cerr << "Block " << block->getDescription() << " should be serializable." << endl;
+        return 1;
+      }
+      MafBlockSerializer::write(buffer, *block);
+    }
+    for (const auto& block : blocks)
+    {
+      auto copy = MafBlockSerializer::read(buffer);
+      if (!sameBlocks(*block, *copy))
+      {
+        cerr << "Block " << block->getDescription() << " was not read back identically." << endl;
+        return 1;
+      }
+    }
+    return 0;
+  }
+  catch (exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Io/Maf/ShardedMafPipelineRunner.h>
+#include <Bpp/Seq/Io/Maf/OutputMafIterator.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+using namespace bpp;
+using namespace std;
+
+int main()
+{
+  try
+  {
+    // Blocks are separated by several blank lines, and the last block of each chromosome is followed by a comment.
+    // Chromosomes are not in natural order in the file:
+    string mafFile = (filesystem::temp_directory_path() / "test_maf_shards.maf").string();
+    {
+      ofstream maf(mafFile.c_str(), ios::out);
+      maf << "##maf version=1" << endl << endl;
+      maf << "a score=0" << endl;
+      maf << "s hg.chr10 0 4 + 100 ACGT" << endl;
+      maf << "s mm.chr2 0 4 + 100 ACGA" << endl << endl;
+      maf << "a score=1" << endl;
+      maf << "s hg.chr1 0 4 + 100 ACGT" << endl;
+      maf << "s mm.chr5 0 4 + 100 ACGA" << endl << endl << endl << endl;
+      maf << "a score=2" << endl;
+      maf << "s hg.chr1 10 4 + 100 ACGT" << endl;
+      maf << "s mm.chr5 10 4 + 100 ACCT" << endl << endl << endl;
+      maf << "# End of chr1" << endl << endl;
+      maf << "a score=3" << endl;
+      maf << "s hg.chr2 0 4 + 100 TTGT" << endl;
+      maf << "s mm.chr7 0 4 + 100 TTGA" << endl << endl << endl;
+      maf << "a score=4" << endl;
+      maf << "s hg.chr3 0 4 + 100 GGGT" << endl;
+      maf << "s mm.chr1 0 4 + 100 GGGA" << endl;
+    }
+
+    auto output = make_shared<ostringstream>();
+    ShardedMafPipelineRunner runner(
+        [](shared_ptr<MafIteratorInterface> input, const string& shardName, const map<string, string>& outputFiles)
+        {
+          auto out = make_shared<ofstream>(outputFiles.at("maf").c_str(), ios::out);
+          return make_shared<OutputMafIterator>(input, out);
+        });
+    runner.setVerbose(false);
+    runner.addShardsFromIndexedFile(mafFile, "hg");
+    runner.addOutput("maf", output, 0, "#");
+    runner.run(2);
+    filesystem::remove(mafFile);
+
+    if (runner.getNumberOfShards() != 4)
+    {
+      cerr << "Expected 4 shards, found " << runner.getNumberOfShards() << "." << endl;
+      return 1;
+    }
+    // Each block should be output exactly once:
+    istringstream result(output->str());
+    string line;
+    map<string, size_t> counts;
+    vector<string> order;
+    while (getline(result, line))
+    {
+      if (line.size() > 2 && line[0] == 's' && line.substr(2, 3) == "hg.")
+      {
+        string chr = line.substr(2, line.find(' ', 2) - 2);
+        if (counts[chr]++ == 0)
+          order.push_back(chr);
+      }
+    }
+    if (counts["hg.chr1"] != 2 || counts["hg.chr2"] != 1 || counts["hg.chr3"] != 1 || counts["hg.chr10"] != 1)
+    {
+      cerr << "Blocks were duplicated or lost between shards:" << endl << output->str() << endl;
+      return 1;
+    }
+    // Outputs are concatenated in the natural order of chromosomes:
+    if (order != vector<string>({"hg.chr1", "hg.chr2", "hg.chr3", "hg.chr10"}))
+    {
+      cerr << "Shards were not output in chromosome order:" << endl << output->str() << endl;
+      return 1;
+    }
+    return 0;
+  }
+  catch (exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
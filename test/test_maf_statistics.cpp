@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Io/Maf/MafStatistics.h>
+#include <Bpp/Seq/Io/Maf/MafColumnMask.h>
+
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <cmath>
+
+using namespace bpp;
+using namespace std;
+
+static unique_ptr<MafBlock> makeBlock()
+{
+  auto block = make_unique<MafBlock>();
+  auto hg = make_unique<MafSequence>("hg.chr1", "ACGTACGTACGT", 0, '+', 1000);
+  auto pt = make_unique<MafSequence>("pt.chr1", "ACGTACGAACGT", 0, '+', 1000);
+  auto gg = make_unique<MafSequence>("gg.chr1", "ACCTACGAAC-T", 0, '+', 1000);
+  auto mm = make_unique<MafSequence>("mm.chr1", "TCGTACGTNCGA", 0, '+', 1000);
+  block->addSequence(hg);
+  block->addSequence(pt);
+  block->addSequence(gg);
+  block->addSequence(mm);
+  return block;
+}
+
+/**
+ * @return One instance of each statistic, with species selections shared or not between statistics.
+ */
+static vector<shared_ptr<MafStatisticsInterface>> makeStatistics()
+{
+  vector<string> all = {"hg", "pt", "gg", "mm"};
+  vector<shared_ptr<MafStatisticsInterface>> statistics;
+  statistics.push_back(make_shared<CharacterCountsMafStatistics>(AlphabetTools::DNA_ALPHABET, vector<string>(), "All"));
+  statistics.push_back(make_shared<SiteFrequencySpectrumMafStatistics>(AlphabetTools::DNA_ALPHABET, vector<double>({-0.5, 0.5, 1.5, 2.5, 3.5}), vector<string>({"hg", "pt", "gg"}), "mm"));
+  statistics.push_back(make_shared<FourSpeciesPatternCountsMafStatistics>(AlphabetTools::DNA_ALPHABET, all));
+  statistics.push_back(make_shared<SiteMafStatistics>(all));
+  statistics.push_back(make_shared<PolymorphismMafStatistics>(vector<vector<string>>({{"hg", "pt"}, {"gg", "mm"}})));
+  statistics.push_back(make_shared<SequenceDiversityMafStatistics>(all));
+  statistics.push_back(make_shared<DivergenceMatrixMafStatistics>(all));
+  statistics.push_back(make_shared<AbbaBabaMafStatistics>(vector<string>({"P1", "P2", "P3"}), vector<vector<string>>({{"hg"}, {"pt"}, {"gg"}}), vector<string>({"mm"}), 1));
+  statistics.push_back(make_shared<JointSiteFrequencySpectrumMafStatistics>(vector<string>({"A", "B"}), vector<vector<string>>({{"hg", "pt"}, {"gg"}}), vector<string>({"mm"})));
+  return statistics;
+}
+
+static bool sameValues(double x, double y)
+{
+  return (std::isnan(x) && std::isnan(y)) || abs(x - y) <= 1e-9 * max(1., abs(x));
+}
+
+static double getValue(const MafStatisticsInterface& statistic, const string& tag)
+{
+  const MafStatisticsResult& result = statistic.getResult();
+  return result.getNumericValueAt(result.getTagIndex(tag));
+}
+
+/**
+ * @brief Check that statistics computed together give the same results as statistics computed one by one.
+ */
+static bool sameResults(
+    const vector<shared_ptr<MafStatisticsInterface>>& statistics1,
+    const vector<shared_ptr<MafStatisticsInterface>>& statistics2,
+    const string& test)
+{
+  for (size_t k = 0; k < statistics1.size(); ++k)
+  {
+    for (const auto& tag : statistics1[k]->getSupportedTags())
+    {
+      double x = getValue(*statistics1[k], tag);
+      double y = getValue(*statistics2[k], tag);
+      if (!sameValues(x, y))
+      {
+        cerr << test << ": " << statistics1[k]->getShortName() << " differs for tag " << tag << ": " << x << " vs " << y << "." << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main()
+{
+  try
+  {
+    auto block = makeBlock();
+
+    // Fused computation versus separate computation of each statistic:
+    auto fused = makeStatistics();
+    MafStatisticsEngine engine(fused);
+    engine.compute(*block);
+    auto separate = makeStatistics();
+    for (auto& statistic : separate)
+    {
+      statistic->compute(*block);
+    }
+    if (!sameResults(fused, separate, "Engine"))
+      return 1;
+
+    // Masked columns are skipped in place, as if they were removed from the block:
+    MafColumnMask::excludeRegions(*block, {0, 1, 7, 8});
+    const MafColumnMask* mask = MafColumnMask::getColumnMask(*block);
+    engine.compute(*block, mask);
+    auto compacted = MafColumnMask::compact(*block, *mask);
+    for (auto& statistic : separate)
+    {
+      statistic->compute(*compacted);
+    }
+    if (!sameResults(fused, separate, "Masked engine"))
+      return 1;
+
+    // Values computed by hand on the full block:
+    block = makeBlock();
+    engine.compute(*block);
+    if (getValue(*fused[5], "NbSeggregating") != 4.)
+    {
+      cerr << "Expected 4 segregating sites, found " << getValue(*fused[5], "NbSeggregating") << "." << endl;
+      return 1;
+    }
+    // Without unresolved characters, the divergence matrix matches pairwise divergences:
+    for (const auto& pair : vector<pair<string, string>>({{"hg", "pt"}, {"hg", "gg"}, {"pt", "gg"}}))
+    {
+      PairwiseDivergenceMafStatistics divergence(pair.first, pair.second);
+      divergence.compute(*block);
+      double x = getValue(*fused[6], pair.first + "-" + pair.second);
+      double y = getValue(divergence, "Divergence");
+      if (!sameValues(x, y))
+      {
+        cerr << "Divergence between " << pair.first << " and " << pair.second << ": " << x << " in matrix vs " << y << " pairwise." << endl;
+        return 1;
+      }
+    }
+
+    // Joint spectrum, in the dadi format. Sites with an unresolved outgroup or a gap are ignored:
+    auto jointSfs = dynamic_pointer_cast<JointSiteFrequencySpectrumMafStatistics>(fused[8]);
+    jointSfs->accumulate();
+    ostringstream dadi;
+    jointSfs->writeDadiSpectrum(dadi);
+    string expected = "3 2 unfolded \"A\" \"B\"\n6 1 0 1 0 2\n1 0 0 0 0 1\n";
+    if (dadi.str() != expected)
+    {
+      cerr << "Expected dadi spectrum:" << endl << expected << "Found:" << endl << dadi.str();
+      return 1;
+    }
+    if (getValue(*jointSfs, "NbSites") != 10. || getValue(*jointSfs, "NbIgnored") != 2.)
+    {
+      cerr << "Expected 10 sites in the joint spectrum and 2 ignored." << endl;
+      return 1;
+    }
+    return 0;
+  }
+  catch (exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}